@@ -0,0 +1,315 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+  CPU placement for the simulation threads. affinity_setup groups the CPUs
+  the process may use into domains, one per (NUMA node, L3 cache) pair read
+  from /sys, so the threads of one hunt can be kept where their shared Room
+  and CaseFile lines never cross a socket. Each hunt's driving thread (the
+  main thread, or a batch worker) binds itself to a domain with
+  affinity_bind_worker; the ghost and hunter threads it starts then get
+  their CPU mask from affinity_apply.
+
+  Memory follows the threads: a bound thread prefers its domain's node for
+  new pages, which its entity threads inherit, so the House it sets up and
+  the thread stacks are first touched on the local node.
+*/
+
+#define AFFINITY_MAX_DOMAINS 64
+
+struct AffinityDomain {
+  int node;      //NUMA node, -1 if unknown
+  int cache;     //lowest CPU sharing the L3, -1 if unknown
+  cpu_set_t cpus;
+  int count;
+};
+
+static enum PinMode affinity_mode = PIN_OFF;
+static struct AffinityDomain affinity_domains[AFFINITY_MAX_DOMAINS];
+static int affinity_domain_count = 0;
+static int affinity_node_count = 0;
+
+//the calling thread's domain and its rank among the threads sharing it
+static _Thread_local int affinity_domain = -1;
+static _Thread_local int affinity_rank = 0;
+
+/*
+   Function: affinity_parse_cpus
+   Purpose:  Parses a CPU list such as "0-7,16-23".
+   Params:
+    Input: const char* text - the list
+    Output: cpu_set_t* set - the CPUs named
+   Return: bool - false on a malformed list or a CPU past CPU_SETSIZE
+*/
+static bool affinity_parse_cpus(const char* text, cpu_set_t* set){
+  CPU_ZERO(set);
+  const char* p = text;
+  while(*p != '\0'){
+    char* end = NULL;
+    long first = strtol(p, &end, 10);
+    if(end == p || first < 0){
+      return false;
+    }
+    long last = first;
+    if(*end == '-'){
+      p = end + 1;
+      last = strtol(p, &end, 10);
+      if(end == p || last < first){
+        return false;
+      }
+    }
+    if(last >= CPU_SETSIZE){
+      return false;
+    }
+    for(long cpu = first; cpu <= last; cpu++){
+      CPU_SET((int)cpu, set);
+    }
+    p = end;
+    if(*p == ','){
+      p++;
+    }else if(*p != '\0'){
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+   Function: affinity_cpu_node
+   Purpose:  Finds a CPU's NUMA node from its nodeN entry in sysfs.
+   Params:
+    Input: int cpu - the CPU
+   Return: int - the node, -1 if the kernel does not say
+*/
+static int affinity_cpu_node(int cpu){
+  char path[MAX_PATH_LENGTH];
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+  DIR* dir = opendir(path);
+  if(dir == NULL){
+    return -1;
+  }
+  int node = -1;
+  struct dirent* entry;
+  while((entry = readdir(dir)) != NULL){
+    if(strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9'){
+      node = atoi(entry->d_name + 4);
+      break;
+    }
+  }
+  closedir(dir);
+  return node;
+}
+
+/*
+   Function: affinity_read_int
+   Purpose:  Reads the leading integer of a sysfs file.
+   Params:
+    Input: const char* path - the file
+   Return: int - the value, -1 if the file is missing or does not start with one
+*/
+static int affinity_read_int(const char* path){
+  FILE* file = fopen(path, "r");
+  if(file == NULL){
+    return -1;
+  }
+  int value = -1;
+  if(fscanf(file, "%d", &value) != 1){
+    value = -1;
+  }
+  fclose(file);
+  return value;
+}
+
+/*
+   Function: affinity_cpu_cache
+   Purpose:  Names a CPU's L3 by the lowest CPU that shares it.
+   Params:
+    Input: int cpu - the CPU
+   Return: int - that CPU, -1 if there is no L3 listed
+*/
+static int affinity_cpu_cache(int cpu){
+  char path[MAX_PATH_LENGTH];
+  for(int index = 0; index < 8; index++){
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+    int level = affinity_read_int(path);
+    if(level < 0){
+      return -1;
+    }
+    if(level == 3){
+      //a shared_cpu_list starts with its lowest CPU
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+      return affinity_read_int(path);
+    }
+  }
+  return -1;
+}
+
+/*
+   Function: affinity_nth_cpu
+   Purpose:  Picks a domain's CPUs round robin.
+   Params:
+    Input: const struct AffinityDomain* domain - the domain
+    Input: int n - any index, wrapped to the domain's CPU count
+   Return: int - the CPU
+*/
+static int affinity_nth_cpu(const struct AffinityDomain* domain, int n){
+  n %= domain->count;
+  for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+    if(CPU_ISSET(cpu, &domain->cpus) && n-- == 0){
+      return cpu;
+    }
+  }
+  return 0;
+}
+
+/*
+   Function: affinity_setup
+   Purpose:  Chooses the pinning mode and groups the usable CPUs into
+   domains. Call once before any simulation thread starts.
+   Params:
+    Input: enum PinMode mode - PIN_OFF leaves every thread to the scheduler
+    Input: const char* cpus - CPU list to restrict to, empty for all allowed
+   Return: int - number of domains (1 when pinning is off), 0 if no usable CPU is left
+*/
+int affinity_setup(enum PinMode mode, const char* cpus){
+  affinity_mode = PIN_OFF;
+  affinity_domain_count = 0;
+  affinity_node_count = 0;
+  if(mode == PIN_OFF){
+    return 1;
+  }
+
+  cpu_set_t allowed;
+  if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0){
+    perror("sched_getaffinity");
+    return 0;
+  }
+  if(cpus != NULL && cpus[0] != '\0'){
+    cpu_set_t wanted;
+    if(!affinity_parse_cpus(cpus, &wanted)){
+      fprintf(stderr, "Invalid CPU list '%s'\n", cpus);
+      return 0;
+    }
+    CPU_AND(&allowed, &allowed, &wanted);
+  }
+
+  int nodes_seen[AFFINITY_MAX_DOMAINS];
+  for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+    if(!CPU_ISSET(cpu, &allowed)){
+      continue;
+    }
+    int node = affinity_cpu_node(cpu);
+    int cache = affinity_cpu_cache(cpu);
+
+    int d = 0;
+    while(d < affinity_domain_count &&
+          (affinity_domains[d].node != node || affinity_domains[d].cache != cache)){
+      d++;
+    }
+    //past the table's size, extra domains fold into the last one
+    if(d == AFFINITY_MAX_DOMAINS){
+      d--;
+    }else if(d == affinity_domain_count){
+      affinity_domains[d].node = node;
+      affinity_domains[d].cache = cache;
+      CPU_ZERO(&affinity_domains[d].cpus);
+      affinity_domains[d].count = 0;
+      affinity_domain_count++;
+
+      int n = 0;
+      while(n < affinity_node_count && nodes_seen[n] != node){
+        n++;
+      }
+      if(n == affinity_node_count){
+        nodes_seen[affinity_node_count++] = node;
+      }
+    }
+    CPU_SET(cpu, &affinity_domains[d].cpus);
+    affinity_domains[d].count++;
+  }
+
+  if(affinity_domain_count == 0){
+    fprintf(stderr, "No usable CPU in '%s'\n", cpus != NULL ? cpus : "");
+    return 0;
+  }
+  affinity_mode = mode;
+  return affinity_domain_count;
+}
+
+/*
+   Function: affinity_bind_worker
+   Purpose:  Binds the calling thread, which drives one hunt at a time, to a
+   domain: slots go round robin over the domains, so batch workers spread
+   out. In cores mode the thread takes a single CPU of its domain. With more
+   than one NUMA node, new pages are preferred from the domain's node.
+   Does nothing when pinning is off.
+   Params:
+    Input: int slot - worker index, 0 for the main thread
+   Return: void
+*/
+void affinity_bind_worker(int slot){
+  if(affinity_mode == PIN_OFF){
+    return;
+  }
+  affinity_domain = slot % affinity_domain_count;
+  affinity_rank = slot / affinity_domain_count;
+  const struct AffinityDomain* domain = &affinity_domains[affinity_domain];
+
+  cpu_set_t set;
+  if(affinity_mode == PIN_CORES){
+    CPU_ZERO(&set);
+    CPU_SET(affinity_nth_cpu(domain, affinity_rank), &set);
+  }else{
+    set = domain->cpus;
+  }
+  if(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0){
+    fprintf(stderr, "Could not pin worker %d\n", slot);
+  }
+
+  //one node means there is nothing to prefer
+  if(affinity_node_count > 1 && domain->node >= 0){
+    unsigned long nodemask[CPU_SETSIZE / (8 * sizeof(unsigned long))] = {0};
+    nodemask[domain->node / (8 * sizeof(unsigned long))] |= 1UL << (domain->node % (8 * sizeof(unsigned long)));
+    if(syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodemask, (unsigned long)CPU_SETSIZE) != 0){
+      perror("set_mempolicy");
+    }
+  }
+}
+
+/*
+   Function: affinity_apply
+   Purpose:  Sets the CPU mask of one entity thread the bound thread is about
+   to start: the whole domain in domain mode, or one CPU of it in cores mode,
+   spread so concurrent hunts in the same domain start on different CPUs.
+   Threads past the domain's CPU count wrap around. Does nothing when
+   pinning is off or the caller never bound itself.
+   Params:
+    Input/Output: pthread_attr_t* attr - attributes for the new thread
+    Input: int entity - 0 for the ghost, 1.. for the hunters
+    Input: int entities - threads in the hunt
+   Return: void
+*/
+void affinity_apply(pthread_attr_t* attr, int entity, int entities){
+  if(affinity_mode == PIN_OFF || affinity_domain < 0){
+    return;
+  }
+  const struct AffinityDomain* domain = &affinity_domains[affinity_domain];
+
+  cpu_set_t set;
+  if(affinity_mode == PIN_CORES){
+    CPU_ZERO(&set);
+    CPU_SET(affinity_nth_cpu(domain, affinity_rank * entities + entity), &set);
+  }else{
+    set = domain->cpus;
+  }
+  pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+}
@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+  Streaming batch statistics. Every finished run is folded into fixed-size
+  accumulators: Welford mean/variance and a log-linear histogram sketch for
+  quantiles, plus counters per ghost type. Nothing per run is kept, so the
+  memory is the same for a thousand runs or a billion, and two aggregates
+  (one per worker thread) merge exactly by adding their parts.
+*/
+
+/*
+   Function: welford_add
+   Purpose:  Adds one sample to a running mean and variance.
+   Params:
+    Input/Output: struct Welford* w - the accumulator
+    Input: double value - the sample
+   Return: void
+*/
+static void welford_add(struct Welford* w, double value){
+  w->count++;
+  double delta = value - w->mean;
+  w->mean += delta / (double)w->count;
+  w->m2 += delta * (value - w->mean);
+}
+
+/*
+   Function: welford_merge
+   Purpose:  Combines two accumulators (Chan et al. parallel update).
+   Params:
+    Input/Output: struct Welford* into - the accumulator to add to
+    Input: const struct Welford* from - the accumulator to add
+   Return: void
+*/
+static void welford_merge(struct Welford* into, const struct Welford* from){
+  if(from->count == 0){
+    return;
+  }
+  if(into->count == 0){
+    *into = *from;
+    return;
+  }
+  double total = (double)(into->count + from->count);
+  double delta = from->mean - into->mean;
+  into->m2 += from->m2 + delta * delta * (double)into->count * (double)from->count / total;
+  into->mean += delta * (double)from->count / total;
+  into->count += from->count;
+}
+
+static double welford_stddev(const struct Welford* w){
+  return w->count > 1 ? sqrt(w->m2 / (double)(w->count - 1)) : 0.0;
+}
+
+/*
+   Function: sketch_bucket
+   Purpose:  Maps a value to its histogram bucket. Values below 1 share
+   bucket 0; above that every power of two is split into SKETCH_SUB_BUCKETS
+   equal parts, so a bucket is never wider than 1/SKETCH_SUB_BUCKETS of its value.
+   Params:
+    Input: double value - the sample (negative values count as 0)
+   Return: int - bucket index
+*/
+static int sketch_bucket(double value){
+  if(!(value >= 1.0)){
+    return 0;
+  }
+  int exponent;
+  double fraction = frexp(value, &exponent); //value = fraction * 2^exponent, fraction in [0.5, 1)
+  int octave = exponent - 1;
+  if(octave >= SKETCH_OCTAVES){
+    return SKETCH_BUCKETS - 1;
+  }
+  int sub = (int)((fraction * 2.0 - 1.0) * SKETCH_SUB_BUCKETS);
+  return 1 + octave * SKETCH_SUB_BUCKETS + sub;
+}
+
+/*
+   Function: sketch_bucket_value
+   Purpose:  Returns the midpoint of a bucket, the value reported for quantiles.
+   Params:
+    Input: int bucket - bucket index
+   Return: double - representative value
+*/
+static double sketch_bucket_value(int bucket){
+  if(bucket == 0){
+    return 0.5;
+  }
+  int octave = (bucket - 1) / SKETCH_SUB_BUCKETS;
+  int sub = (bucket - 1) % SKETCH_SUB_BUCKETS;
+  double base = ldexp(1.0, octave);
+  return base * (1.0 + (sub + 0.5) / SKETCH_SUB_BUCKETS);
+}
+
+static void sketch_add(struct QuantileSketch* sketch, double value){
+  if(sketch->count == 0 || value < sketch->min){
+    sketch->min = value;
+  }
+  if(sketch->count == 0 || value > sketch->max){
+    sketch->max = value;
+  }
+  sketch->buckets[sketch_bucket(value)]++;
+  sketch->count++;
+}
+
+static void sketch_merge(struct QuantileSketch* into, const struct QuantileSketch* from){
+  if(from->count == 0){
+    return;
+  }
+  if(into->count == 0 || from->min < into->min){
+    into->min = from->min;
+  }
+  if(into->count == 0 || from->max > into->max){
+    into->max = from->max;
+  }
+  for(int i = 0; i < SKETCH_BUCKETS; i++){
+    into->buckets[i] += from->buckets[i];
+  }
+  into->count += from->count;
+}
+
+/*
+   Function: sketch_quantile
+   Purpose:  Estimates a quantile from the histogram, clamped to the exact min and max.
+   Params:
+    Input: const struct QuantileSketch* sketch - the sketch
+    Input: double q - quantile in [0, 1]
+   Return: double - the estimate, 0 for an empty sketch
+*/
+static double sketch_quantile(const struct QuantileSketch* sketch, double q){
+  if(sketch->count == 0){
+    return 0.0;
+  }
+  unsigned long rank = (unsigned long)(q * (double)(sketch->count - 1));
+  unsigned long seen = 0;
+  for(int i = 0; i < SKETCH_BUCKETS; i++){
+    seen += sketch->buckets[i];
+    if(seen > rank){
+      double value = sketch_bucket_value(i);
+      if(value < sketch->min) value = sketch->min;
+      if(value > sketch->max) value = sketch->max;
+      return value;
+    }
+  }
+  return sketch->max;
+}
+
+/*
+   Function: aggregate_quantile
+   Purpose:  Estimates a quantile of one of an aggregate's sketches.
+   Params:
+    Input: const struct QuantileSketch* sketch - e.g. &agg->duration_sketch
+    Input: double q - quantile in [0, 1]
+   Return: double - the estimate, 0 for an empty sketch
+*/
+double aggregate_quantile(const struct QuantileSketch* sketch, double q){
+  return sketch_quantile(sketch, q);
+}
+
+/*
+   Function: aggregate_init
+   Purpose:  Clears an aggregate.
+   Params:
+    Output: struct Aggregate* agg - the aggregate to clear
+   Return: void
+*/
+void aggregate_init(struct Aggregate* agg){
+  memset(agg, 0, sizeof(*agg));
+}
+
+/*
+   Function: aggregate_add_run
+   Purpose:  Folds one finished run into the aggregate. Call after the run's
+   threads have been joined.
+   Params:
+    Input/Output: struct Aggregate* agg - the aggregate
+    Input: const struct House* house - the finished run
+    Input: double duration_us - wall time the hunt took, in microseconds
+   Return: void
+*/
+void aggregate_add_run(struct Aggregate* agg, const struct House* house, double duration_us){
+  //steps to solve stop at the solve: what each hunter had taken by then,
+  //or all of its steps if it left before
+  unsigned long steps = 0;
+  for(int i = 0; i < house->hunter_count; i++){
+    const struct Hunter* hunter = &house->hunters[i];
+    steps += hunter->solve_seen ? hunter->solve_steps : hunter->stats.iterations;
+    if(hunter->exit_reason >= 0 && hunter->exit_reason < AGGREGATE_EXIT_REASONS){
+      agg->exits[hunter->exit_reason]++;
+    }
+  }
+
+  bool solved = house->caseFile.solved;
+  agg->runs++;
+  welford_add(&agg->duration_us, duration_us);
+  sketch_add(&agg->duration_sketch, duration_us);
+  EvidenceByte collected = house->caseFile.collected;
+  if(!solved && evidence_has_three_unique(collected) && evidence_is_valid_ghost(collected)){
+    agg->unreturned++;
+  }
+  if(solved){
+    agg->solved++;
+    welford_add(&agg->steps_to_solve, (double)steps);
+    sketch_add(&agg->steps_sketch, (double)steps);
+  }
+
+  const enum GhostType* ghost_types = NULL;
+  int ghost_count = get_all_ghost_types(&ghost_types);
+  for(int i = 0; i < ghost_count && i < AGGREGATE_GHOST_TYPES; i++){
+    if(ghost_types[i] == house->ghost.type){
+      agg->ghosts[i].runs++;
+      if(solved){
+        agg->ghosts[i].solved++;
+      }
+      if(house->caseFile.collected == (EvidenceByte)house->ghost.type){
+        agg->ghosts[i].identified++;
+      }
+      break;
+    }
+  }
+}
+
+/*
+   Function: aggregate_merge
+   Purpose:  Adds one aggregate into another, e.g. a worker's partial into the total.
+   Params:
+    Input/Output: struct Aggregate* into - the aggregate to add to
+    Input: const struct Aggregate* from - the aggregate to add
+   Return: void
+*/
+void aggregate_merge(struct Aggregate* into, const struct Aggregate* from){
+  into->runs += from->runs;
+  into->solved += from->solved;
+  into->unreturned += from->unreturned;
+  for(int i = 0; i < AGGREGATE_EXIT_REASONS; i++){
+    into->exits[i] += from->exits[i];
+  }
+  welford_merge(&into->duration_us, &from->duration_us);
+  welford_merge(&into->steps_to_solve, &from->steps_to_solve);
+  sketch_merge(&into->duration_sketch, &from->duration_sketch);
+  sketch_merge(&into->steps_sketch, &from->steps_sketch);
+  for(int i = 0; i < AGGREGATE_GHOST_TYPES; i++){
+    into->ghosts[i].runs += from->ghosts[i].runs;
+    into->ghosts[i].solved += from->ghosts[i].solved;
+    into->ghosts[i].identified += from->ghosts[i].identified;
+  }
+}
+
+/*
+   Function: aggregate_print
+   Purpose:  Prints the batch summary: solve rate, exit reasons, duration and
+   steps-to-solve distributions and the per-ghost table.
+   Params:
+    Input: const struct Aggregate* agg - the aggregate to print
+   Return: void
+*/
+void aggregate_print(const struct Aggregate* agg){
+  printf("\n=== Batch Summary ===\n");
+  printf("Runs: %lu, solved: %lu (%.1f%%)\n", agg->runs, agg->solved,
+	 agg->runs ? 100.0 * (double)agg->solved / (double)agg->runs : 0.0);
+  printf("Unreturned: %lu (the evidence named the ghost, but no hunter got it to the van)\n", agg->unreturned);
+  printf("Hunter exits: %lu evidence, %lu bored, %lu afraid\n",
+	 agg->exits[LR_EVIDENCE], agg->exits[LR_BORED], agg->exits[LR_AFRAID]);
+
+  printf("Hunt duration us: mean %.1f sd %.1f  p50 %.0f p90 %.0f p99 %.0f  max %.0f\n",
+	 agg->duration_us.mean, welford_stddev(&agg->duration_us),
+	 sketch_quantile(&agg->duration_sketch, 0.50), sketch_quantile(&agg->duration_sketch, 0.90),
+	 sketch_quantile(&agg->duration_sketch, 0.99), agg->duration_sketch.max);
+  printf("Steps to solve:   mean %.1f sd %.1f  p50 %.0f p90 %.0f p99 %.0f  max %.0f\n",
+	 agg->steps_to_solve.mean, welford_stddev(&agg->steps_to_solve),
+	 sketch_quantile(&agg->steps_sketch, 0.50), sketch_quantile(&agg->steps_sketch, 0.90),
+	 sketch_quantile(&agg->steps_sketch, 0.99), agg->steps_sketch.max);
+
+  printf("Per ghost (runs / solved / identified):\n");
+  const enum GhostType* ghost_types = NULL;
+  int ghost_count = get_all_ghost_types(&ghost_types);
+  for(int i = 0; i < ghost_count && i < AGGREGATE_GHOST_TYPES; i++){
+    const struct GhostTally* tally = &agg->ghosts[i];
+    if(tally->runs == 0){
+      continue;
+    }
+    printf("  %-12s %8lu %8lu %8lu\n", ghost_to_string(ghost_types[i]),
+	   tally->runs, tally->solved, tally->identified);
+  }
+}
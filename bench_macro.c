@@ -0,0 +1,469 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+  End-to-end throughput benchmark. Runs full hunts for every combination of
+  hunter count, layout, log mode and thread pinning. Each cell runs in a forked child so its
+  peak RSS and CPU time are its own; the child reports simulation, step and
+  event counts back through a pipe. Results are written as JSON or CSV with
+  the git commit on every row so a dashboard can track them over time.
+*/
+
+#define MACRO_MAX_AXIS 32
+
+struct MacroOptions {
+  int hunters[MACRO_MAX_AXIS];
+  int hunter_axis;
+  char layouts[MACRO_MAX_AXIS][MAX_LAYOUT_NAME];
+  int layout_axis;
+  enum LogMode log_modes[2];
+  int log_mode_axis;
+  enum PinMode pin_modes[3];
+  int pin_mode_axis;
+  const char* cpus;
+  int runs;
+  unsigned seed;
+  const char* commit;
+  const char* format;
+  const char* out;
+};
+
+//What the child measures and sends back
+struct CellCounts {
+  long simulations;
+  unsigned long hunter_steps;
+  unsigned long ghost_steps;
+  unsigned long events;
+  long long wall_ns;
+};
+
+struct CellResult {
+  int hunters;
+  const char* layout;
+  enum LogMode log_mode;
+  enum PinMode pin_mode;
+  struct CellCounts counts;
+  long peak_rss_kb;
+  double cpu_seconds;
+  bool ok;
+};
+
+static long long now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+   Function: run_cell_child
+   Purpose:  Runs options->runs hunts for one cell inside the forked child.
+   Params:
+    Input: const struct MacroOptions* options - run count, seed and CPU list
+    Input: int hunters - hunters per hunt
+    Input: const char* layout - layout name
+    Input: enum LogMode log_mode - CSV logging on or off
+    Input: enum PinMode pin_mode - where the hunt's threads may run
+    Output: struct CellCounts* counts - what happened
+   Return: bool - false if the layout is unknown or no CPU is usable
+*/
+static bool run_cell_child(const struct MacroOptions* options, int hunters, const char* layout,
+                           enum LogMode log_mode, enum PinMode pin_mode, struct CellCounts* counts){
+  struct SimConfig config;
+  config_init(&config);
+  strncpy(config.layout, layout, MAX_LAYOUT_NAME - 1);
+  config.seed = options->seed;
+  config.has_seed = true;
+  config.log_mode = log_mode;
+  log_set_mode(log_mode);
+  memset(counts, 0, sizeof(*counts));
+  if(affinity_setup(pin_mode, options->cpus) == 0){
+    return false;
+  }
+  affinity_bind_worker(0);
+
+  struct Roster roster;
+  roster_init(&roster);
+  roster_generate(&roster, hunters);
+
+  unsigned long events_before = log_event_count();
+  long long start = now_ns();
+
+  bool ok = true;
+  for(int run = 0; run < options->runs && ok; run++){
+    struct House house;
+    ok = simulation_setup(&house, &config, &roster, run);
+    if(ok){
+      simulation_run(&house);
+      for(int i = 0; i < house.hunter_count; i++){
+        counts->hunter_steps += house.hunters[i].stats.iterations;
+      }
+      counts->ghost_steps += house.ghost.stats.iterations;
+      counts->simulations++;
+    }
+    house_cleanup(&house);
+  }
+
+  counts->wall_ns = now_ns() - start;
+  counts->events = log_event_count() - events_before;
+  roster_cleanup(&roster);
+  return ok;
+}
+
+/*
+   Function: run_cell
+   Purpose:  Forks a child for one cell and collects its counts and rusage.
+   Params:
+    Input: const struct MacroOptions* options - run count and seed
+    Input/Output: struct CellResult* result - cell coordinates in, measurements out
+   Return: void
+*/
+static void run_cell(const struct MacroOptions* options, struct CellResult* result){
+  int fds[2];
+  result->ok = false;
+  if(pipe(fds) != 0){
+    return;
+  }
+
+  fflush(NULL);
+  pid_t pid = fork();
+  if(pid < 0){
+    close(fds[0]);
+    close(fds[1]);
+    return;
+  }
+
+  if(pid == 0){
+    close(fds[0]);
+    //the simulation's console output is not part of the measurement
+    if(freopen("/dev/null", "w", stdout) == NULL){
+      _exit(2);
+    }
+    struct CellCounts counts;
+    bool ok = run_cell_child(options, result->hunters, result->layout, result->log_mode,
+                             result->pin_mode, &counts);
+    ssize_t written = write(fds[1], &counts, sizeof(counts));
+    _exit(ok && written == (ssize_t)sizeof(counts) ? 0 : 1);
+  }
+
+  close(fds[1]);
+  ssize_t got = read(fds[0], &result->counts, sizeof(result->counts));
+  close(fds[0]);
+
+  int status = 0;
+  struct rusage usage;
+  if(wait4(pid, &status, 0, &usage) < 0){
+    return;
+  }
+
+  result->peak_rss_kb = usage.ru_maxrss;
+  result->cpu_seconds = (double)usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+    + (double)usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+  result->ok = got == (ssize_t)sizeof(result->counts) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static double per_second(double count, long long ns){
+  return ns > 0 ? count * 1e9 / (double)ns : 0.0;
+}
+
+static const char* log_mode_name(enum LogMode mode){
+  return mode == LOG_MODE_CSV ? "csv" : "none";
+}
+
+static const char* pin_mode_name(enum PinMode mode){
+  return mode == PIN_CORES ? "cores" : mode == PIN_DOMAIN ? "domain" : "off";
+}
+
+/*
+   Function: write_results
+   Purpose:  Writes every cell as JSON (one document per file) or CSV (rows
+   appended, header only for a new file).
+   Params:
+    Input: const struct MacroOptions* options - commit, format and output path
+    Input: const struct CellResult* results - measured cells
+    Input: int count - number of cells
+   Return: bool - false if the output file could not be written
+*/
+static bool write_results(const struct MacroOptions* options, const struct CellResult* results, int count){
+  bool csv = strcmp(options->format, "csv") == 0;
+  struct stat info;
+  bool existed = stat(options->out, &info) == 0 && info.st_size > 0;
+
+  FILE* file = fopen(options->out, csv ? "a" : "w");
+  if(file == NULL){
+    perror(options->out);
+    return false;
+  }
+
+  long long timestamp = (long long)time(NULL);
+  if(csv){
+    if(!existed){
+      fprintf(file, "commit,timestamp,hunters,layout,log_mode,simulations,sims_per_sec,"
+              "entity_steps_per_sec,events_per_sec,peak_rss_kb,cpu_seconds,wall_seconds,ok,pin\n");
+    }
+  }else{
+    fprintf(file, "{\n  \"commit\": \"%s\",\n  \"timestamp\": %lld,\n  \"runs_per_cell\": %d,\n  \"cells\": [\n",
+            options->commit, timestamp, options->runs);
+  }
+
+  for(int i = 0; i < count; i++){
+    const struct CellResult* r = &results[i];
+    long long ns = r->counts.wall_ns;
+    double steps = (double)(r->counts.hunter_steps + r->counts.ghost_steps);
+    if(csv){
+      //pin came last, so rows still line up when appended to an older file
+      fprintf(file, "%s,%lld,%d,%s,%s,%ld,%.3f,%.1f,%.1f,%ld,%.4f,%.4f,%d,%s\n",
+              options->commit, timestamp, r->hunters, r->layout, log_mode_name(r->log_mode),
+              r->counts.simulations, per_second((double)r->counts.simulations, ns),
+              per_second(steps, ns), per_second((double)r->counts.events, ns),
+              r->peak_rss_kb, r->cpu_seconds, ns / 1e9, r->ok ? 1 : 0, pin_mode_name(r->pin_mode));
+    }else{
+      fprintf(file, "    {\"hunters\": %d, \"layout\": \"%s\", \"log_mode\": \"%s\", \"pin\": \"%s\", "
+              "\"simulations\": %ld, \"sims_per_sec\": %.3f, \"entity_steps_per_sec\": %.1f, "
+              "\"hunter_steps\": %lu, \"ghost_steps\": %lu, \"events_per_sec\": %.1f, "
+              "\"peak_rss_kb\": %ld, \"cpu_seconds\": %.4f, \"wall_seconds\": %.4f, \"ok\": %s}%s\n",
+              r->hunters, r->layout, log_mode_name(r->log_mode), pin_mode_name(r->pin_mode),
+              r->counts.simulations, per_second((double)r->counts.simulations, ns),
+              per_second(steps, ns), r->counts.hunter_steps, r->counts.ghost_steps,
+              per_second((double)r->counts.events, ns),
+              r->peak_rss_kb, r->cpu_seconds, ns / 1e9, r->ok ? "true" : "false",
+              i + 1 < count ? "," : "");
+    }
+  }
+
+  if(!csv){
+    fprintf(file, "  ]\n}\n");
+  }
+  fclose(file);
+  return true;
+}
+
+/*
+   Function: parse_list
+   Purpose:  Splits a comma separated list into the caller's buffers.
+   Params:
+    Input: const char* text - e.g. "1,4,16"
+    Output: char items[][MAX_LAYOUT_NAME] - the parsed items
+   Return: int - number of items, -1 if an item is too long or there are too many
+*/
+static int parse_list(const char* text, char items[][MAX_LAYOUT_NAME]){
+  int count = 0;
+  const char* p = text;
+  while(*p != '\0'){
+    const char* comma = strchr(p, ',');
+    size_t length = comma ? (size_t)(comma - p) : strlen(p);
+    if(count >= MACRO_MAX_AXIS || length == 0 || length >= MAX_LAYOUT_NAME){
+      return -1;
+    }
+    memcpy(items[count], p, length);
+    items[count][length] = '\0';
+    count++;
+    p += length;
+    if(*p == ','){
+      p++;
+    }
+  }
+  return count;
+}
+
+static void print_usage(const char* program){
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --hunters LIST     hunter counts (default 1,2,4,8,16,32,64,128,256,512)\n"
+          "  --layouts LIST     layouts (default willow,grid:4x6,corridor:12)\n"
+          "  --log-modes LIST   none and/or csv (default none,csv)\n"
+          "  --pin-modes LIST   off, domain and/or cores (default off)\n"
+          "  --cpus LIST        CPUs the pinned cells may use, e.g. 0-7 (default all allowed)\n"
+          "  --runs N           hunts per cell (default 10)\n"
+          "  --seed N           base seed (default 1)\n"
+          "  --commit SHA       commit recorded with every row (default unknown)\n"
+          "  --format FMT       json (default) or csv\n"
+          "  --out FILE         output file (default bench_<commit>.<format>)\n",
+          program);
+}
+
+int main(int argc, char** argv){
+  static const int default_hunters[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512};
+  struct MacroOptions options = {
+    .runs = 10, .seed = 1, .commit = "unknown", .format = "json", .out = NULL, .cpus = ""
+  };
+  options.hunter_axis = (int)(sizeof(default_hunters) / sizeof(default_hunters[0]));
+  memcpy(options.hunters, default_hunters, sizeof(default_hunters));
+  options.layout_axis = parse_list("willow,grid:4x6,corridor:12", options.layouts);
+  options.log_modes[0] = LOG_MODE_NONE;
+  options.log_modes[1] = LOG_MODE_CSV;
+  options.log_mode_axis = 2;
+  options.pin_modes[0] = PIN_OFF;
+  options.pin_mode_axis = 1;
+
+  char items[MACRO_MAX_AXIS][MAX_LAYOUT_NAME];
+  for(int i = 1; i < argc; i++){
+    const char* arg = argv[i];
+    const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+    if(value == NULL){
+      print_usage(argv[0]);
+      return 1;
+    }
+    i++;
+
+    if(strcmp(arg, "--hunters") == 0){
+      int count = parse_list(value, items);
+      if(count <= 0){
+        print_usage(argv[0]);
+        return 1;
+      }
+      for(int k = 0; k < count; k++){
+        options.hunters[k] = atoi(items[k]);
+        if(options.hunters[k] < 1){
+          fprintf(stderr, "Invalid hunter count '%s'\n", items[k]);
+          return 1;
+        }
+      }
+      options.hunter_axis = count;
+    }else if(strcmp(arg, "--layouts") == 0){
+      options.layout_axis = parse_list(value, options.layouts);
+      if(options.layout_axis <= 0){
+        print_usage(argv[0]);
+        return 1;
+      }
+    }else if(strcmp(arg, "--log-modes") == 0){
+      int count = parse_list(value, items);
+      if(count <= 0 || count > 2){
+        print_usage(argv[0]);
+        return 1;
+      }
+      for(int k = 0; k < count; k++){
+        if(strcmp(items[k], "csv") == 0){
+          options.log_modes[k] = LOG_MODE_CSV;
+        }else if(strcmp(items[k], "none") == 0){
+          options.log_modes[k] = LOG_MODE_NONE;
+        }else{
+          fprintf(stderr, "Invalid log mode '%s'\n", items[k]);
+          return 1;
+        }
+      }
+      options.log_mode_axis = count;
+    }else if(strcmp(arg, "--pin-modes") == 0){
+      int count = parse_list(value, items);
+      if(count <= 0 || count > 3){
+        print_usage(argv[0]);
+        return 1;
+      }
+      for(int k = 0; k < count; k++){
+        if(strcmp(items[k], "off") == 0){
+          options.pin_modes[k] = PIN_OFF;
+        }else if(strcmp(items[k], "domain") == 0){
+          options.pin_modes[k] = PIN_DOMAIN;
+        }else if(strcmp(items[k], "cores") == 0){
+          options.pin_modes[k] = PIN_CORES;
+        }else{
+          fprintf(stderr, "Invalid pin mode '%s'\n", items[k]);
+          return 1;
+        }
+      }
+      options.pin_mode_axis = count;
+    }else if(strcmp(arg, "--cpus") == 0){
+      options.cpus = value;
+    }else if(strcmp(arg, "--runs") == 0){
+      options.runs = atoi(value);
+    }else if(strcmp(arg, "--seed") == 0){
+      options.seed = (unsigned)strtoul(value, NULL, 10);
+    }else if(strcmp(arg, "--commit") == 0){
+      options.commit = value;
+    }else if(strcmp(arg, "--format") == 0){
+      options.format = value;
+    }else if(strcmp(arg, "--out") == 0){
+      options.out = value;
+    }else{
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if(options.runs < 1 || (strcmp(options.format, "json") != 0 && strcmp(options.format, "csv") != 0)){
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  char default_out[128];
+  if(options.out == NULL){
+    snprintf(default_out, sizeof(default_out), "bench_%s.%s", options.commit, options.format);
+    options.out = default_out;
+  }
+
+  //resolve the output path before moving into the scratch directory
+  char out_path[4096];
+  if(options.out[0] == '/'){
+    snprintf(out_path, sizeof(out_path), "%s", options.out);
+  }else{
+    char cwd[2048];
+    if(getcwd(cwd, sizeof(cwd)) == NULL){
+      perror("getcwd");
+      return 1;
+    }
+    snprintf(out_path, sizeof(out_path), "%s/%s", cwd, options.out);
+  }
+  options.out = out_path;
+
+  //CSV logs from the cells land in a scratch directory
+  char scratch[] = "/tmp/ghost_bench_macro_XXXXXX";
+  if(mkdtemp(scratch) == NULL || chdir(scratch) != 0){
+    perror("scratch directory");
+    return 1;
+  }
+
+  int total = options.hunter_axis * options.layout_axis * options.log_mode_axis * options.pin_mode_axis;
+  struct CellResult* results = calloc((size_t)total, sizeof(struct CellResult));
+  int index = 0;
+
+  fprintf(stderr, "%-14s %8s %6s %6s %12s %16s %14s %10s %8s\n",
+          "layout", "hunters", "log", "pin", "sims/s", "entity steps/s", "events/s", "rss KB", "cpu s");
+  for(int l = 0; l < options.layout_axis; l++){
+    for(int m = 0; m < options.log_mode_axis; m++){
+      for(int h = 0; h < options.hunter_axis; h++){
+        //pinned and unpinned cells of the same shape run back to back
+        for(int p = 0; p < options.pin_mode_axis; p++){
+          struct CellResult* r = &results[index++];
+          r->hunters = options.hunters[h];
+          r->layout = options.layouts[l];
+          r->log_mode = options.log_modes[m];
+          r->pin_mode = options.pin_modes[p];
+          run_cell(&options, r);
+
+          //each cell's logs would only slow the next one down
+          if(r->log_mode == LOG_MODE_CSV && system("rm -f log_*.csv") != 0){
+            fprintf(stderr, "could not clear scratch logs\n");
+          }
+
+          long long ns = r->counts.wall_ns;
+          fprintf(stderr, "%-14s %8d %6s %6s %12.2f %16.0f %14.0f %10ld %8.3f%s\n",
+                  r->layout, r->hunters, log_mode_name(r->log_mode), pin_mode_name(r->pin_mode),
+                  per_second((double)r->counts.simulations, ns),
+                  per_second((double)(r->counts.hunter_steps + r->counts.ghost_steps), ns),
+                  per_second((double)r->counts.events, ns),
+                  r->peak_rss_kb, r->cpu_seconds, r->ok ? "" : "  FAILED");
+        }
+      }
+    }
+  }
+
+
+  bool written = write_results(&options, results, total);
+  if(written){
+    fprintf(stderr, "results written to %s\n", options.out);
+  }
+
+  free(results);
+  if(chdir("/") == 0){
+    rmdir(scratch);
+  }
+  return written ? 0 : 1;
+}
@@ -0,0 +1,439 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+  Microbenchmarks for the simulation building blocks. Every benchmark runs a
+  batch of operations per repetition, after a few warmup repetitions, and
+  reports the median and p99 of the per-repetition ns/op. Console output from
+  the log_* functions goes to /dev/null; the report goes to the real stdout.
+*/
+
+#define BENCH_MAX_REPS 1000
+#define BENCH_CONTENDED_THREADS 4
+
+struct BenchOptions {
+  int warmup;
+  int reps;
+  const char* filter;
+};
+
+//A benchmark body runs `ops` operations and returns how many it really did
+typedef long (*BenchFn)(void* ctx, long ops);
+
+static FILE* report;
+
+/*
+   Function: now_ns
+   Purpose:  Reads the monotonic clock.
+   Return: long long - nanoseconds
+*/
+static long long now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int compare_double(const void* a, const void* b){
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+/*
+   Function: bench_run
+   Purpose:  Times one benchmark and prints its median and p99 ns/op.
+   Params:
+    Input: const struct BenchOptions* options - warmup/repetition counts and filter
+    Input: const char* name - benchmark name
+    Input: BenchFn fn - the benchmark body
+    Input: void* ctx - state passed to the body
+    Input: long ops - operations per repetition
+    Input: int max_reps - cap on repetitions for slow benchmarks (0 = no cap)
+   Return: void
+*/
+static void bench_run(const struct BenchOptions* options, const char* name,
+                      BenchFn fn, void* ctx, long ops, int max_reps){
+  if(options->filter != NULL && strstr(name, options->filter) == NULL){
+    return;
+  }
+
+  int reps = options->reps;
+  int warmup = options->warmup;
+  if(max_reps > 0 && reps > max_reps){
+    reps = max_reps;
+    warmup = warmup < 1 ? warmup : 1;
+  }
+
+  for(int i = 0; i < warmup; i++){
+    fn(ctx, ops);
+  }
+
+  static double samples[BENCH_MAX_REPS];
+  for(int i = 0; i < reps; i++){
+    long long start = now_ns();
+    long done = fn(ctx, ops);
+    long long elapsed = now_ns() - start;
+    samples[i] = (double)elapsed / (double)(done > 0 ? done : 1);
+  }
+
+  qsort(samples, (size_t)reps, sizeof(double), compare_double);
+  double median = samples[reps / 2];
+  int p99_index = (int)((reps - 1) * 0.99 + 0.5);
+  double p99 = samples[p99_index];
+
+  fprintf(report, "%-32s %14.1f %14.1f %8d %10ld\n", name, median, p99, reps, ops);
+  fflush(report);
+}
+
+// ---- hunter_move ----
+
+struct MoveContext {
+  struct Room rooms[2];
+  struct CaseFile casefile;
+  struct Hunter hunters[BENCH_CONTENDED_THREADS];
+  pthread_barrier_t barrier;
+  long ops;
+};
+
+static void move_context_init(struct MoveContext* ctx){
+  room_init(&ctx->rooms[0], "Bench A", false);
+  room_init(&ctx->rooms[1], "Bench B", false);
+  room_connect(&ctx->rooms[0], &ctx->rooms[1]);
+  ctx->casefile.collected = 0;
+  ctx->casefile.candidates = (1u << 24) - 1;
+  ctx->casefile.solved = false;
+  ctx->casefile.pending = 0;
+  ctx->casefile.ghost_gone = false;
+  ctx->casefile.cancelled = false;
+  sem_init(&ctx->casefile.mutex, 0, 1);
+  for(int i = 0; i < BENCH_CONTENDED_THREADS; i++){
+    hunter_init(&ctx->hunters[i], "bench", i + 1, &ctx->rooms[0], &ctx->casefile, NULL);
+    room_add_hunter(&ctx->rooms[0], &ctx->hunters[i]);
+  }
+}
+
+static void move_context_cleanup(struct MoveContext* ctx){
+  for(int i = 0; i < BENCH_CONTENDED_THREADS; i++){
+    hunter_cleanup(&ctx->hunters[i]);
+  }
+  room_cleanup(&ctx->rooms[0]);
+  room_cleanup(&ctx->rooms[1]);
+  sem_destroy(&ctx->casefile.mutex);
+}
+
+//ping-pong one hunter between the two rooms
+static void move_hunter(struct MoveContext* ctx, struct Hunter* hunter, long ops){
+  for(long i = 0; i < ops; i++){
+    struct Room* target = (hunter->current_room == &ctx->rooms[0]) ? &ctx->rooms[1] : &ctx->rooms[0];
+    hunter_move(hunter, target);
+  }
+}
+
+static long bench_move_uncontended(void* data, long ops){
+  struct MoveContext* ctx = data;
+  move_hunter(ctx, &ctx->hunters[0], ops);
+  return ops;
+}
+
+struct MoveWorker {
+  struct MoveContext* ctx;
+  struct Hunter* hunter;
+};
+
+static void* move_worker(void* data){
+  struct MoveWorker* worker = data;
+  pthread_barrier_wait(&worker->ctx->barrier);
+  move_hunter(worker->ctx, worker->hunter, worker->ctx->ops);
+  return NULL;
+}
+
+static long bench_move_contended(void* data, long ops){
+  struct MoveContext* ctx = data;
+  pthread_t threads[BENCH_CONTENDED_THREADS];
+  struct MoveWorker workers[BENCH_CONTENDED_THREADS];
+
+  ctx->ops = ops;
+  pthread_barrier_init(&ctx->barrier, NULL, BENCH_CONTENDED_THREADS);
+  for(int i = 0; i < BENCH_CONTENDED_THREADS; i++){
+    workers[i].ctx = ctx;
+    workers[i].hunter = &ctx->hunters[i];
+    pthread_create(&threads[i], NULL, move_worker, &workers[i]);
+  }
+  for(int i = 0; i < BENCH_CONTENDED_THREADS; i++){
+    pthread_join(threads[i], NULL);
+  }
+  pthread_barrier_destroy(&ctx->barrier);
+  return ops * BENCH_CONTENDED_THREADS;
+}
+
+// ---- room_remove_hunter ----
+
+struct RemoveContext {
+  struct Room room;
+  struct Hunter hunters[MAX_ROOM_OCCUPANCY];
+};
+
+static long bench_room_remove_hunter(void* data, long ops){
+  struct RemoveContext* ctx = data;
+  //remove the front hunter (worst case shift) and put it back at the end
+  for(long i = 0; i < ops; i++){
+    struct Hunter* hunter = ctx->room.hunters[0];
+    room_remove_hunter(&ctx->room, hunter);
+    room_add_hunter(&ctx->room, hunter);
+  }
+  return ops;
+}
+
+// ---- hunter_update_stats (seqlock read of the room) ----
+
+static long bench_hunter_update_stats(void* data, long ops){
+  struct MoveContext* ctx = data;
+  for(long i = 0; i < ops; i++){
+    hunter_update_stats(&ctx->hunters[0]);
+  }
+  ctx->hunters[0].boredom = 0;
+  return ops;
+}
+
+// ---- roomstack ----
+
+struct StackContext {
+  struct RoomStack stack;
+  struct Room room;
+};
+
+static long bench_roomstack_push_pop(void* data, long ops){
+  struct StackContext* ctx = data;
+  for(long i = 0; i < ops; i++){
+    roomstack_push(&ctx->stack, &ctx->room);
+  }
+  for(long i = 0; i < ops; i++){
+    roomstack_pop(&ctx->stack);
+  }
+  return ops * 2;
+}
+
+// ---- rand / evidence ----
+
+static volatile int sink;
+
+static long bench_rand_int(void* data, long ops){
+  (void)data;
+  int total = 0;
+  for(long i = 0; i < ops; i++){
+    total += rand_int_threadsafe(0, 7);
+  }
+  sink = total;
+  return ops;
+}
+
+static long bench_evidence_is_valid_ghost(void* data, long ops){
+  (void)data;
+  int total = 0;
+  for(long i = 0; i < ops; i++){
+    total += evidence_is_valid_ghost((EvidenceByte)(i & 0x7F));
+  }
+  sink = total;
+  return ops;
+}
+
+// ---- write_log_record (through the cheapest public logger) ----
+
+static long bench_write_log_record(void* data, long ops){
+  (void)data;
+  for(long i = 0; i < ops; i++){
+    log_ghost_idle(DEFAULT_GHOST_ID, 0, "Bench");
+  }
+  return ops;
+}
+
+// ---- monitor_read (against a publisher that keeps lapping it) ----
+
+struct MonitorContext {
+  struct House house;
+  struct Monitor monitor;
+  struct WorldSnapshot snapshot;
+  bool stop;             //atomic
+  long torn;             //copies that mix two captures
+};
+
+//flip every room between no evidence and three bits, publishing after each flip
+static void* monitor_publisher(void* data){
+  struct MonitorContext* ctx = data;
+  EvidenceByte evidence = 0;
+  while(!__atomic_load_n(&ctx->stop, __ATOMIC_ACQUIRE)){
+    evidence = evidence != 0 ? 0 : (EvidenceByte)(EV_EMF | EV_ORBS | EV_RADIO);
+    for(int i = 0; i < ctx->house.room_count; i++){
+      struct Room* room = &ctx->house.rooms[i];
+      sem_wait(&room->mutex);
+      room_write_begin(room);
+      __atomic_store_n(&room->evidence, evidence, __ATOMIC_RELAXED);
+      room_write_end(room);
+      sem_post(&room->mutex);
+    }
+    monitor_publish(&ctx->monitor);
+  }
+  return NULL;
+}
+
+//every capture sees all rooms alike, so a copy that disagrees with itself is torn
+static bool monitor_snapshot_torn(const struct WorldSnapshot* snapshot){
+  EvidenceByte first = snapshot->rooms[0].evidence;
+  for(int i = 1; i < snapshot->room_count; i++){
+    if(snapshot->rooms[i].evidence != first){
+      return true;
+    }
+  }
+  return snapshot->room_evidence != evidence_count_bits(first) * snapshot->room_count;
+}
+
+static long bench_monitor_read(void* data, long ops){
+  struct MonitorContext* ctx = data;
+  pthread_t publisher;
+
+  __atomic_store_n(&ctx->stop, false, __ATOMIC_RELAXED);
+  pthread_create(&publisher, NULL, monitor_publisher, ctx);
+  long done = 0;
+  while(done < ops){
+    if(!monitor_read(&ctx->monitor, &ctx->snapshot)){
+      continue;
+    }
+    ctx->torn += monitor_snapshot_torn(&ctx->snapshot);
+    done++;
+  }
+  __atomic_store_n(&ctx->stop, true, __ATOMIC_RELEASE);
+  pthread_join(publisher, NULL);
+  return done;
+}
+
+// ---- full hunt ----
+
+struct HuntContext {
+  struct SimConfig config;
+  struct Roster roster;
+  int run;
+};
+
+static long bench_willow_hunt(void* data, long ops){
+  struct HuntContext* ctx = data;
+  for(long i = 0; i < ops; i++){
+    struct House house;
+    simulation_setup(&house, &ctx->config, &ctx->roster, ctx->run++);
+    simulation_run(&house);
+    house_cleanup(&house);
+  }
+  return ops;
+}
+
+int main(int argc, char** argv){
+  struct BenchOptions options = { .warmup = 3, .reps = 31, .filter = NULL };
+
+  for(int i = 1; i < argc; i++){
+    if(strcmp(argv[i], "--reps") == 0 && i + 1 < argc){
+      options.reps = atoi(argv[++i]);
+    }else if(strcmp(argv[i], "--warmup") == 0 && i + 1 < argc){
+      options.warmup = atoi(argv[++i]);
+    }else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc){
+      options.filter = argv[++i];
+    }else{
+      fprintf(stderr, "Usage: %s [--reps N] [--warmup N] [--filter NAME]\n", argv[0]);
+      return 1;
+    }
+  }
+  if(options.reps < 1 || options.reps > BENCH_MAX_REPS || options.warmup < 0){
+    fprintf(stderr, "reps must be 1..%d and warmup >= 0\n", BENCH_MAX_REPS);
+    return 1;
+  }
+
+  //keep the report on the real stdout, silence the simulation's printf noise
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if(report == NULL || freopen("/dev/null", "w", stdout) == NULL){
+    perror("bench");
+    return 1;
+  }
+
+  //the log files land in a scratch directory so the tree stays clean
+  char scratch[] = "/tmp/ghost_bench_XXXXXX";
+  if(mkdtemp(scratch) == NULL || chdir(scratch) != 0){
+    perror("bench");
+    return 1;
+  }
+
+  rand_seed_thread(12345);
+  log_set_mode(LOG_MODE_NONE);
+  //no console echo either, so each case times the operation it is named after
+  log_set_console(CONSOLE_SILENT);
+
+  fprintf(report, "%-32s %14s %14s %8s %10s\n", "benchmark", "median ns/op", "p99 ns/op", "reps", "ops/rep");
+
+  struct MoveContext* move = calloc(1, sizeof(struct MoveContext));
+  move_context_init(move);
+  bench_run(&options, "hunter_move/uncontended", bench_move_uncontended, move, 20000, 0);
+  bench_run(&options, "hunter_move/contended", bench_move_contended, move, 20000, 0);
+  bench_run(&options, "hunter_update_stats", bench_hunter_update_stats, move, 100000, 0);
+  move_context_cleanup(move);
+  free(move);
+
+  struct RemoveContext remove;
+  room_init(&remove.room, "Bench", false);
+  for(int i = 0; i < MAX_ROOM_OCCUPANCY; i++){
+    room_add_hunter(&remove.room, &remove.hunters[i]);
+  }
+  bench_run(&options, "room_remove_hunter", bench_room_remove_hunter, &remove, 100000, 0);
+  room_cleanup(&remove.room);
+
+  struct StackContext stack;
+  roomstack_init(&stack.stack);
+  bench_run(&options, "roomstack_push_pop", bench_roomstack_push_pop, &stack, 100000, 0);
+  roomstack_cleanup(&stack.stack);
+
+  bench_run(&options, "rand_int_threadsafe", bench_rand_int, NULL, 1000000, 0);
+  bench_run(&options, "evidence_is_valid_ghost", bench_evidence_is_valid_ghost, NULL, 1000000, 0);
+
+  log_set_mode(LOG_MODE_CSV);
+  bench_run(&options, "write_log_record/csv", bench_write_log_record, NULL, 20, 11);
+  log_set_mode(LOG_MODE_NONE);
+  bench_run(&options, "write_log_record/none", bench_write_log_record, NULL, 100000, 0);
+
+  struct HuntContext hunt = { .run = 0 };
+  config_init(&hunt.config);
+  hunt.config.seed = 2024;
+  hunt.config.has_seed = true;
+  hunt.config.log_mode = LOG_MODE_NONE;
+  roster_init(&hunt.roster);
+  roster_generate(&hunt.roster, 4);
+  bench_run(&options, "willow_hunt/4_hunters", bench_willow_hunt, &hunt, 20, 0);
+
+  //a set-up house whose entity threads never start; only the publisher touches it
+  struct MonitorContext* watch = calloc(1, sizeof(struct MonitorContext));
+  simulation_setup(&watch->house, &hunt.config, &hunt.roster, hunt.run);
+  watch->monitor.house = &watch->house;
+  bench_run(&options, "monitor_read/contended", bench_monitor_read, watch, 20000, 0);
+  house_cleanup(&watch->house);
+  long torn = watch->torn;
+  free(watch);
+  roster_cleanup(&hunt.roster);
+
+  //drop the scratch logs
+  char command[128];
+  snprintf(command, sizeof(command), "rm -rf %s", scratch);
+  if(chdir("/") == 0){
+    system(command);
+  }
+
+  fclose(report);
+
+  //a wrong retry condition in monitor_read shows up here rather than as a timing
+  if(torn > 0){
+    fprintf(stderr, "monitor_read returned %ld torn snapshots\n", torn);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,135 @@
+#include "defs.h"
+#include "helpers.h"
+
+/*
+  Run-wide early termination. The case file doubles as the place every
+  thread already shares, so it carries the cancel flag plus the two facts
+  needed to notice that no more evidence can turn up: how many evidence
+  bits are lying in rooms, and whether the ghost has left. All three are
+  touched with atomics so checking them never waits on the case file lock.
+  The same goes for the team's shared coordination state: the sweep clock
+  and the bitmap of devices claimed by a hunter.
+*/
+
+/* 
+   Function: casefile_cancel
+   Purpose:  Tells every thread to leave. Does nothing unless the run was
+   started with early exit enabled. Only hunter_check_van marks the case
+   solved; evidence that names the ghost but never reached the van is
+   counted apart by aggregate_add_run.
+   Params:   
+    Input/Output: struct CaseFile* casefile - the shared case file
+    Input: const struct SimParams* params - options for this run (may be NULL)
+   Return: void
+*/
+void casefile_cancel(struct CaseFile* casefile, const struct SimParams* params){
+  if(params == NULL || !params->early_exit){
+    return;
+  }
+  __atomic_store_n(&casefile->cancelled, true, __ATOMIC_RELEASE);
+}
+
+/* 
+   Function: casefile_is_cancelled
+   Purpose:  Checks the cancel flag; cheap enough for every loop pass.
+   Params:   
+    Input: struct CaseFile* casefile - the shared case file
+   Return: bool - true once the hunt is decided
+*/
+bool casefile_is_cancelled(struct CaseFile* casefile){
+  return __atomic_load_n(&casefile->cancelled, __ATOMIC_ACQUIRE);
+}
+
+/* 
+   Function: casefile_evidence_dropped
+   Purpose:  Counts a new evidence bit left in a room by the ghost.
+   Params:   
+    Input/Output: struct CaseFile* casefile - the shared case file
+   Return: void
+*/
+void casefile_evidence_dropped(struct CaseFile* casefile){
+  __atomic_add_fetch(&casefile->pending, 1, __ATOMIC_SEQ_CST);
+}
+
+/* 
+   Function: casefile_evidence_taken
+   Purpose:  Counts an evidence bit picked up by a hunter. If that was the
+   last one and the ghost is gone, nothing more can be found.
+   Params:   
+    Input/Output: struct CaseFile* casefile - the shared case file
+    Input: const struct SimParams* params - options for this run (may be NULL)
+   Return: void
+*/
+void casefile_evidence_taken(struct CaseFile* casefile, const struct SimParams* params){
+  int left = __atomic_sub_fetch(&casefile->pending, 1, __ATOMIC_SEQ_CST);
+  if(left == 0 && __atomic_load_n(&casefile->ghost_gone, __ATOMIC_SEQ_CST)){
+    casefile_cancel(casefile, params);
+  }
+}
+
+/* 
+   Function: casefile_ghost_left
+   Purpose:  Records that the ghost has exited. With no evidence left in
+   any room the hunt cannot progress any more. Together with
+   casefile_evidence_taken (both sequentially consistent) at least one side
+   sees the other's update, so the last case is never missed.
+   Params:   
+    Input/Output: struct CaseFile* casefile - the shared case file
+    Input: const struct SimParams* params - options for this run (may be NULL)
+   Return: void
+*/
+void casefile_ghost_left(struct CaseFile* casefile, const struct SimParams* params){
+  __atomic_store_n(&casefile->ghost_gone, true, __ATOMIC_SEQ_CST);
+  if(__atomic_load_n(&casefile->pending, __ATOMIC_SEQ_CST) == 0){
+    casefile_cancel(casefile, params);
+  }
+}
+
+/* 
+   Function: casefile_next_sweep
+   Purpose:  Ticks the team's sweep clock for one search in coordinated
+   exploration. Only the order of the stamps matters, so relaxed is enough.
+   Params:   
+    Input/Output: struct CaseFile* casefile - the shared case file
+   Return: unsigned long - the stamp for this search, never 0
+*/
+unsigned long casefile_next_sweep(struct CaseFile* casefile){
+  return __atomic_add_fetch(&casefile->sweep_clock, 1, __ATOMIC_RELAXED);
+}
+
+/* 
+   Function: casefile_claimed_devices
+   Purpose:  Reads which devices some hunter currently owns.
+   Params:   
+    Input: struct CaseFile* casefile - the shared case file
+   Return: EvidenceByte - one bit per claimed device
+*/
+EvidenceByte casefile_claimed_devices(struct CaseFile* casefile){
+  return __atomic_load_n(&casefile->claimed, __ATOMIC_ACQUIRE);
+}
+
+/* 
+   Function: casefile_claim_device
+   Purpose:  Claims a device for one hunter. Two hunters racing for the
+   same bit cannot both win, the fetch-or tells each who was first.
+   Params:   
+    Input/Output: struct CaseFile* casefile - the shared case file
+    Input: enum EvidenceType device - the device wanted
+   Return: bool - true if the caller now owns the device
+*/
+bool casefile_claim_device(struct CaseFile* casefile, enum EvidenceType device){
+  EvidenceByte before = __atomic_fetch_or(&casefile->claimed, (EvidenceByte)device, __ATOMIC_ACQ_REL);
+  return (before & (EvidenceByte)device) == 0;
+}
+
+/* 
+   Function: casefile_release_device
+   Purpose:  Gives a claimed device back so a teammate may take it.
+   Params:   
+    Input/Output: struct CaseFile* casefile - the shared case file
+    Input: enum EvidenceType device - a device the caller owns
+   Return: void
+*/
+void casefile_release_device(struct CaseFile* casefile, enum EvidenceType device){
+  __atomic_fetch_and(&casefile->claimed, (EvidenceByte)~(EvidenceByte)device, __ATOMIC_RELEASE);
+}
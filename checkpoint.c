@@ -0,0 +1,447 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+  Binary snapshots of a hunt between two lockstep rounds. The file holds
+  only what changes while a hunt runs: the layout is stored by name and
+  rebuilt, and every pointer (rooms, hunters in a room, breadcrumbs) is
+  stored as an index. Fields are fixed-width words in host byte order,
+  framed by CHECKPOINT_MAGIC at both ends so a truncated file is rejected.
+
+  Together with each entity's own RNG state this is all the lockstep
+  scheduler depends on, so a loaded hunt continues exactly as the saved
+  one would have.
+*/
+
+//A file being written or read; the first short transfer clears ok and
+//turns every later call into a no-op, so callers check once at the end
+struct CheckpointFile {
+  FILE* file;
+  bool ok;
+};
+
+/*
+   Function: put_u32
+   Purpose:  Writes one 32-bit word.
+   Params:
+    Input/Output: struct CheckpointFile* cp - the open file
+    Input: uint32_t value - the word
+   Return: void
+*/
+static void put_u32(struct CheckpointFile* cp, uint32_t value){
+  if(cp->ok && fwrite(&value, sizeof(value), 1, cp->file) != 1){
+    cp->ok = false;
+  }
+}
+
+/*
+   Function: put_u64
+   Purpose:  Writes one 64-bit word.
+   Params:
+    Input/Output: struct CheckpointFile* cp - the open file
+    Input: uint64_t value - the word
+   Return: void
+*/
+static void put_u64(struct CheckpointFile* cp, uint64_t value){
+  if(cp->ok && fwrite(&value, sizeof(value), 1, cp->file) != 1){
+    cp->ok = false;
+  }
+}
+
+/*
+   Function: put_bytes
+   Purpose:  Writes a fixed-size block such as a name buffer.
+   Params:
+    Input/Output: struct CheckpointFile* cp - the open file
+    Input: const void* data - the block
+    Input: size_t size - its size in bytes
+   Return: void
+*/
+static void put_bytes(struct CheckpointFile* cp, const void* data, size_t size){
+  if(cp->ok && fwrite(data, size, 1, cp->file) != 1){
+    cp->ok = false;
+  }
+}
+
+/*
+   Function: get_u32
+   Purpose:  Reads one 32-bit word.
+   Params:
+    Input/Output: struct CheckpointFile* cp - the open file
+   Return: uint32_t - the word, 0 once the file has failed
+*/
+static uint32_t get_u32(struct CheckpointFile* cp){
+  uint32_t value = 0;
+  if(cp->ok && fread(&value, sizeof(value), 1, cp->file) != 1){
+    cp->ok = false;
+  }
+  return value;
+}
+
+/*
+   Function: get_u64
+   Purpose:  Reads one 64-bit word.
+   Params:
+    Input/Output: struct CheckpointFile* cp - the open file
+   Return: uint64_t - the word, 0 once the file has failed
+*/
+static uint64_t get_u64(struct CheckpointFile* cp){
+  uint64_t value = 0;
+  if(cp->ok && fread(&value, sizeof(value), 1, cp->file) != 1){
+    cp->ok = false;
+  }
+  return value;
+}
+
+/*
+   Function: get_bytes
+   Purpose:  Reads a fixed-size block.
+   Params:
+    Input/Output: struct CheckpointFile* cp - the open file
+    Output: void* data - where the block goes
+    Input: size_t size - its size in bytes
+   Return: void
+*/
+static void get_bytes(struct CheckpointFile* cp, void* data, size_t size){
+  if(cp->ok && fread(data, size, 1, cp->file) != 1){
+    cp->ok = false;
+  }
+}
+
+/*
+   Function: room_index
+   Purpose:  Turns a room pointer into its index in the house.
+   Params:
+    Input: const struct House* house - the house owning the room
+    Input: const struct Room* room - the room, or NULL
+   Return: uint32_t - the index, UINT32_MAX for NULL
+*/
+static uint32_t room_index(const struct House* house, const struct Room* room){
+  return room != NULL ? (uint32_t)(room - house->rooms) : UINT32_MAX;
+}
+
+/*
+   Function: room_at
+   Purpose:  Turns a stored index back into a room, rejecting bad indices.
+   Params:
+    Input/Output: struct CheckpointFile* cp - cleared on a bad index
+    Input: struct House* house - the house being restored
+    Input: uint32_t index - the stored index
+   Return: struct Room* - the room, NULL for a bad index
+*/
+static struct Room* room_at(struct CheckpointFile* cp, struct House* house, uint32_t index){
+  if(index >= (uint32_t)house->room_count){
+    cp->ok = false;
+    return NULL;
+  }
+  return &house->rooms[index];
+}
+
+/*
+   Function: checkpoint_save
+   Purpose:  Writes the running state of a hunt to a file. Only meaningful
+   between lockstep rounds, when no entity is part way through a step.
+   Params:
+    Input: const struct House* house - the hunt to save
+    Input: const char* path - file to create or replace
+   Return: bool - false if the file could not be written completely
+*/
+bool checkpoint_save(const struct House* house, const char* path){
+  struct CheckpointFile cp = { fopen(path, "wb"), true };
+  if(cp.file == NULL){
+    perror(path);
+    return false;
+  }
+
+  //header and run options
+  put_u32(&cp, CHECKPOINT_MAGIC);
+  put_u32(&cp, CHECKPOINT_VERSION);
+  put_bytes(&cp, house->layout, sizeof(house->layout));
+  put_u32(&cp, house->seed);
+  put_u32(&cp, house->params.return_mode);
+  put_u32(&cp, house->params.swap_mode);
+  put_u32(&cp, house->params.explore_mode);
+  put_u32(&cp, house->params.device_mode);
+  put_u32(&cp, house->params.early_exit);
+  put_u32(&cp, (uint32_t)house->params.boredom_max);
+  put_u32(&cp, (uint32_t)house->params.fear_max);
+  put_u32(&cp, (uint32_t)house->params.occupancy);
+  put_u32(&cp, (uint32_t)house->params.return_chance);
+  put_u32(&cp, (uint32_t)house->params.idle_weight);
+  put_u32(&cp, (uint32_t)house->params.haunt_weight);
+  put_u32(&cp, (uint32_t)house->params.move_weight);
+  put_u64(&cp, house->round);
+
+  //case file
+  const struct CaseFile* casefile = &house->caseFile;
+  put_u32(&cp, casefile->collected);
+  put_u32(&cp, casefile->solved);
+  put_u32(&cp, casefile->candidates);
+  put_u32(&cp, (uint32_t)casefile->pending);
+  put_u32(&cp, casefile->ghost_gone);
+  put_u32(&cp, casefile->cancelled);
+  put_u64(&cp, casefile->sweep_clock);
+  put_u32(&cp, casefile->claimed);
+
+  //ghost
+  const struct Ghost* ghost = &house->ghost;
+  put_u32(&cp, (uint32_t)ghost->id);
+  put_u32(&cp, ghost->type);
+  put_u32(&cp, room_index(house, ghost->current_room));
+  put_u32(&cp, (uint32_t)ghost->boredom);
+  put_u32(&cp, ghost->has_exited);
+  put_u32(&cp, ghost->rng_seed);
+  put_u32(&cp, ghost->rng_state);
+  put_u64(&cp, ghost->stats.iterations);
+  put_u64(&cp, ghost->stats.idles);
+  put_u64(&cp, ghost->stats.haunts);
+  put_u64(&cp, ghost->stats.moves);
+  put_u64(&cp, ghost->stats.moves_blocked);
+
+  //hunters, each with its breadcrumb trail from the top of the stack down
+  put_u32(&cp, (uint32_t)house->hunter_count);
+  for(int i = 0; i < house->hunter_count; i++){
+    const struct Hunter* hunter = &house->hunters[i];
+    put_bytes(&cp, hunter->name, sizeof(hunter->name));
+    put_u32(&cp, (uint32_t)hunter->id);
+    put_u32(&cp, room_index(house, hunter->current_room));
+    put_u32(&cp, hunter->device);
+    put_u32(&cp, hunter->device_claimed);
+    put_u32(&cp, (uint32_t)hunter->fear);
+    put_u32(&cp, (uint32_t)hunter->boredom);
+    put_u32(&cp, hunter->should_exit);
+    put_u32(&cp, hunter->return_to_van);
+    put_u32(&cp, hunter->exit_reason);
+    put_u32(&cp, hunter->rng_seed);
+    put_u32(&cp, hunter->rng_state);
+    put_u64(&cp, hunter->stats.iterations);
+    put_u64(&cp, hunter->stats.moves);
+    put_u64(&cp, hunter->stats.moves_full);
+    put_u64(&cp, hunter->stats.evidence);
+    put_u64(&cp, hunter->stats.van_returns);
+    put_u64(&cp, hunter->stats.device_swaps);
+    put_u64(&cp, hunter->solve_steps);
+    put_u32(&cp, hunter->solve_seen);
+
+    uint32_t depth = 0;
+    for(struct RoomNode* node = hunter->path.head; node != NULL; node = node->next){
+      depth++;
+    }
+    put_u32(&cp, depth);
+    for(struct RoomNode* node = hunter->path.head; node != NULL; node = node->next){
+      put_u32(&cp, room_index(house, node->room));
+    }
+  }
+
+  //rooms: evidence and occupants in their slot order
+  put_u32(&cp, (uint32_t)house->room_count);
+  for(int i = 0; i < house->room_count; i++){
+    const struct Room* room = &house->rooms[i];
+    put_u32(&cp, room->evidence);
+    for(int d = 0; d < EVIDENCE_TYPE_COUNT; d++){
+      put_u64(&cp, room->swept[d]);
+    }
+    put_u32(&cp, (uint32_t)room->hunter_count);
+    for(int j = 0; j < room->hunter_count; j++){
+      put_u32(&cp, (uint32_t)(room->hunters[j] - house->hunters));
+    }
+  }
+
+  put_u32(&cp, CHECKPOINT_MAGIC);
+
+  if(fclose(cp.file) != 0){
+    cp.ok = false;
+  }
+  if(!cp.ok){
+    fprintf(stderr, "Could not write checkpoint %s\n", path);
+  }
+  return cp.ok;
+}
+
+/*
+   Function: checkpoint_load
+   Purpose:  Rebuilds a hunt saved by checkpoint_save: initializes the
+   house, rebuilds the saved layout and restores every entity. Nothing is
+   logged; the hunt picks up where it stopped.
+   Params:
+    Output: struct House* house - the house to restore (cleaned up by house_cleanup, even on failure)
+    Input: const char* path - the checkpoint file
+   Return: bool - false if the file is missing, damaged or from another version
+*/
+bool checkpoint_load(struct House* house, const char* path){
+  house_init(house);
+
+  struct CheckpointFile cp = { fopen(path, "rb"), true };
+  if(cp.file == NULL){
+    perror(path);
+    return false;
+  }
+
+  //header and run options
+  if(get_u32(&cp) != CHECKPOINT_MAGIC || get_u32(&cp) != CHECKPOINT_VERSION){
+    fprintf(stderr, "%s is not a version %d checkpoint\n", path, CHECKPOINT_VERSION);
+    fclose(cp.file);
+    return false;
+  }
+  char layout[MAX_LAYOUT_NAME];
+  get_bytes(&cp, layout, sizeof(layout));
+  layout[MAX_LAYOUT_NAME - 1] = '\0';
+  if(!cp.ok || !house_populate_layout(house, layout)){
+    fprintf(stderr, "%s: unknown layout\n", path);
+    fclose(cp.file);
+    return false;
+  }
+  house->seed = get_u32(&cp);
+  house->params.return_mode = get_u32(&cp);
+  house->params.swap_mode = get_u32(&cp);
+  house->params.explore_mode = get_u32(&cp);
+  house->params.device_mode = get_u32(&cp);
+  house->params.early_exit = get_u32(&cp) != 0;
+  house->params.boredom_max = (int)get_u32(&cp);
+  house->params.fear_max = (int)get_u32(&cp);
+  house->params.occupancy = (int)get_u32(&cp);
+  house->params.return_chance = (int)get_u32(&cp);
+  house->params.idle_weight = (int)get_u32(&cp);
+  house->params.haunt_weight = (int)get_u32(&cp);
+  house->params.move_weight = (int)get_u32(&cp);
+  if(house->params.occupancy < 1 || house->params.occupancy > MAX_ROOM_OCCUPANCY ||
+     house->params.idle_weight < 0 || house->params.haunt_weight < 0 || house->params.move_weight < 0 ||
+     house->params.idle_weight + house->params.haunt_weight + house->params.move_weight < 1){
+    cp.ok = false;
+  }
+  house_params_update(&house->params);
+  house->round = get_u64(&cp);
+
+  //case file
+  struct CaseFile* casefile = &house->caseFile;
+  casefile->collected = (EvidenceByte)get_u32(&cp);
+  casefile->solved = get_u32(&cp) != 0;
+  casefile->candidates = get_u32(&cp);
+  casefile->pending = (int)get_u32(&cp);
+  casefile->ghost_gone = get_u32(&cp) != 0;
+  casefile->cancelled = get_u32(&cp) != 0;
+  casefile->sweep_clock = get_u64(&cp);
+  casefile->claimed = (EvidenceByte)get_u32(&cp);
+
+  //ghost
+  struct Ghost* ghost = &house->ghost;
+  ghost->id = (int)get_u32(&cp);
+  ghost->type = get_u32(&cp);
+  ghost->current_room = room_at(&cp, house, get_u32(&cp));
+  ghost->boredom = (int)get_u32(&cp);
+  ghost->has_exited = get_u32(&cp) != 0;
+  ghost->rng_seed = get_u32(&cp);
+  ghost->rng_state = get_u32(&cp);
+  ghost->stats.iterations = get_u64(&cp);
+  ghost->stats.idles = get_u64(&cp);
+  ghost->stats.haunts = get_u64(&cp);
+  ghost->stats.moves = get_u64(&cp);
+  ghost->stats.moves_blocked = get_u64(&cp);
+  ghost->casefile = casefile;
+  ghost->params = &house->params;
+  if(cp.ok && !ghost->has_exited){
+    ghost->current_room->ghost = ghost;
+  }
+
+  //hunters
+  uint32_t hunter_count = get_u32(&cp);
+  if(cp.ok && hunter_count > 0){
+    struct Hunter* hunters = realloc(house->hunters, hunter_count * sizeof(struct Hunter));
+    if(hunters == NULL){
+      cp.ok = false;
+    }else{
+      house->hunters = hunters;
+      house->hunter_capacity = (int)hunter_count;
+    }
+  }
+  for(uint32_t i = 0; cp.ok && i < hunter_count; i++){
+    struct Hunter* hunter = &house->hunters[i];
+    memset(hunter, 0, sizeof(*hunter));
+    roomstack_init(&hunter->path);
+    house->hunter_count = (int)i + 1;  //cleanup frees this hunter's trail even if the rest fails
+
+    get_bytes(&cp, hunter->name, sizeof(hunter->name));
+    hunter->name[MAX_HUNTER_NAME - 1] = '\0';
+    hunter->id = (int)get_u32(&cp);
+    hunter->current_room = room_at(&cp, house, get_u32(&cp));
+    hunter->device = get_u32(&cp);
+    hunter->device_claimed = get_u32(&cp) != 0;
+    hunter->fear = (int)get_u32(&cp);
+    hunter->boredom = (int)get_u32(&cp);
+    hunter->should_exit = get_u32(&cp) != 0;
+    hunter->return_to_van = get_u32(&cp) != 0;
+    hunter->exit_reason = get_u32(&cp);
+    hunter->rng_seed = get_u32(&cp);
+    hunter->rng_state = get_u32(&cp);
+    hunter->stats.iterations = get_u64(&cp);
+    hunter->stats.moves = get_u64(&cp);
+    hunter->stats.moves_full = get_u64(&cp);
+    hunter->stats.evidence = get_u64(&cp);
+    hunter->stats.van_returns = get_u64(&cp);
+    hunter->stats.device_swaps = get_u64(&cp);
+    hunter->solve_steps = get_u64(&cp);
+    hunter->solve_seen = get_u32(&cp) != 0;
+    hunter->casefile = casefile;
+    hunter->params = &house->params;
+
+    //saved top first, so push from the bottom up; a trail never outgrows
+    //the steps taken, which also bounds what a damaged file can ask for
+    uint32_t depth = get_u32(&cp);
+    if(depth > hunter->stats.moves){
+      cp.ok = false;
+    }
+    uint32_t* trail = cp.ok && depth > 0 ? malloc(depth * sizeof(uint32_t)) : NULL;
+    if(depth > 0 && trail == NULL){
+      cp.ok = false;
+    }
+    for(uint32_t j = 0; cp.ok && j < depth; j++){
+      trail[j] = get_u32(&cp);
+    }
+    for(uint32_t j = depth; cp.ok && j > 0; j--){
+      struct Room* room = room_at(&cp, house, trail[j - 1]);
+      if(room != NULL){
+        roomstack_push(&hunter->path, room);
+      }
+    }
+    free(trail);
+  }
+
+  //rooms
+  if(cp.ok && get_u32(&cp) != (uint32_t)house->room_count){
+    cp.ok = false;
+  }
+  for(int i = 0; cp.ok && i < house->room_count; i++){
+    struct Room* room = &house->rooms[i];
+    room->evidence = (EvidenceByte)get_u32(&cp);
+    for(int d = 0; d < EVIDENCE_TYPE_COUNT; d++){
+      room->swept[d] = get_u64(&cp);
+    }
+    uint32_t occupants = get_u32(&cp);
+    if(occupants > MAX_ROOM_OCCUPANCY){
+      cp.ok = false;
+      break;
+    }
+    for(uint32_t j = 0; cp.ok && j < occupants; j++){
+      uint32_t hunter = get_u32(&cp);
+      if(hunter >= hunter_count){
+        cp.ok = false;
+        break;
+      }
+      room->hunters[j] = &house->hunters[hunter];
+    }
+    room->hunter_count = (int)occupants;
+  }
+
+  if(get_u32(&cp) != CHECKPOINT_MAGIC){
+    cp.ok = false;
+  }
+  fclose(cp.file);
+
+  if(!cp.ok){
+    fprintf(stderr, "Checkpoint %s is damaged\n", path);
+  }
+  return cp.ok;
+}
@@ -0,0 +1,71 @@
+#!/bin/sh
+# Compares the throughput of the build variants made by `make compare`.
+# Every variant's ghost_bench_macro runs the same seeded matrix; the report
+# lists simulations/sec per cell and each variant's speedup over baseline.
+#
+# Usage: ./compare_builds.sh [--runs N] [--hunters LIST] [--layouts LIST]
+
+set -e
+
+RUNS=200
+HUNTERS=1,8,64
+LAYOUTS=willow,grid:4x6
+VARIANTS="baseline release lto pgo quiet"
+
+while [ $# -gt 0 ]; do
+  case "$1" in
+    --runs) RUNS=$2; shift 2 ;;
+    --hunters) HUNTERS=$2; shift 2 ;;
+    --layouts) LAYOUTS=$2; shift 2 ;;
+    *) echo "unknown option $1" >&2; exit 1 ;;
+  esac
+done
+
+COMMIT=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+OUT=build/compare_$COMMIT.csv
+rm -f "$OUT"
+
+for variant in $VARIANTS; do
+  bin=build/$variant/ghost_bench_macro
+  if [ ! -x "$bin" ]; then
+    echo "missing $bin, run make $variant first" >&2
+    exit 1
+  fi
+  echo "running $variant..." >&2
+  # the variant name rides along in the commit column
+  "$bin" --commit "$COMMIT-$variant" --format csv --out "$OUT" \
+    --runs "$RUNS" --hunters "$HUNTERS" --layouts "$LAYOUTS" --log-modes none 2>/dev/null
+done
+
+awk -F, -v variants="$VARIANTS" '
+  # columns are looked up by name so new ones can be added anywhere
+  NR == 1 { for (i = 1; i <= NF; i++) col[$i] = i; next }
+  {
+    n = split($col["commit"], parts, "-"); variant = parts[n]
+    cell = $col["layout"] " x" $col["hunters"]
+    if (!(cell in seen)) { seen[cell] = 1; cells[++ncells] = cell }
+    rate[cell, variant] = $col["sims_per_sec"]
+  }
+  END {
+    nv = split(variants, names, " ")
+    printf "%-20s", "sims/sec"
+    for (v = 1; v <= nv; v++) printf " %12s", names[v]
+    printf "\n"
+    for (c = 1; c <= ncells; c++) {
+      printf "%-20s", cells[c]
+      for (v = 1; v <= nv; v++) printf " %12.1f", rate[cells[c], names[v]]
+      printf "\n"
+    }
+    printf "%-20s", "geomean speedup"
+    for (v = 1; v <= nv; v++) {
+      logsum = 0; count = 0
+      for (c = 1; c <= ncells; c++) {
+        base = rate[cells[c], names[1]]; r = rate[cells[c], names[v]]
+        if (base > 0 && r > 0) { logsum += log(r / base); count++ }
+      }
+      printf " %11.2fx", count ? exp(logsum / count) : 0
+    }
+    printf "\n"
+  }' "$OUT"
+
+echo "raw results: $OUT" >&2
@@ -0,0 +1,847 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+   Function: config_init
+   Purpose:  Fills a config with the defaults used by an interactive run.
+   Params:
+    Output: struct SimConfig* config - the config to initialize
+   Return: void
+*/
+void config_init(struct SimConfig* config){
+  config->roster_path[0] = '\0';
+  config->hunter_count = 0;
+  strcpy(config->layout, "willow");
+  config->seed = 0;
+  config->has_seed = false;
+  config->runs = 1;
+  config->log_mode = LOG_MODE_CSV;
+  config->log_segment_bytes = 0;
+  config->log_keep_segments = 0;
+  config->log_budget_bytes = 1LL << 30;
+  config->console = CONSOLE_EVENTS;
+  config->stats_format = STATS_TEXT;
+  config->trace_path[0] = '\0';
+  config->jobs = 1;
+  config->pin_mode = PIN_OFF;
+  config->cpus[0] = '\0';
+  config->return_mode = RETURN_BREADCRUMBS;
+  config->swap_mode = SWAP_RANDOM;
+  config->explore_mode = EXPLORE_RANDOM;
+  config->device_mode = DEVICES_RANDOM;
+  config->early_exit = false;
+  config->boredom_max = ENTITY_BOREDOM_MAX;
+  config->fear_max = HUNTER_FEAR_MAX;
+  config->occupancy = MAX_ROOM_OCCUPANCY;
+  config->return_chance = HUNTER_RETURN_CHANCE;
+  for(int i = 0; i < 3; i++){
+    config->ghost_weights[i] = GHOST_ACTION_WEIGHT;
+  }
+  config->monitor = false;
+  config->metrics_name[0] = '\0';
+  config->schedule = SCHEDULE_THREADS;
+  config->checkpoint_path[0] = '\0';
+  config->checkpoint_round = 0;
+  config->resume_path[0] = '\0';
+  config->exact_states = 0;
+}
+
+/*
+   Function: parse_int
+   Purpose:  Parses a whole decimal string into an int.
+   Params:
+    Input: const char* text - the text to parse
+    Output: long* out - the parsed value
+   Return: bool - true if the whole string was a number
+*/
+static bool parse_int(const char* text, long* out){
+  char* end = NULL;
+  long value = strtol(text, &end, 10);
+  if(end == text || *end != '\0'){
+    return false;
+  }
+  *out = value;
+  return true;
+}
+
+/*
+   Function: parse_size
+   Purpose:  Parses a byte count with an optional K, M or G suffix (powers of 1024).
+   Params:
+    Input: const char* text - the text to parse, e.g. "64M"
+    Output: long long* out - the number of bytes
+   Return: bool - true if the whole string was a size
+*/
+static bool parse_size(const char* text, long long* out){
+  char* end = NULL;
+  long long value = strtoll(text, &end, 10);
+  if(end == text || value < 0){
+    return false;
+  }
+  int shift = 0;
+  switch(toupper((unsigned char)*end)){
+    case 'K': shift = 10; end++; break;
+    case 'M': shift = 20; end++; break;
+    case 'G': shift = 30; end++; break;
+    default: break;
+  }
+  if(*end != '\0' || value > (LLONG_MAX >> shift)){
+    return false;
+  }
+  *out = value << shift;
+  return true;
+}
+
+/*
+   Function: config_set
+   Purpose:  Applies one option by name. Shared by the config file and the
+   command line so both accept exactly the same keys.
+   Params:
+    Input/Output: struct SimConfig* config - the config to update
+    Input: const char* key - option name without leading dashes
+    Input: const char* value - option value
+   Return: bool - true if the key was known and the value valid
+*/
+bool config_set(struct SimConfig* config, const char* key, const char* value){
+  long number;
+
+  if(strcmp(key, "roster") == 0){
+    if(strlen(value) >= MAX_PATH_LENGTH){
+      return false;
+    }
+    strcpy(config->roster_path, value);
+    return true;
+  }
+
+  if(strcmp(key, "hunters") == 0){
+    if(!parse_int(value, &number) || number < 0 || number > 10000000){
+      return false;
+    }
+    config->hunter_count = (int)number;
+    return true;
+  }
+
+  if(strcmp(key, "layout") == 0){
+    if(strlen(value) >= MAX_LAYOUT_NAME){
+      return false;
+    }
+    strcpy(config->layout, value);
+    return true;
+  }
+
+  if(strcmp(key, "seed") == 0){
+    char* end = NULL;
+    unsigned long seed = strtoul(value, &end, 10);
+    if(end == value || *end != '\0'){
+      return false;
+    }
+    config->seed = (unsigned)seed;
+    config->has_seed = true;
+    return true;
+  }
+
+  if(strcmp(key, "runs") == 0){
+    if(!parse_int(value, &number) || number < 1 || number > 1000000000){
+      return false;
+    }
+    config->runs = (int)number;
+    return true;
+  }
+
+  if(strcmp(key, "jobs") == 0){
+    if(!parse_int(value, &number) || number < 1 || number > 1024){
+      return false;
+    }
+    config->jobs = (int)number;
+    return true;
+  }
+
+  if(strcmp(key, "pin") == 0){
+    if(strcmp(value, "off") == 0){
+      config->pin_mode = PIN_OFF;
+    }else if(strcmp(value, "domain") == 0){
+      config->pin_mode = PIN_DOMAIN;
+    }else if(strcmp(value, "cores") == 0){
+      config->pin_mode = PIN_CORES;
+    }else{
+      return false;
+    }
+    return true;
+  }
+
+  //the CPUs themselves are checked against the machine by affinity_setup
+  if(strcmp(key, "cpus") == 0){
+    if(value[0] == '\0' || strlen(value) >= MAX_PATH_LENGTH - 1 || strspn(value, "0123456789,-") != strlen(value)){
+      return false;
+    }
+    strcpy(config->cpus, value);
+    return true;
+  }
+
+  if(strcmp(key, "return") == 0){
+    if(strcmp(value, "breadcrumbs") == 0){
+      config->return_mode = RETURN_BREADCRUMBS;
+    }else if(strcmp(value, "shortest") == 0){
+      config->return_mode = RETURN_SHORTEST;
+    }else{
+      return false;
+    }
+    return true;
+  }
+
+  if(strcmp(key, "swap") == 0){
+    if(strcmp(value, "random") == 0){
+      config->swap_mode = SWAP_RANDOM;
+    }else if(strcmp(value, "informed") == 0){
+      config->swap_mode = SWAP_INFORMED;
+    }else{
+      return false;
+    }
+    return true;
+  }
+
+  if(strcmp(key, "devices") == 0){
+    if(strcmp(value, "random") == 0){
+      config->device_mode = DEVICES_RANDOM;
+    }else if(strcmp(value, "claimed") == 0){
+      config->device_mode = DEVICES_CLAIMED;
+    }else{
+      return false;
+    }
+    return true;
+  }
+
+  if(strcmp(key, "explore") == 0){
+    if(strcmp(value, "random") == 0){
+      config->explore_mode = EXPLORE_RANDOM;
+    }else if(strcmp(value, "coordinated") == 0){
+      config->explore_mode = EXPLORE_COORDINATED;
+    }else{
+      return false;
+    }
+    return true;
+  }
+
+  if(strcmp(key, "early-exit") == 0){
+    if(strcmp(value, "on") == 0){
+      config->early_exit = true;
+    }else if(strcmp(value, "off") == 0){
+      config->early_exit = false;
+    }else{
+      return false;
+    }
+    return true;
+  }
+
+  if(strcmp(key, "boredom-max") == 0){
+    if(!parse_int(value, &number) || number < 0 || number > 1000000){
+      return false;
+    }
+    config->boredom_max = (int)number;
+    return true;
+  }
+
+  if(strcmp(key, "fear-max") == 0){
+    if(!parse_int(value, &number) || number < 0 || number > 1000000){
+      return false;
+    }
+    config->fear_max = (int)number;
+    return true;
+  }
+
+  if(strcmp(key, "occupancy") == 0){
+    if(!parse_int(value, &number) || number < 1 || number > MAX_ROOM_OCCUPANCY){
+      return false;
+    }
+    config->occupancy = (int)number;
+    return true;
+  }
+
+  if(strcmp(key, "return-chance") == 0){
+    if(!parse_int(value, &number) || number < 0 || number > 100){
+      return false;
+    }
+    config->return_chance = (int)number;
+    return true;
+  }
+
+  //three weights, idle,haunt,move, at least one of them positive
+  if(strcmp(key, "ghost-weights") == 0){
+    int weights[3];
+    char extra = '\0';
+    if(sscanf(value, "%d,%d,%d%c", &weights[0], &weights[1], &weights[2], &extra) != 3){
+      return false;
+    }
+    for(int i = 0; i < 3; i++){
+      if(weights[i] < 0 || weights[i] > 1000000){
+        return false;
+      }
+    }
+    if(weights[0] + weights[1] + weights[2] < 1){
+      return false;
+    }
+    memcpy(config->ghost_weights, weights, sizeof(weights));
+    return true;
+  }
+
+  if(strcmp(key, "monitor") == 0){
+    if(strcmp(value, "on") == 0){
+      config->monitor = true;
+    }else if(strcmp(value, "off") == 0){
+      config->monitor = false;
+    }else{
+      return false;
+    }
+    return true;
+  }
+
+  if(strcmp(key, "metrics") == 0){
+    if(strlen(value) >= MAX_PATH_LENGTH - 1 || strchr(value, '/') != NULL){
+      return false;
+    }
+    strcpy(config->metrics_name, value);
+    return true;
+  }
+
+  if(strcmp(key, "schedule") == 0){
+    if(strcmp(value, "threads") == 0){
+      config->schedule = SCHEDULE_THREADS;
+    }else if(strcmp(value, "lockstep") == 0){
+      config->schedule = SCHEDULE_LOCKSTEP;
+    }else{
+      return false;
+    }
+    return true;
+  }
+
+  if(strcmp(key, "checkpoint") == 0){
+    if(strlen(value) >= MAX_PATH_LENGTH){
+      return false;
+    }
+    strcpy(config->checkpoint_path, value);
+    return true;
+  }
+
+  if(strcmp(key, "resume") == 0){
+    if(strlen(value) >= MAX_PATH_LENGTH){
+      return false;
+    }
+    strcpy(config->resume_path, value);
+    return true;
+  }
+
+  if(strcmp(key, "checkpoint-round") == 0){
+    if(!parse_int(value, &number) || number < 0){
+      return false;
+    }
+    config->checkpoint_round = number;
+    return true;
+  }
+
+  if(strcmp(key, "exact") == 0){
+    if(!parse_int(value, &number) || number < 0 || number > 100000000){
+      return false;
+    }
+    config->exact_states = number;
+    return true;
+  }
+
+  if(strcmp(key, "log-mode") == 0){
+    if(strcmp(value, "csv") == 0){
+      config->log_mode = LOG_MODE_CSV;
+    }else if(strcmp(value, "none") == 0){
+      config->log_mode = LOG_MODE_NONE;
+    }else{
+      return false;
+    }
+    return true;
+  }
+
+  if(strcmp(key, "log-segment") == 0){
+    long long size;
+    if(!parse_size(value, &size)){
+      return false;
+    }
+    config->log_segment_bytes = size;
+    return true;
+  }
+
+  if(strcmp(key, "log-keep") == 0){
+    if(!parse_int(value, &number) || number < 0 || number > 1000000){
+      return false;
+    }
+    config->log_keep_segments = (int)number;
+    return true;
+  }
+
+  if(strcmp(key, "log-budget") == 0){
+    long long size;
+    if(!parse_size(value, &size)){
+      return false;
+    }
+    config->log_budget_bytes = size;
+    return true;
+  }
+
+  if(strcmp(key, "trace") == 0){
+    if(strlen(value) >= MAX_PATH_LENGTH){
+      return false;
+    }
+    strcpy(config->trace_path, value);
+    return true;
+  }
+
+  if(strcmp(key, "console") == 0){
+    if(strcmp(value, "events") == 0){
+      config->console = CONSOLE_EVENTS;
+    }else if(strcmp(value, "summary") == 0){
+      config->console = CONSOLE_SUMMARY;
+    }else if(strcmp(value, "silent") == 0){
+      config->console = CONSOLE_SILENT;
+    }else{
+      return false;
+    }
+    return true;
+  }
+
+  if(strcmp(key, "stats") == 0){
+    if(strcmp(value, "text") == 0){
+      config->stats_format = STATS_TEXT;
+    }else if(strcmp(value, "json") == 0){
+      config->stats_format = STATS_JSON;
+    }else if(strcmp(value, "none") == 0){
+      config->stats_format = STATS_NONE;
+    }else{
+      return false;
+    }
+    return true;
+  }
+
+  return false;
+}
+
+/*
+   Function: trim
+   Purpose:  Strips leading and trailing whitespace in place.
+   Params:
+    Input/Output: char* text - the string to trim
+   Return: char* - pointer to the first non-space character
+*/
+static char* trim(char* text){
+  while(isspace((unsigned char)*text)){
+    text++;
+  }
+  char* end = text + strlen(text);
+  while(end > text && isspace((unsigned char)end[-1])){
+    end--;
+  }
+  *end = '\0';
+  return text;
+}
+
+/*
+   Function: config_load_file
+   Purpose:  Reads "key = value" lines into the config. Blank lines and lines
+   starting with '#' are ignored.
+   Params:
+    Input/Output: struct SimConfig* config - the config to update
+    Input: const char* path - the config file to read
+   Return: bool - true if the file was read and every line was valid
+*/
+bool config_load_file(struct SimConfig* config, const char* path){
+  FILE* file = fopen(path, "r");
+  if(file == NULL){
+    fprintf(stderr, "Cannot open config file %s\n", path);
+    return false;
+  }
+
+  char line[512];
+  int line_number = 0;
+  bool ok = true;
+
+  while(fgets(line, sizeof(line), file) != NULL){
+    line_number++;
+    char* text = trim(line);
+    if(text[0] == '\0' || text[0] == '#'){
+      continue;
+    }
+
+    char* equals = strchr(text, '=');
+    if(equals == NULL){
+      fprintf(stderr, "%s:%d: expected key = value\n", path, line_number);
+      ok = false;
+      break;
+    }
+
+    *equals = '\0';
+    char* key = trim(text);
+    char* value = trim(equals + 1);
+    if(!config_set(config, key, value)){
+      fprintf(stderr, "%s:%d: invalid setting '%s'\n", path, line_number, key);
+      ok = false;
+      break;
+    }
+  }
+
+  fclose(file);
+  return ok;
+}
+
+/*
+   Function: config_parse_args
+   Purpose:  Builds the config from the command line. A --config file is
+   applied first so that any other flag overrides it. Flags take the form
+   --key value or --key=value.
+   Params:
+    Input/Output: struct SimConfig* config - the config to fill (already initialized)
+    Input: int argc - argument count from main
+    Input: char** argv - argument vector from main
+   Return: bool - true if every argument was understood
+*/
+bool config_parse_args(struct SimConfig* config, int argc, char** argv){
+  //first pass: only the config file
+  for(int i = 1; i < argc; i++){
+    if(strcmp(argv[i], "--config") == 0 && i + 1 < argc){
+      if(!config_load_file(config, argv[i + 1])){
+        return false;
+      }
+      i++;
+    }else if(strncmp(argv[i], "--config=", 9) == 0){
+      if(!config_load_file(config, argv[i] + 9)){
+        return false;
+      }
+    }
+  }
+
+  //second pass: everything else overrides the file
+  for(int i = 1; i < argc; i++){
+    const char* arg = argv[i];
+    if(strncmp(arg, "--", 2) != 0){
+      fprintf(stderr, "Unexpected argument '%s'\n", arg);
+      return false;
+    }
+
+    char key[64];
+    const char* value = NULL;
+    const char* equals = strchr(arg, '=');
+    if(equals != NULL){
+      size_t length = (size_t)(equals - arg - 2);
+      if(length >= sizeof(key)){
+        return false;
+      }
+      memcpy(key, arg + 2, length);
+      key[length] = '\0';
+      value = equals + 1;
+    }else{
+      if(strlen(arg + 2) >= sizeof(key) || i + 1 >= argc){
+        fprintf(stderr, "Missing value for '%s'\n", arg);
+        return false;
+      }
+      strcpy(key, arg + 2);
+      value = argv[++i];
+    }
+
+    if(strcmp(key, "config") == 0){
+      continue;
+    }
+    if(!config_set(config, key, value)){
+      fprintf(stderr, "Invalid option --%s %s\n", key, value);
+      return false;
+    }
+  }
+
+  //a checkpoint is one hunt between two lockstep rounds
+  if(config->checkpoint_path[0] != '\0' || config->resume_path[0] != '\0'){
+    if(config->runs != 1){
+      fprintf(stderr, "--checkpoint and --resume need a single run\n");
+      return false;
+    }
+    config->schedule = SCHEDULE_LOCKSTEP;
+  }
+
+  //the exact model is built for the compiled-in limits and the random modes;
+  //solving it for other options would silently answer a different question
+  if(config->exact_states > 0){
+    const char* ignored = NULL;
+    if(config->boredom_max != ENTITY_BOREDOM_MAX){
+      ignored = "--boredom-max";
+    }else if(config->fear_max != HUNTER_FEAR_MAX){
+      ignored = "--fear-max";
+    }else if(config->return_chance != HUNTER_RETURN_CHANCE){
+      ignored = "--return-chance";
+    }else if(config->ghost_weights[0] != GHOST_ACTION_WEIGHT || config->ghost_weights[1] != GHOST_ACTION_WEIGHT ||
+             config->ghost_weights[2] != GHOST_ACTION_WEIGHT){
+      ignored = "--ghost-weights";
+    }else if(config->swap_mode != SWAP_RANDOM){
+      ignored = "--swap";
+    }else if(config->device_mode != DEVICES_RANDOM){
+      ignored = "--devices";
+    }else if(config->explore_mode != EXPLORE_RANDOM){
+      ignored = "--explore";
+    }else if(config->early_exit){
+      ignored = "--early-exit";
+    }
+    if(ignored != NULL){
+      fprintf(stderr, "--exact only models the default %s; drop it to solve\n", ignored);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+   Function: config_print_usage
+   Purpose:  Prints the supported options to stderr.
+   Params:
+    Input: const char* program - the program name (argv[0])
+   Return: void
+*/
+void config_print_usage(const char* program){
+  fprintf(stderr,
+	  "Usage: %s [options]\n"
+	  "  --config FILE      read key = value options from FILE\n"
+	  "  --roster FILE      hunters as 'name id' lines (skips the prompts)\n"
+	  "  --hunters N        generate N hunters named Hunter1..HunterN\n"
+	  "  --layout NAME      willow (default), grid:RxC or corridor:N\n"
+	  "  --seed N           base seed for reproducible entity RNG streams\n"
+	  "  --runs N           number of hunts to simulate (default 1)\n"
+	  "  --jobs N           run hunts on N worker threads, summary only (default 1)\n"
+	  "  --pin MODE         off (default), domain: keep each hunt on one NUMA node/L3, or cores\n"
+	  "  --cpus LIST        pin within these CPUs, e.g. 0-7,16-23 (default all allowed)\n"
+	  "  --return MODE      breadcrumbs (default) or shortest path back to the van\n"
+	  "  --swap MODE        random (default) or informed device swaps at the van\n"
+	  "  --devices MODE     random (default) or claimed: hunters avoid devices a teammate holds\n"
+	  "  --explore MODE     random (default) or coordinated: prefer rooms the team searched longest ago\n"
+	  "  --early-exit on    end the run as soon as it is solved or nothing is left to find\n"
+	  "  --boredom-max N    leave once boredom passes N (default 15)\n"
+	  "  --fear-max N       hunters leave afraid once fear passes N (default 15)\n"
+	  "  --occupancy N      hunters per room, 1-8 (default 8)\n"
+	  "  --return-chance N  percent chance a hunter who found nothing heads back (default 10)\n"
+	  "  --ghost-weights I,H,M  relative odds of the ghost idling, haunting, moving (default 1,1,1)\n"
+	  "  --monitor on       print a live status line to stderr every second\n"
+	  "  --metrics NAME     publish live counters in /dev/shm/NAME (read with ghost_metrics)\n"
+	  "  --schedule MODE    threads (default) or lockstep: one thread, reproducible rounds\n"
+	  "  --checkpoint FILE  save the hunt to FILE after --checkpoint-round N rounds (lockstep)\n"
+	  "  --resume FILE      continue a hunt saved with --checkpoint (lockstep)\n"
+	  "  --exact N          solve small layouts exactly (1-2 hunters, up to N states)\n"
+	  "  --log-mode MODE    csv (default) or none\n"
+	  "  --log-segment SIZE start log_<id>.<n>.csv when a log reaches SIZE (e.g. 64M; 0 never)\n"
+	  "  --log-keep N       keep only each entity's newest N segments (default 0, all)\n"
+	  "  --log-budget SIZE  stop writing logs past SIZE in total; the hunt goes on (default 1G, 0 none)\n"
+	  "  --console LEVEL    stdout shows events (default), summary or silent\n"
+	  "  --stats FORMAT     step counters as text (default), json or none\n"
+	  "  --trace FILE       write a Chrome/Perfetto trace of every thread to FILE\n"
+	  "With no roster and no hunter count the hunters are read from stdin.\n",
+	  program);
+}
+
+/*
+   Function: roster_init
+   Purpose:  Initializes an empty roster.
+   Params:
+    Output: struct Roster* roster - the roster to initialize
+   Return: void
+*/
+void roster_init(struct Roster* roster){
+  roster->entries = NULL;
+  roster->count = 0;
+  roster->capacity = 0;
+}
+
+/*
+   Function: roster_add
+   Purpose:  Appends a hunter to the roster, growing the array when full.
+   Params:
+    Input/Output: struct Roster* roster - the roster to append to
+    Input: const char* name - the hunter's name (truncated to fit)
+    Input: int id - the hunter's ID
+   Return: bool - false if memory ran out
+*/
+bool roster_add(struct Roster* roster, const char* name, int id){
+  if(roster->count >= roster->capacity){
+    int capacity = roster->capacity ? roster->capacity * 2 : 16;
+    struct RosterEntry* entries = realloc(roster->entries, (size_t)capacity * sizeof(struct RosterEntry));
+    if(entries == NULL){
+      return false;
+    }
+    roster->entries = entries;
+    roster->capacity = capacity;
+  }
+
+  struct RosterEntry* entry = &roster->entries[roster->count];
+  strncpy(entry->name, name, MAX_HUNTER_NAME - 1);
+  entry->name[MAX_HUNTER_NAME - 1] = '\0';
+  entry->id = id;
+  roster->count++;
+  return true;
+}
+
+/*
+   Function: roster_load_file
+   Purpose:  Maps a roster file and parses it in one pass. Each line is a
+   hunter name followed by an integer ID, separated by spaces, tabs or a
+   comma. Blank lines and '#' comments are skipped.
+   Params:
+    Input/Output: struct Roster* roster - the roster to append to
+    Input: const char* path - the roster file
+   Return: bool - true if the whole file parsed
+*/
+bool roster_load_file(struct Roster* roster, const char* path){
+  int fd = open(path, O_RDONLY);
+  if(fd < 0){
+    fprintf(stderr, "Cannot open roster %s\n", path);
+    return false;
+  }
+
+  struct stat info;
+  if(fstat(fd, &info) != 0){
+    close(fd);
+    return false;
+  }
+  if(info.st_size == 0){
+    close(fd);
+    return true;
+  }
+
+  const char* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED){
+    fprintf(stderr, "Cannot map roster %s\n", path);
+    return false;
+  }
+  madvise((void*)data, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+  //rough size guess so the array grows at most a couple of times
+  int guess = (int)(info.st_size / 12) + 1;
+  if(roster->capacity < roster->count + guess){
+    struct RosterEntry* entries = realloc(roster->entries, (size_t)(roster->count + guess) * sizeof(struct RosterEntry));
+    if(entries != NULL){
+      roster->entries = entries;
+      roster->capacity = roster->count + guess;
+    }
+  }
+
+  const char* p = data;
+  const char* end = data + info.st_size;
+  int line_number = 0;
+  bool ok = true;
+  char name[MAX_HUNTER_NAME];
+
+  while(p < end && ok){
+    line_number++;
+
+    //skip leading blanks
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')){
+      p++;
+    }
+    if(p >= end){
+      break;
+    }
+    if(*p == '\n'){
+      p++;
+      continue;
+    }
+    if(*p == '#'){
+      while(p < end && *p != '\n'){
+        p++;
+      }
+      continue;
+    }
+
+    //name runs up to the separator
+    int length = 0;
+    while(p < end && *p != ' ' && *p != '\t' && *p != ',' && *p != '\n' && *p != '\r'){
+      if(length < MAX_HUNTER_NAME - 1){
+        name[length++] = *p;
+      }
+      p++;
+    }
+    name[length] = '\0';
+
+    while(p < end && (*p == ' ' || *p == '\t' || *p == ',')){
+      p++;
+    }
+
+    //then the id
+    bool negative = false;
+    if(p < end && *p == '-'){
+      negative = true;
+      p++;
+    }
+    long id = 0;
+    int digits = 0;
+    while(p < end && *p >= '0' && *p <= '9' && id <= 100000000L){
+      id = id * 10 + (*p - '0');
+      digits++;
+      p++;
+    }
+
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')){
+      p++;
+    }
+
+    if(digits == 0 || (p < end && *p != '\n') || id > 100000000L){
+      fprintf(stderr, "%s:%d: expected 'name id'\n", path, line_number);
+      ok = false;
+      break;
+    }
+    if(p < end){
+      p++;
+    }
+
+    if(!roster_add(roster, name, negative ? (int)-id : (int)id)){
+      ok = false;
+    }
+  }
+
+  munmap((void*)data, (size_t)info.st_size);
+  return ok;
+}
+
+/*
+   Function: roster_generate
+   Purpose:  Appends count hunters named Hunter1..HunterN with IDs counting up
+   from 1. The ghost's ID is skipped so no two entities share a log file.
+   Params:
+    Input/Output: struct Roster* roster - the roster to append to
+    Input: int count - how many hunters to generate
+   Return: bool - false if memory ran out
+*/
+bool roster_generate(struct Roster* roster, int count){
+  char name[MAX_HUNTER_NAME];
+  int id = 0;
+
+  for(int i = 0; i < count; i++){
+    id++;
+    if(id == DEFAULT_GHOST_ID){
+      id++;
+    }
+    snprintf(name, sizeof(name), "Hunter%d", i + 1);
+    if(!roster_add(roster, name, id)){
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+   Function: roster_cleanup
+   Purpose:  Frees the roster's entries.
+   Params:
+    Input/Output: struct Roster* roster - the roster to clean up
+   Return: void
+*/
+void roster_cleanup(struct Roster* roster){
+  free(roster->entries);
+  roster_init(roster);
+}
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <semaphore.h>
 #include <pthread.h>
+#include <stdint.h>
 
 /*
   You are free to rename all of the types and functions defined here.
@@ -13,12 +14,37 @@
 
 #define MAX_ROOM_NAME 64
 #define MAX_HUNTER_NAME 64
-#define MAX_ROOMS 24
+#define MAX_ROOMS 64
 #define MAX_ROOM_OCCUPANCY 8
 #define MAX_CONNECTIONS 8
+#define EVIDENCE_TYPE_COUNT 7
 #define ENTITY_BOREDOM_MAX 15
 #define HUNTER_FEAR_MAX 15
+#define HUNTER_RETURN_CHANCE 10   //percent: a hunter who found nothing heads back anyway
+#define GHOST_ACTION_WEIGHT 1     //default weight of each ghost action (idle, haunt, move)
 #define DEFAULT_GHOST_ID 68057
+#define MAX_LAYOUT_NAME 32
+#define MAX_PATH_LENGTH 256
+#define HUNTER_THREAD_STACK (256 * 1024)
+#define SKETCH_SUB_BUCKETS 16
+#define SKETCH_OCTAVES 48
+#define SKETCH_BUCKETS (1 + SKETCH_OCTAVES * SKETCH_SUB_BUCKETS)
+#define AGGREGATE_GHOST_TYPES 24
+#define AGGREGATE_EXIT_REASONS 3
+#define MARKOV_MAX_ROOMS 8
+#define MARKOV_MAX_HUNTERS 2
+#define ROUTE_UNREACHABLE 255
+#define MONITOR_TICK_MS 100
+#define MONITOR_INTERVAL_MS 1000
+#define METRICS_MAGIC 0x31534349525445ULL  //"ETRICS1" little-endian, set last
+#define METRICS_LAYOUT 1
+#define METRICS_SLOTS 64
+#define METRICS_STEP_BATCH 256
+#define CHECKPOINT_MAGIC 0x4B434847u  //"GHCK" little-endian, first and last word of the file
+#define CHECKPOINT_VERSION 6
+
+//a step helper inlined into every specialised step, where constant limits fold away
+#define STEP_INLINE static inline __attribute__((always_inline))
 
 typedef unsigned char EvidenceByte; // Just giving a helpful name to unsigned char for evidence bitmasks
 
@@ -28,6 +54,63 @@ enum LogReason {
   LR_AFRAID = 2
 };
 
+//How main() reports the step counters after each run
+enum StatsFormat {
+  STATS_TEXT = 0,
+  STATS_JSON = 1,
+  STATS_NONE = 2
+};
+
+//How a hunter heading back to the van picks its next room
+enum ReturnMode {
+  RETURN_BREADCRUMBS = 0,  //retrace the rooms it came through (default)
+  RETURN_SHORTEST = 1      //follow the room's precomputed next hop
+};
+
+//How a hunter at the van picks its next device
+enum SwapMode {
+  SWAP_RANDOM = 0,   //any device at random (default)
+  SWAP_INFORMED = 1  //the device that best splits the remaining candidate ghosts
+};
+
+//How hunters share out devices
+enum DeviceMode {
+  DEVICES_RANDOM = 0,  //each hunter picks on its own (default)
+  DEVICES_CLAIMED = 1  //prefer devices no teammate holds and whose evidence is still missing
+};
+
+//How an exploring hunter picks the next room
+enum ExploreMode {
+  EXPLORE_RANDOM = 0,      //any connected room at random (default)
+  EXPLORE_COORDINATED = 1  //the neighbour the team searched longest ago with this device
+};
+
+//Where the simulation threads may run
+enum PinMode {
+  PIN_OFF = 0,     //wherever the scheduler puts them (default)
+  PIN_DOMAIN = 1,  //each hunt's threads share one NUMA node and L3
+  PIN_CORES = 2    //each thread on its own CPU of its hunt's domain
+};
+
+//How simulation_run drives the entities
+enum Schedule {
+  SCHEDULE_THREADS = 0,  //one thread per entity, free running (default)
+  SCHEDULE_LOCKSTEP = 1  //one thread stepping the ghost then each hunter every round; reproducible
+};
+
+//Where log records go, set once before any threads start
+enum LogMode {
+  LOG_MODE_CSV = 0,  //append to log_<id>.csv (default)
+  LOG_MODE_NONE = 1  //skip the CSV files entirely
+};
+
+//How much goes to stdout
+enum ConsoleLevel {
+  CONSOLE_EVENTS = 0,   //every logged event plus the results (default)
+  CONSOLE_SUMMARY = 1,  //results, counters and batch summary only
+  CONSOLE_SILENT = 2    //nothing but errors and interactive prompts
+};
+
 enum EvidenceType {
   EV_EMF          = 1 << 0,
   EV_ORBS         = 1 << 1,
@@ -68,6 +151,12 @@ enum GhostType {
 struct CaseFile {
   EvidenceByte collected; // Union of all of the evidence bits collected between all hunters
   bool         solved;    // True when >=3 unique bits set
+  unsigned     candidates; // Ghosts still consistent with collected, bit i = get_all_ghost_types()[i]
+  int          pending;   // Evidence bits lying in rooms, atomic
+  bool         ghost_gone; // Set by the ghost as it leaves, atomic
+  bool         cancelled; // The hunt is decided and every thread should leave, atomic
+  unsigned long sweep_clock; // Searches so far in coordinated exploration, stamps Room.swept, atomic
+  EvidenceByte claimed;   // Devices a hunter holds exclusively in claimed device mode, atomic
   sem_t        mutex;     // Used for synchronizing both fields when multithreading
 };
 
@@ -103,8 +192,202 @@ struct Room {
   //Evidence in this room, bitmask
   EvidenceByte evidence;
 
+  //Shortest route home, built with the layout (NULL and 0 in the van, -1 if unreachable)
+  struct Room* van_next_hop;
+  int van_distance;
+
   //thread synchronization
   sem_t mutex;
+
+  //seqlock over ghost, hunter_count and evidence: odd while a writer
+  //holding mutex is changing them, so readers can skip the mutex
+  unsigned seq;
+
+  //coordinated exploration: the sweep clock when a hunter last searched
+  //here with each device (by bit position), 0 if never; atomic, no lock
+  unsigned long swept[EVIDENCE_TYPE_COUNT];
+};
+
+//Consistent copy of a room's read-mostly fields, see room_snapshot
+struct RoomSnapshot {
+  struct Ghost* ghost;
+  int hunter_count;
+  EvidenceByte evidence;
+};
+
+//Counters owned by one hunter thread, only read after it has been joined
+struct HunterStats {
+  unsigned long iterations;     //hunter_thread loop passes
+  unsigned long moves;          //successful hunter_move calls
+  unsigned long moves_full;     //hunter_move refused because the room was full
+  unsigned long evidence;       //evidence picked up with the current device
+  unsigned long van_returns;    //completed trips back to the van
+  unsigned long device_swaps;   //devices swapped at the van
+};
+
+//Counters owned by the ghost thread
+struct GhostStats {
+  unsigned long iterations;     //ghost_thread loop passes
+  unsigned long idles;          //chose to do nothing
+  unsigned long haunts;         //left a piece of evidence
+  unsigned long moves;          //moved to another room
+  unsigned long moves_blocked;  //wanted to move but hunters were in the room
+};
+
+//Totals for one or more runs, merged from every entity after the threads finish
+struct SimStats {
+  unsigned long runs;
+  unsigned long hunters;
+  unsigned long solved;
+  struct HunterStats hunter;
+  struct GhostStats ghost;
+};
+
+//Running mean and variance (Welford), mergeable between workers
+struct Welford {
+  unsigned long count;
+  double mean;
+  double m2;  //sum of squared distances from the mean
+};
+
+//Fixed-size log-linear histogram for quantiles, mergeable by adding buckets
+struct QuantileSketch {
+  unsigned long buckets[SKETCH_BUCKETS];
+  unsigned long count;
+  double min;
+  double max;
+};
+
+//Outcomes for one ghost type across a batch
+struct GhostTally {
+  unsigned long runs;
+  unsigned long solved;
+  unsigned long identified;  //collected evidence named the right ghost
+};
+
+//Constant-size summary of any number of finished runs
+struct Aggregate {
+  unsigned long runs;
+  unsigned long solved;
+  unsigned long unreturned;  //evidence named the ghost but no hunter brought it to the van
+  unsigned long exits[AGGREGATE_EXIT_REASONS];  //hunter exits by LogReason
+  struct Welford duration_us;
+  struct Welford steps_to_solve;                //team loop passes until the solve, solved runs only
+  struct QuantileSketch duration_sketch;
+  struct QuantileSketch steps_sketch;
+  struct GhostTally ghosts[AGGREGATE_GHOST_TYPES]; //indexed like get_all_ghost_types
+};
+
+//Exact answer from the reduced Markov model (markov.c)
+struct MarkovResult {
+  double solved;      //probability the case gets solved
+  double evidence;    //expected share of hunters leaving with the evidence
+  double bored;       //... leaving bored
+  double afraid;      //... leaving afraid
+  double rounds;      //expected rounds until every hunter has left
+  size_t states;
+  size_t transitions;
+  int sweeps;         //Gauss-Seidel sweeps until convergence
+  bool capped;        //the state cap was reached before exploring finished
+};
+
+//Per-run behaviour options, owned by the House and shared read-only by its entities
+struct SimParams {
+  enum ReturnMode return_mode;
+  enum SwapMode swap_mode;
+  enum ExploreMode explore_mode;
+  enum DeviceMode device_mode;
+  bool early_exit;  //stop every thread as soon as the hunt is decided
+  int boredom_max;  //hunters and the ghost leave once boredom passes this
+  int fear_max;     //hunters leave afraid once fear passes this
+  int occupancy;    //hunters a room holds, at most MAX_ROOM_OCCUPANCY
+  int return_chance; //percent chance an empty search sends a hunter back
+  int idle_weight;  //relative odds of the ghost's three actions
+  int haunt_weight;
+  int move_weight;
+  bool tuned;       //a limit above differs from defs.h, so entities take the general step
+  bool monitor;     //run a monitor thread printing live status to stderr
+  enum Schedule schedule;
+  const char* checkpoint_path;    //lockstep only: save the hunt here, NULL when off
+  unsigned long checkpoint_round; //... once this many rounds have run
+};
+
+//One room as seen by the monitor
+struct RoomView {
+  int hunter_count;
+  EvidenceByte evidence;
+  bool has_ghost;
+};
+
+//Everything the monitor captures in one pass over a running house
+struct WorldSnapshot {
+  long long taken_ns;
+  int room_count;
+  struct RoomView rooms[MAX_ROOMS];
+  int ghost_room;          //room index, -1 once the ghost has left
+  int busiest_room;        //room index with the most hunters
+  int room_evidence;       //evidence bits lying in rooms
+  int hunter_count;
+  int hunters_active;
+  int hunters_returning;
+  long fear_total;         //over active hunters
+  int fear_max;
+  long boredom_total;
+  int boredom_max;
+  EvidenceByte collected;
+  bool solved;
+  unsigned candidates;
+};
+
+//Progress of one batch worker in the metrics region, one cache line each
+struct MetricsSlot {
+  uint64_t runs_completed;
+  uint64_t steps;
+  uint64_t reserved[6];
+};
+
+//Fixed layout of /dev/shm/<name>; readers check magic, layout and size
+struct MetricsRegion {
+  uint64_t magic;
+  uint32_t layout;
+  uint32_t size;
+  int32_t pid;
+  int32_t slot_count;
+  int32_t finished;        //set when the simulator is done
+  int32_t reserved;
+  int64_t started_ns;      //CLOCK_MONOTONIC
+  uint64_t runs_target;
+  uint64_t runs_completed;
+  uint64_t runs_solved;
+  uint64_t steps __attribute__((aligned(64)));  //hot: entity loop passes
+  uint64_t lock_contended __attribute__((aligned(64)));
+  uint64_t lock_wait_ns;
+  struct MetricsSlot slots[METRICS_SLOTS] __attribute__((aligned(64)));
+};
+
+//Head of one stream in a k-way merge
+struct TimelineEntry {
+  long long timestamp;
+  int source;              //stream index, breaks ties
+};
+
+//Min-heap over the stream heads, earliest (timestamp, source) on top
+struct TimelineHeap {
+  struct TimelineEntry* entries;
+  int count;
+  int capacity;
+};
+
+//Live observer: the monitor thread fills buffers[version & 1] alternately
+struct Monitor {
+  struct House* house;
+  struct WorldSnapshot buffers[2];
+  unsigned version;        //published captures, atomic; 0 until the first
+  unsigned seqs[2];        //per-buffer sequence, odd while a capture fills it, atomic
+  bool stop;               //atomic
+  bool running;
+  long long started_ns;
+  pthread_t thread;
 };
 
 //Hunter struct
@@ -116,8 +399,9 @@ struct Hunter {
   struct Room* current_room;
   struct CaseFile* casefile;
 
-  //What device do they have
+  //What device do they have, and do they own its bit in casefile->claimed
   enum EvidenceType device;
+  bool device_claimed;
 
   //Trail to what they've went to
   struct RoomStack path;
@@ -130,6 +414,21 @@ struct Hunter {
   bool should_exit;
   bool return_to_van;
   enum LogReason exit_reason;
+
+  //Seed for this hunter's RNG stream, 0 to seed from the clock, and the
+  //stream itself, which whoever steps the hunter binds with rand_bind_thread
+  unsigned rng_seed;
+  unsigned rng_state;
+
+  //Options for this run, NULL for the defaults
+  const struct SimParams* params;
+
+  //What this hunter did, merged by stats_collect once the thread is joined
+  struct HunterStats stats;
+
+  //Loop passes taken before this hunter saw the case solved, valid once solve_seen
+  unsigned long solve_steps;
+  bool solve_seen;
 };
 
 // Implement here based on the requirements, should be allocated to the House structure
@@ -139,6 +438,61 @@ struct Ghost {
   struct Room* current_room; //Where is this ghost
   int boredom;
   bool has_exited; //has the ghost left
+  unsigned rng_seed; //Seed for the ghost's RNG stream, 0 to seed from the clock
+  unsigned rng_state; //The stream itself, bound by whoever steps the ghost
+  struct CaseFile* casefile; //Shared case file, for early termination
+  const struct SimParams* params; //Options for this run
+  struct GhostStats stats; //What the ghost did, merged by stats_collect
+};
+
+//One hunter from a roster file, a generated roster or the prompts
+struct RosterEntry {
+  char name[MAX_HUNTER_NAME];
+  int id;
+};
+
+//Growable list of hunters to add to every run
+struct Roster {
+  struct RosterEntry* entries;
+  int count;
+  int capacity;
+};
+
+//Startup options from the command line and/or a config file
+struct SimConfig {
+  char roster_path[MAX_PATH_LENGTH]; //empty when no roster file was given
+  int hunter_count;                  //generate this many hunters when > 0
+  char layout[MAX_LAYOUT_NAME];      //willow, grid:RxC or corridor:N
+  unsigned seed;                     //base seed, only used when has_seed
+  bool has_seed;
+  int runs;                          //number of hunts to simulate back to back
+  enum LogMode log_mode;
+  long long log_segment_bytes;       //rotate each entity's log at this size, 0 never
+  int log_keep_segments;             //segments kept per entity, 0 all
+  long long log_budget_bytes;        //stop writing logs past this total, 0 unlimited
+  enum ConsoleLevel console;         //what reaches stdout
+  enum StatsFormat stats_format;     //how the step counters are printed
+  char trace_path[MAX_PATH_LENGTH];  //Chrome trace output, empty when tracing is off
+  int jobs;                          //worker threads running hunts side by side
+  enum PinMode pin_mode;
+  char cpus[MAX_PATH_LENGTH];        //CPU list to pin within, empty for all allowed
+  enum ReturnMode return_mode;
+  enum SwapMode swap_mode;
+  enum ExploreMode explore_mode;
+  enum DeviceMode device_mode;
+  bool early_exit;
+  int boredom_max;                   //ENTITY_BOREDOM_MAX unless swept or overridden
+  int fear_max;                      //HUNTER_FEAR_MAX unless swept or overridden
+  int occupancy;                     //MAX_ROOM_OCCUPANCY unless lowered
+  int return_chance;                 //HUNTER_RETURN_CHANCE unless swept or overridden
+  int ghost_weights[3];              //idle, haunt, move; GHOST_ACTION_WEIGHT each by default
+  bool monitor;
+  char metrics_name[MAX_PATH_LENGTH]; //publish live counters in /dev/shm/<name>, empty when off
+  enum Schedule schedule;
+  char checkpoint_path[MAX_PATH_LENGTH]; //save the hunt here, empty when off
+  long checkpoint_round;             //... after this many lockstep rounds
+  char resume_path[MAX_PATH_LENGTH]; //continue a saved hunt instead of setting one up
+  long exact_states;                 //solve the Markov model with this state cap, 0 to simulate
 };
 
 // Can be either stack or heap allocated
@@ -158,6 +512,19 @@ struct House {
 
   //Which ghost is at this house
   struct Ghost ghost;
+
+  //Base seed for the entity RNG streams, 0 when seeded from the clock
+  unsigned seed;
+
+  //Layout name the rooms were built from, and lockstep rounds run so far
+  char layout[MAX_LAYOUT_NAME];
+  unsigned long round;
+
+  //Options shared by every entity in this run
+  struct SimParams params;
+
+  //Hops between any two rooms, ROUTE_UNREACHABLE when disconnected
+  unsigned char route_distance[MAX_ROOMS][MAX_ROOMS];
   
 };
 
@@ -175,6 +542,20 @@ void evidence_clear(EvidenceByte* ev, enum EvidenceType type);
 bool evidence_has(EvidenceByte ev, enum EvidenceType type);
 int evidence_count_bits(EvidenceByte ev);
 bool evidence_has_three_unique(EvidenceByte mask);
+unsigned evidence_ghosts_with(enum EvidenceType type);
+void evidence_collect(struct CaseFile* casefile, enum EvidenceType type);
+enum EvidenceType evidence_best_device(EvidenceByte collected, unsigned candidates);
+
+//CaseFile Functions
+void casefile_evidence_dropped(struct CaseFile* casefile);
+void casefile_evidence_taken(struct CaseFile* casefile, const struct SimParams* params);
+void casefile_ghost_left(struct CaseFile* casefile, const struct SimParams* params);
+void casefile_cancel(struct CaseFile* casefile, const struct SimParams* params);
+bool casefile_is_cancelled(struct CaseFile* casefile);
+unsigned long casefile_next_sweep(struct CaseFile* casefile);
+EvidenceByte casefile_claimed_devices(struct CaseFile* casefile);
+bool casefile_claim_device(struct CaseFile* casefile, enum EvidenceType device);
+void casefile_release_device(struct CaseFile* casefile, enum EvidenceType device);
 
 //Room Functions
 void room_init(struct Room* room, const char* name, bool is_exit);
@@ -183,6 +564,11 @@ void room_add_evidence(struct Room* room, enum EvidenceType evidence);
 bool room_add_hunter(struct Room* room, struct Hunter* hunter);
 void room_remove_hunter(struct Room* room, struct Hunter* hunter);
 bool room_has_hunters(struct Room* room);
+void room_write_begin(struct Room* room);
+void room_write_end(struct Room* room);
+void room_snapshot(struct Room* room, struct RoomSnapshot* snapshot);
+void room_mark_swept(struct Room* room, enum EvidenceType device, unsigned long stamp);
+unsigned long room_last_swept(const struct Room* room, enum EvidenceType device);
 void room_cleanup(struct Room* room);
 
 //RoomStack Functions
@@ -194,7 +580,8 @@ void roomstack_clear(struct RoomStack* stack);
 void roomstack_cleanup(struct RoomStack* stack);
 
 //Hunter Functions
-void hunter_init(struct Hunter* hunter, const char* name, int id, struct Room* starting_room, struct CaseFile* casefile);
+void hunter_init(struct Hunter* hunter, const char* name, int id, struct Room* starting_room, struct CaseFile* casefile,
+                 const struct SimParams* params);
 bool hunter_move(struct Hunter* hunter, struct Room* target_room);
 void hunter_update_stats(struct Hunter* hunter);
 void hunter_check_van(struct Hunter* hunter);
@@ -202,6 +589,7 @@ void hunter_check_exit_conditions(struct Hunter* hunter);
 void hunter_gather_evidence(struct Hunter* hunter);
 void hunter_choose_move(struct Hunter* hunter);
 void hunter_cleanup(struct Hunter* hunter);
+void hunter_step(struct Hunter* hunter);
 void* hunter_thread(void* data);
 
 //Ghost Functions
@@ -211,12 +599,91 @@ bool ghost_check_exit(struct Ghost* ghost);
 void ghost_leave_evidence(struct Ghost* ghost);
 void ghost_move(struct Ghost* ghost);
 void ghost_take_action(struct Ghost* ghost);
+void ghost_step(struct Ghost* ghost);
 void* ghost_thread(void* data);
 
 //House Functions
 void house_init(struct House* house);
+void house_params_update(struct SimParams* params);
 void house_add_hunter(struct House* house, const char* name, int id);
 void house_cleanup(struct House* house);
+bool house_populate_layout(struct House* house, const char* layout);
+
+//Config Functions
+void config_init(struct SimConfig* config);
+bool config_set(struct SimConfig* config, const char* key, const char* value);
+bool config_load_file(struct SimConfig* config, const char* path);
+bool config_parse_args(struct SimConfig* config, int argc, char** argv);
+void config_print_usage(const char* program);
+
+//Roster Functions
+void roster_init(struct Roster* roster);
+bool roster_add(struct Roster* roster, const char* name, int id);
+bool roster_load_file(struct Roster* roster, const char* path);
+bool roster_generate(struct Roster* roster, int count);
+void roster_cleanup(struct Roster* roster);
+
+//Stats Functions
+void stats_init(struct SimStats* stats);
+void stats_collect(struct SimStats* stats, const struct House* house);
+void stats_merge(struct SimStats* into, const struct SimStats* from);
+void stats_print(const struct SimStats* stats, enum StatsFormat format, const char* label);
+
+//Aggregate Functions
+void aggregate_init(struct Aggregate* agg);
+void aggregate_add_run(struct Aggregate* agg, const struct House* house, double duration_us);
+void aggregate_merge(struct Aggregate* into, const struct Aggregate* from);
+void aggregate_print(const struct Aggregate* agg);
+double aggregate_quantile(const struct QuantileSketch* sketch, double q);
+
+//Markov Functions
+bool markov_solve(const struct House* house, int hunters, size_t max_states, struct MarkovResult* result);
+
+//Monitor Functions
+void monitor_capture(struct House* house, struct WorldSnapshot* snapshot);
+bool monitor_start(struct Monitor* monitor, struct House* house);
+void monitor_publish(struct Monitor* monitor);
+bool monitor_read(struct Monitor* monitor, struct WorldSnapshot* snapshot);
+void monitor_stop(struct Monitor* monitor);
+
+//Metrics Functions
+bool metrics_open(const char* name, int runs_target, int slots);
+void metrics_close(void);
+void metrics_add_steps(unsigned long steps);
+void metrics_run_done(int slot, bool solved, unsigned long steps);
+void metrics_lock(sem_t* sem);
+
+//Affinity Functions
+int affinity_setup(enum PinMode mode, const char* cpus);
+void affinity_bind_worker(int slot);
+void affinity_apply(pthread_attr_t* attr, int entity, int entities);
+
+//Checkpoint Functions
+bool checkpoint_save(const struct House* house, const char* path);
+bool checkpoint_load(struct House* house, const char* path);
+
+//Timeline Functions
+bool timeline_init(struct TimelineHeap* heap, int capacity);
+void timeline_push(struct TimelineHeap* heap, long long timestamp, int source);
+int timeline_next(const struct TimelineHeap* heap);
+void timeline_advance(struct TimelineHeap* heap, bool more, long long timestamp);
+void timeline_free(struct TimelineHeap* heap);
+
+//Trace Functions
+void trace_enable(const char* path);
+void trace_thread_begin(int tid, const char* kind, const char* name);
+long long trace_begin(void);
+void trace_end(const char* name, long long start_ns);
+void trace_instant(const char* name);
+bool trace_write(void);
+
+//Simulation Functions
+bool simulation_setup(struct House* house, const struct SimConfig* config, const struct Roster* roster, int run_index);
+bool simulation_resume(struct House* house, const struct SimConfig* config);
+void simulation_run(struct House* house);
+double simulation_clock_us(void);
+bool simulation_run_batch(const struct SimConfig* config, const struct Roster* roster,
+                          struct Aggregate* agg, struct SimStats* totals);
 
 
 #endif // DEFS_H
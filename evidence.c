@@ -66,3 +66,83 @@ int evidence_count_bits(EvidenceByte ev){
 bool evidence_has_three_unique(EvidenceByte mask){
   return evidence_count_bits(mask) >= 3;
 }
+
+/* 
+   Function: evidence_ghosts_with
+   Purpose:  Builds the candidate bitset of every ghost that leaves a given
+   evidence type. Bit i stands for the i-th entry of get_all_ghost_types().
+   Params:   
+    Input: enum EvidenceType type - the evidence type
+   Return: unsigned - bitset of ghosts showing that evidence
+*/
+unsigned evidence_ghosts_with(enum EvidenceType type){
+  const enum GhostType* ghost_types = NULL;
+  int count = get_all_ghost_types(&ghost_types);
+  unsigned ghosts = 0;
+  for(int i = 0; i < count; i++){
+    if(ghost_types[i] & type){
+      ghosts |= 1u << i;
+    }
+  }
+  return ghosts;
+}
+
+/* 
+   Function: evidence_collect
+   Purpose:  Records evidence in the case file and narrows the candidate
+   ghosts to those that leave it. The caller holds casefile->mutex.
+   Params:   
+    Input/Output: struct CaseFile* casefile - the shared case file
+    Input: enum EvidenceType type - the evidence that was found
+   Return: void
+*/
+void evidence_collect(struct CaseFile* casefile, enum EvidenceType type){
+  evidence_set(&casefile->collected, type);
+  casefile->candidates &= evidence_ghosts_with(type);
+}
+
+/* 
+   Function: evidence_best_device
+   Purpose:  Picks the device that best splits the remaining candidates:
+   the uncollected evidence type whose "found / not found" outcome leaves
+   the smaller group largest. Once no device splits the candidates any
+   more, it picks the one most of them leave. Ties are broken at random so
+   hunters swapping together spread over the devices.
+   Params:   
+    Input: EvidenceByte collected - evidence already in the case file
+    Input: unsigned candidates - ghosts still consistent with it
+   Return: enum EvidenceType - the chosen device, or 0 when no device can help
+*/
+enum EvidenceType evidence_best_device(EvidenceByte collected, unsigned candidates){
+  const enum EvidenceType* evidence_types = NULL;
+  int count = get_all_evidence_types(&evidence_types);
+  int remaining = __builtin_popcount(candidates);
+
+  enum EvidenceType best[8];
+  int best_count = 0;
+  int best_split = -1, best_found = 0;
+
+  for(int i = 0; i < count; i++){
+    if(evidence_has(collected, evidence_types[i])){
+      continue;
+    }
+    int found = __builtin_popcount(candidates & evidence_ghosts_with(evidence_types[i]));
+    if(found == 0){
+      continue;
+    }
+    int split = (found < remaining - found) ? found : remaining - found;
+    if(split > best_split || (split == best_split && found > best_found)){
+      best_split = split;
+      best_found = found;
+      best_count = 0;
+    }
+    if(split == best_split && found == best_found){
+      best[best_count++] = evidence_types[i];
+    }
+  }
+
+  if(best_count == 0){
+    return 0;
+  }
+  return best[rand_int_threadsafe(0, best_count)];
+}
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 #include "defs.h"
 #include "helpers.h"
 /* 
@@ -24,13 +25,18 @@ void ghost_init(struct Ghost* ghost, struct House* house){
   random_index = rand_int_threadsafe(1, house->room_count);
   ghost->current_room = &house->rooms[random_index];
   ghost->current_room->ghost = ghost;  //Set the room's ghost pointer
+  ghost->casefile = &house->caseFile;
+  ghost->params = &house->params;
     
   //Initialize stats
   ghost->boredom = 0;
   ghost->has_exited = false;
+  memset(&ghost->stats, 0, sizeof(ghost->stats));
+  ghost->rng_seed = (house->seed != 0) ? rand_derive_seed(house->seed, ghost->id) : 0;
+  ghost->rng_state = ghost->rng_seed;
     
   //Log initialization
-  log_ghost_init(ghost->id, ghost->current_room->name, ghost->type);
+  LOG_EVENT(log_ghost_init(ghost->id, ghost->current_room->name, ghost->type));
 }
 
 /* 
@@ -52,24 +58,34 @@ void ghost_update_stats(struct Ghost* ghost){
 }
 
 /* 
-   Function: ghost_check_exit
+   Function: ghost_check_exit_limited
    Purpose: Checks if ghost should exit due to boredom.
    Params:   
     Input/Output: struct Ghost* ghost - the ghost to check
+    Input: int boredom_max - boredom the ghost tolerates
    Return: bool - true if ghost exited, false otherwise
 */
-bool ghost_check_exit(struct Ghost* ghost){
+STEP_INLINE bool ghost_check_exit_limited(struct Ghost* ghost, int boredom_max){
+  //the hunt is already decided, nothing left to haunt
+  bool cancelled = ghost->casefile != NULL && casefile_is_cancelled(ghost->casefile);
+
   //Check if boredom exceeds maximum
-  if(ghost->boredom > ENTITY_BOREDOM_MAX){
+  if(ghost->boredom > boredom_max || cancelled){
     ghost->has_exited = true;
         
     //Log the exit
-    log_ghost_exit(ghost->id, ghost->boredom, ghost->current_room->name);
+    LOG_EVENT(log_ghost_exit(ghost->id, ghost->boredom, ghost->current_room->name));
         
     // Remove ghost from room
     sem_wait(&ghost->current_room->mutex);
-    ghost->current_room->ghost = NULL;
+    room_write_begin(ghost->current_room);
+    __atomic_store_n(&ghost->current_room->ghost, NULL, __ATOMIC_RELAXED);
+    room_write_end(ghost->current_room);
     sem_post(&ghost->current_room->mutex);
+
+    if(ghost->casefile != NULL && !cancelled){
+      casefile_ghost_left(ghost->casefile, ghost->params);
+    }
     
     return true;
   }
@@ -77,6 +93,17 @@ bool ghost_check_exit(struct Ghost* ghost){
   return false;
 }
 
+/* 
+   Function: ghost_check_exit
+   Purpose: ghost_check_exit_limited with the run's boredom limit.
+   Params:   
+    Input/Output: struct Ghost* ghost - the ghost to check
+   Return: bool - true if ghost exited, false otherwise
+*/
+bool ghost_check_exit(struct Ghost* ghost){
+  return ghost_check_exit_limited(ghost, ghost->params != NULL ? ghost->params->boredom_max : ENTITY_BOREDOM_MAX);
+}
+
 /* 
    Function: ghost_leave_evidence
    Purpose: Drops a piece of evidence in the current room.
@@ -108,12 +135,19 @@ void ghost_leave_evidence(struct Ghost* ghost){
     enum EvidenceType evidence_to_leave = ghost_evidence[random_index];
         
     //lock before adding evidence
-    sem_wait(&ghost->current_room->mutex);
-    evidence_set(&ghost->current_room->evidence, evidence_to_leave);
+    metrics_lock(&ghost->current_room->mutex);
+    if(ghost->casefile != NULL && !evidence_has(ghost->current_room->evidence, evidence_to_leave)){
+      casefile_evidence_dropped(ghost->casefile);
+    }
+    room_write_begin(ghost->current_room);
+    __atomic_store_n(&ghost->current_room->evidence, (EvidenceByte)(ghost->current_room->evidence | evidence_to_leave), __ATOMIC_RELAXED);
+    room_write_end(ghost->current_room);
     sem_post(&ghost->current_room->mutex);
+    ghost->stats.haunts++;
+    trace_instant("evidence_drop");
         
     //Log it
-    log_ghost_evidence(ghost->id, ghost->boredom, ghost->current_room->name, evidence_to_leave);
+    LOG_EVENT(log_ghost_evidence(ghost->id, ghost->boredom, ghost->current_room->name, evidence_to_leave));
   }
 }
 
@@ -127,6 +161,7 @@ void ghost_leave_evidence(struct Ghost* ghost){
 void ghost_move(struct Ghost* ghost){
   //Cant move if hunters are in the room
   if(room_has_hunters(ghost->current_room)){
+    ghost->stats.moves_blocked++;
     return;
   }
     
@@ -146,45 +181,128 @@ void ghost_move(struct Ghost* ghost){
   struct Room* second = (from_room < target_room) ? target_room : from_room;
 
   //lock both rooms
-  sem_wait(&first->mutex);
-  sem_wait(&second->mutex);
+  long long wait_start = trace_begin();
+  metrics_lock(&first->mutex);
+  metrics_lock(&second->mutex);
+  trace_end("room_lock_wait", wait_start);
     
   //Remove ghost from current room 
-  from_room->ghost = NULL;
+  room_write_begin(from_room);
+  __atomic_store_n(&from_room->ghost, NULL, __ATOMIC_RELAXED);
+  room_write_end(from_room);
     
   //Move ghost to new room
   ghost->current_room = target_room;
-  target_room->ghost = ghost;
+  room_write_begin(target_room);
+  __atomic_store_n(&target_room->ghost, ghost, __ATOMIC_RELAXED);
+  room_write_end(target_room);
 
   //unlock both rooms
   sem_post(&second->mutex);
   sem_post(&first->mutex);
+  ghost->stats.moves++;
     
   //Log the move
-  log_ghost_move(ghost->id, ghost->boredom, from_room->name, target_room->name);
+  LOG_EVENT(log_ghost_move(ghost->id, ghost->boredom, from_room->name, target_room->name));
 }
 
 /* 
-   Function: ghost_take_action
+   Function: ghost_take_action_limited
    Purpose: Ghost randomly chooses to idle, haunt, or move.
    Params:   
    Input/Output: struct Ghost* ghost - the ghost taking action
+    Input: int idle_weight, haunt_weight, move_weight - relative odds of each action
    Return: void
 */
-void ghost_take_action(struct Ghost* ghost){
+STEP_INLINE void ghost_take_action_limited(struct Ghost* ghost, int idle_weight, int haunt_weight, int move_weight){
   //Randomly choose an action
-  // 0 = does nothing, 1 = leave evidence, 2 = just move
-  int action = rand_int_threadsafe(0, 3);
+  //below idle_weight does nothing, then leaves evidence, the rest just moves
+  int action = rand_int_threadsafe(0, idle_weight + haunt_weight + move_weight);
     
-  if(action == 0){
-    log_ghost_idle(ghost->id, ghost->boredom, ghost->current_room->name);
-  }else if(action == 1){
+  if(action < idle_weight){
+    ghost->stats.idles++;
+    LOG_EVENT(log_ghost_idle(ghost->id, ghost->boredom, ghost->current_room->name));
+  }else if(action < idle_weight + haunt_weight){
     ghost_leave_evidence(ghost);
   }else{
     ghost_move(ghost);
   }
 }
 
+/* 
+   Function: ghost_take_action
+   Purpose: ghost_take_action_limited with the run's action weights.
+   Params:   
+   Input/Output: struct Ghost* ghost - the ghost taking action
+   Return: void
+*/
+void ghost_take_action(struct Ghost* ghost){
+  const struct SimParams* params = ghost->params;
+  if(params == NULL){
+    ghost_take_action_limited(ghost, GHOST_ACTION_WEIGHT, GHOST_ACTION_WEIGHT, GHOST_ACTION_WEIGHT);
+  }else{
+    ghost_take_action_limited(ghost, params->idle_weight, params->haunt_weight, params->move_weight);
+  }
+}
+
+/* 
+   Function: ghost_step_limited
+   Purpose:  Runs one pass of the ghost's loop on whatever RNG stream the
+   calling thread has bound. Does nothing once the ghost has exited.
+   Params:   
+   Input/Output: struct Ghost* ghost - the ghost to step
+    Input: int boredom_max, idle_weight, haunt_weight, move_weight - the limits
+   Return: void
+*/
+STEP_INLINE void ghost_step_limited(struct Ghost* ghost, int boredom_max, int idle_weight,
+                                    int haunt_weight, int move_weight){
+  if(ghost->has_exited){
+    return;
+  }
+
+  ghost->stats.iterations++;
+  if(ghost->stats.iterations % METRICS_STEP_BATCH == 0){
+    metrics_add_steps(METRICS_STEP_BATCH);
+  }
+
+  //Update boredom based on hunter presence
+  ghost_update_stats(ghost);
+        
+  //Check if ghost should exit due to boredom 
+  //Only take action if ghost hasn't exited
+  if(!ghost_check_exit_limited(ghost, boredom_max)){
+    //Randomly choose to stau still, leave evidence, or move
+    ghost_take_action_limited(ghost, idle_weight, haunt_weight, move_weight);
+  }
+}
+
+//the ghost's step compiled for the default limits and for tuned ones
+#define GHOST_STEP_VARIANT(name, BOREDOM_MAX, IDLE_WEIGHT, HAUNT_WEIGHT, MOVE_WEIGHT)   \
+  static void name(struct Ghost* ghost){                                            \
+    ghost_step_limited(ghost, BOREDOM_MAX, IDLE_WEIGHT, HAUNT_WEIGHT, MOVE_WEIGHT); \
+  }
+
+GHOST_STEP_VARIANT(ghost_step_default, ENTITY_BOREDOM_MAX, GHOST_ACTION_WEIGHT,
+                   GHOST_ACTION_WEIGHT, GHOST_ACTION_WEIGHT)
+GHOST_STEP_VARIANT(ghost_step_tuned, ghost->params->boredom_max, ghost->params->idle_weight,
+                   ghost->params->haunt_weight, ghost->params->move_weight)
+
+/* 
+   Function: ghost_step
+   Purpose:  Runs one pass of the ghost's loop, through the step compiled
+   for the default limits unless the run tunes them.
+   Params:   
+   Input/Output: struct Ghost* ghost - the ghost to step
+   Return: void
+*/
+void ghost_step(struct Ghost* ghost){
+  if(ghost->params != NULL && ghost->params->tuned){
+    ghost_step_tuned(ghost);
+  }else{
+    ghost_step_default(ghost);
+  }
+}
+
 /* 
    Function: ghost_thread
    Purpose:  Thread function for the ghost. Runs the ghost's behavior loop
@@ -196,20 +314,24 @@ void ghost_take_action(struct Ghost* ghost){
 void* ghost_thread(void* data){
   //cast the pointer back to a Ghost pointer
   struct Ghost* ghost = (struct Ghost*)data;
+
+  //the ghost draws from its own stream, seeded or from the clock
+  rand_bind_thread(&ghost->rng_state);
     
+  trace_thread_begin(ghost->id, "ghost", ghost_to_string(ghost->type));
+
+  //the limits cannot change during a hunt, so pick the step once
+  void (*step)(struct Ghost*) = (ghost->params != NULL && ghost->params->tuned)
+    ? ghost_step_tuned : ghost_step_default;
+
   //keep running until ghost exits
   while(!ghost->has_exited){
-    //Update boredom based on hunter presence
-    ghost_update_stats(ghost);
-        
-    //Check if ghost should exit due to boredom 
-    //Only take action if ghost hasn't exited
-    if(!ghost_check_exit(ghost)){
-      //Randomly choose to stau still, leave evidence, or move
-      ghost_take_action(ghost);
-    }
+    step(ghost);
   }
     
+  trace_instant("exit");
+  metrics_add_steps(ghost->stats.iterations % METRICS_STEP_BATCH);
+
   //Thread is done so return NULL
   return NULL;
 }
@@ -5,6 +5,9 @@
 #include <time.h>
 #include <pthread.h>
 #include <stdint.h>
+#include <stdatomic.h>
+#include <glob.h>
+#include <sys/stat.h>
 #include "helpers.h"
 #include "defs.h"
 
@@ -188,22 +191,45 @@ int get_all_ghost_types(const enum GhostType** list) {
 }
 
 // ---- Thread-safe random number generation ----
-int rand_int_threadsafe(int lower_inclusive, int upper_exclusive) {
-    static _Thread_local unsigned seed = 0;
+static _Thread_local unsigned seed = 0;
+// Entity stream the thread currently draws from, NULL for its own seed
+static _Thread_local unsigned* bound = NULL;
+
+void rand_seed_thread(unsigned value) {
+    seed = value ? value : 0xA5A5A5A5u;
+}
+
+void rand_bind_thread(unsigned* state) {
+    bound = state;
+}
+
+unsigned rand_derive_seed(unsigned base, int stream) {
+    // Spread neighbouring ids apart so streams do not start correlated
+    unsigned x = base ^ ((unsigned)stream * 0x9E3779B9u);
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x ? x : 0xA5A5A5A5u;
+}
 
+int rand_int_threadsafe(int lower_inclusive, int upper_exclusive) {
     if (upper_exclusive <= lower_inclusive) {
         return lower_inclusive;
     }
 
-    if (seed == 0) {
-        seed = (unsigned)time(NULL) ^ (unsigned)(uintptr_t)pthread_self();
-        if (seed == 0) {
-            seed = 0xA5A5A5A5u;
+    unsigned* state = bound ? bound : &seed;
+    if (*state == 0) {
+        // The address keeps clock-seeded entities on one thread apart
+        *state = (unsigned)time(NULL) ^ (unsigned)(uintptr_t)pthread_self() ^ (unsigned)(uintptr_t)state;
+        if (*state == 0) {
+            *state = 0xA5A5A5A5u;
         }
     }
 
     unsigned span = (unsigned)(upper_exclusive - lower_inclusive);
-    unsigned value = (unsigned)rand_r(&seed) % span;
+    unsigned value = (unsigned)rand_r(state) % span;
     return lower_inclusive + (int)value;
 }
 
@@ -251,20 +277,166 @@ static const char* log_entity_type_to_string(enum LogEntityType type) {
     }
 }
 
-static void write_log_record(const struct LogRecord* record) {
-    static _Thread_local unsigned line_count = 0;
+static enum LogMode log_mode = LOG_MODE_CSV;
+static enum ConsoleLevel console_level = CONSOLE_EVENTS;
+static atomic_ulong log_events = 0;
+
+void log_set_mode(enum LogMode mode) {
+    log_mode = mode;
+}
+
+void log_set_console(enum ConsoleLevel level) {
+    console_level = level;
+}
+
+unsigned long log_event_count(void) {
+    return atomic_load_explicit(&log_events, memory_order_relaxed);
+}
+
+// ---- Log segments ----
+// Each entity appends to log_<id>.csv until it reaches log_segment_bytes,
+// then to log_<id>.1.csv, log_<id>.2.csv and so on. The segment state is
+// kept per entity id (not per thread) in an open-addressed table that
+// doubles whenever it gets half full, so lookups stay a probe or two for
+// any number of entities.
+
+#define LOG_SEGMENT_INITIAL_SLOTS 4096
+#define LOG_LINE_MAX 512
+
+struct LogSegment {
+    int entity_id;
+    bool used;
+    unsigned index;               // current segment, 0 is log_<id>.csv
+    unsigned long long bytes;     // size of the current segment
+};
+
+static unsigned long long log_segment_bytes = 0;   // 0: never rotate
+static unsigned log_keep_segments = 0;             // 0: keep every segment
+static unsigned long long log_budget_bytes = 0;    // 0: no total limit
+static atomic_ullong log_written_bytes = 0;
+static atomic_bool log_stopped = false;
+static struct LogSegment* log_segments = NULL;
+static unsigned log_segment_slots = 0;           // power of two
+static unsigned log_segment_used = 0;
+static pthread_mutex_t log_segments_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void log_set_rotation(unsigned long long segment_bytes, unsigned keep_segments, unsigned long long budget_bytes) {
+    log_segment_bytes = segment_bytes;
+    log_keep_segments = keep_segments;
+    log_budget_bytes = budget_bytes;
+}
+
+bool log_budget_reached(void) {
+    return atomic_load_explicit(&log_stopped, memory_order_relaxed);
+}
 
-    if (line_count >= 100000) {
-        fprintf(stderr, "Log capped for entity %d; stopping to prevent infinite growth.\n", record->entity_id);
-        exit(1);
+static void log_segment_path(char* out, size_t size, int entity_id, unsigned index) {
+    if (index == 0) {
+        snprintf(out, size, "log_%d.csv", entity_id);
+    } else {
+        snprintf(out, size, "log_%d.%u.csv", entity_id, index);
     }
+}
 
-    char filename[64];
-    snprintf(filename, sizeof(filename), "log_%d.csv", record->entity_id);
+// First record of an entity in this process: continue after whatever
+// segments an earlier process left, like the single file used to be appended to
+static void log_segment_discover(struct LogSegment* segment) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "log_%d.*.csv", segment->entity_id);
+    glob_t found;
+    if (glob(pattern, 0, NULL, &found) == 0) {
+        for (size_t i = 0; i < found.gl_pathc; i++) {
+            unsigned index = 0;
+            char tail = '\0';
+            int id = 0;
+            if (sscanf(found.gl_pathv[i], "log_%d.%u.cs%c", &id, &index, &tail) == 3 &&
+                id == segment->entity_id && tail == 'v' && index > segment->index) {
+                segment->index = index;
+            }
+        }
+        globfree(&found);
+    }
 
-    FILE* log_file = fopen(filename, "a");
+    char path[64];
+    struct stat info;
+    log_segment_path(path, sizeof(path), segment->entity_id, segment->index);
+    segment->bytes = stat(path, &info) == 0 ? (unsigned long long)info.st_size : 0;
+}
 
-    if (!log_file) {
+// The slot holding entity_id, or the empty slot where it belongs. The
+// table is never more than half full, so an empty slot always turns up.
+static struct LogSegment* log_segment_find(struct LogSegment* table, unsigned slots, int entity_id) {
+    unsigned slot = ((unsigned)entity_id * 2654435761u) & (slots - 1);
+    while (table[slot].used && table[slot].entity_id != entity_id) {
+        slot = (slot + 1) & (slots - 1);
+    }
+    return &table[slot];
+}
+
+// Doubles the table (or allocates the first one) and rehashes every entity.
+// Caller holds log_segments_lock.
+static bool log_segment_grow(void) {
+    unsigned slots = log_segment_slots == 0 ? LOG_SEGMENT_INITIAL_SLOTS : log_segment_slots * 2;
+    struct LogSegment* table = calloc(slots, sizeof(struct LogSegment));
+    if (table == NULL) {
+        return false;
+    }
+    for (unsigned i = 0; i < log_segment_slots; i++) {
+        if (log_segments[i].used) {
+            *log_segment_find(table, slots, log_segments[i].entity_id) = log_segments[i];
+        }
+    }
+    free(log_segments);
+    log_segments = table;
+    log_segment_slots = slots;
+    return true;
+}
+
+// Picks the file a record of length bytes goes to, rotating (and dropping
+// the oldest segment beyond log_keep_segments) when it would not fit.
+// Returns false, and stops the logs, if a new entity cannot be tracked.
+static bool log_segment_claim(int entity_id, size_t length, char* path, size_t size) {
+    pthread_mutex_lock(&log_segments_lock);
+
+    struct LogSegment* segment = log_segment_slots > 0 ? log_segment_find(log_segments, log_segment_slots, entity_id) : NULL;
+    if (segment == NULL || !segment->used) {
+        // a new entity: make room first so the table stays at most half full
+        if ((log_segment_used + 1) * 2 > log_segment_slots && !log_segment_grow()) {
+            pthread_mutex_unlock(&log_segments_lock);
+            if (!atomic_exchange(&log_stopped, true)) {
+                fprintf(stderr, "Out of memory for log segments; later records are counted but not written.\n");
+            }
+            return false;
+        }
+        segment = log_segment_find(log_segments, log_segment_slots, entity_id);
+        segment->used = true;
+        segment->entity_id = entity_id;
+        segment->index = 0;
+        log_segment_discover(segment);
+        log_segment_used++;
+    }
+
+    if (log_segment_bytes > 0 && segment->bytes > 0 && segment->bytes + length > log_segment_bytes) {
+        segment->index++;
+        segment->bytes = 0;
+        if (log_keep_segments > 0 && segment->index >= log_keep_segments) {
+            char oldest[64];
+            log_segment_path(oldest, sizeof(oldest), entity_id, segment->index - log_keep_segments);
+            remove(oldest);
+        }
+    }
+    segment->bytes += length;
+    log_segment_path(path, size, entity_id, segment->index);
+
+    pthread_mutex_unlock(&log_segments_lock);
+    return true;
+}
+
+static void write_log_record(const struct LogRecord* record) {
+    // Counted even when the CSV files are off, so throughput numbers compare
+    atomic_fetch_add_explicit(&log_events, 1, memory_order_relaxed);
+
+    if (log_mode == LOG_MODE_NONE || atomic_load_explicit(&log_stopped, memory_order_relaxed)) {
         return;
     }
 
@@ -278,7 +450,9 @@ static void write_log_record(const struct LogRecord* record) {
     const char* action = record->action ? record->action : "";
     const char* extra = record->extra ? record->extra : "";
 
-    fprintf(log_file,
+    char line[LOG_LINE_MAX];
+    int length = snprintf(line,
+            sizeof(line),
             "%lld,%s,%d,%s,%s,%d,%d,%s,%s\n",
             timestamp,
             entity,
@@ -289,9 +463,40 @@ static void write_log_record(const struct LogRecord* record) {
             record->fear,
             action,
             extra);
+    if (length < 0) {
+        return;
+    }
+    if ((size_t)length >= sizeof(line)) {
+        length = sizeof(line) - 1;
+        line[length - 1] = '\n';
+    }
+
+    // Past the budget nothing more is written, but the run carries on
+    if (log_budget_bytes > 0) {
+        unsigned long long written = atomic_fetch_add_explicit(&log_written_bytes, (unsigned long long)length,
+                                                               memory_order_relaxed) + (unsigned long long)length;
+        if (written > log_budget_bytes) {
+            if (!atomic_exchange(&log_stopped, true)) {
+                fprintf(stderr, "Log budget of %llu bytes reached; later records are counted but not written.\n",
+                        log_budget_bytes);
+            }
+            return;
+        }
+    }
+
+    char filename[64];
+    if (!log_segment_claim(record->entity_id, (size_t)length, filename, sizeof(filename))) {
+        return;
+    }
+
+    FILE* log_file = fopen(filename, "a");
+
+    if (!log_file) {
+        return;
+    }
 
+    fwrite(line, 1, (size_t)length, log_file);
     fclose(log_file);
-    line_count++;
 
     // Short pause helps ensure successive logs receive distinct timestamps.
     struct timespec pause = {0, 2 * 1000 * 1000}; // 2 ms
@@ -312,6 +517,10 @@ void log_move(int hunter_id, int boredom, int fear, const char* from_room, const
 
     write_log_record(&record);
 
+    if (console_level != CONSOLE_EVENTS) {
+        return;
+    }
+
     printf("Hunter %d using %s moved from %s to %s (bored=%d fear=%d)\n",
            hunter_id,
            evidence_to_string(device),
@@ -336,6 +545,10 @@ void log_evidence(int hunter_id, int boredom, int fear, const char* room_name, e
 
     write_log_record(&record);
 
+    if (console_level != CONSOLE_EVENTS) {
+        return;
+    }
+
     printf("Hunter %d using %s gathered evidence in %s (bored=%d fear=%d)\n",
            hunter_id,
            evidence,
@@ -363,6 +576,10 @@ void log_swap(int hunter_id, int boredom, int fear, enum EvidenceType from_devic
 
     write_log_record(&record);
 
+    if (console_level != CONSOLE_EVENTS) {
+        return;
+    }
+
     printf("Hunter %d swapped devices: %s -> %s (bored=%d fear=%d)\n",
            hunter_id,
            from_text,
@@ -388,6 +605,10 @@ void log_exit(int hunter_id, int boredom, int fear, const char* room_name, enum
 
     write_log_record(&record);
 
+    if (console_level != CONSOLE_EVENTS) {
+        return;
+    }
+
     printf("Hunter %d using %s exited at %s (reason=%s, bored=%d fear=%d)\n",
            hunter_id,
            device_text,
@@ -415,6 +636,10 @@ void log_return_to_van(int hunter_id, int boredom, int fear, const char* room_na
 
     write_log_record(&record);
 
+    if (console_level != CONSOLE_EVENTS) {
+        return;
+    }
+
     if (heading_home) {
         printf("Hunter %d using %s heading to van from %s (bored=%d fear=%d)\n",
                hunter_id,
@@ -446,6 +671,10 @@ void log_hunter_init(int hunter_id, const char* room_name, const char* hunter_na
     };
 
     write_log_record(&record);
+
+    if (console_level != CONSOLE_EVENTS) {
+        return;
+    }
     printf("Hunter %d (%s) initialized in %s with %s\n",
            hunter_id,
            hunter_name ? hunter_name : "unknown",
@@ -467,6 +696,10 @@ void log_ghost_init(int ghost_id, const char* room_name, enum GhostType type) {
     };
 
     write_log_record(&record);
+
+    if (console_level != CONSOLE_EVENTS) {
+        return;
+    }
     printf("Ghost %d (%s) initialized in %s\n",
            ghost_id,
            type_text,
@@ -487,6 +720,10 @@ void log_ghost_move(int ghost_id, int boredom, const char* from_room, const char
 
     write_log_record(&record);
 
+    if (console_level != CONSOLE_EVENTS) {
+        return;
+    }
+
     printf("Ghost %d [bored=%d] MOVE %s -> %s\n",
            ghost_id,
            boredom,
@@ -510,6 +747,10 @@ void log_ghost_evidence(int ghost_id, int boredom, const char* room_name, enum E
 
     write_log_record(&record);
 
+    if (console_level != CONSOLE_EVENTS) {
+        return;
+    }
+
     printf("Ghost %d [bored=%d] EVIDENCE %s in %s\n",
            ghost_id,
            boredom,
@@ -531,6 +772,10 @@ void log_ghost_exit(int ghost_id, int boredom, const char* room_name) {
 
     write_log_record(&record);
 
+    if (console_level != CONSOLE_EVENTS) {
+        return;
+    }
+
     printf("Ghost %d [bored=%d] EXIT %s\n",
            ghost_id,
            boredom,
@@ -551,6 +796,10 @@ void log_ghost_idle(int ghost_id, int boredom, const char* room_name) {
 
     write_log_record(&record);
 
+    if (console_level != CONSOLE_EVENTS) {
+        return;
+    }
+
     printf("Ghost %d [bored=%d] IDLE in %s\n",
            ghost_id,
            boredom,
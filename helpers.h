@@ -46,6 +46,26 @@ int get_all_ghost_types(const enum GhostType** list);
  */
 int rand_int_threadsafe(int lower_inclusive, int upper_exclusive);
 
+/**
+ * @brief Seed the calling thread's random stream.
+ * @param[in] value Seed value; zero is replaced by a fixed non-zero constant.
+ */
+void rand_seed_thread(unsigned value);
+
+/**
+ * @brief Make the calling thread draw from an entity's own stream.
+ * @param[in] state Stream state owned by the entity, or NULL for the thread's own seed.
+ */
+void rand_bind_thread(unsigned* state);
+
+/**
+ * @brief Derive a per-entity seed from a base seed.
+ * @param[in] base Base seed for the run.
+ * @param[in] stream Entity identifier selecting the stream.
+ * @return Non-zero seed suitable for rand_seed_thread().
+ */
+unsigned rand_derive_seed(unsigned base, int stream);
+
 /**
  * @brief Verify whether an evidence mask matches a supported ghost type.
  * @param[in] mask Combined evidence mask.
@@ -66,6 +86,38 @@ bool evidence_has_three_unique(EvidenceByte mask);
  */
 void house_populate_rooms(struct House* house);
 
+/**
+ * @brief Choose where log records are written; call before threads start.
+ * @param[in] mode LOG_MODE_CSV for per-entity files, LOG_MODE_NONE to skip them.
+ */
+void log_set_mode(enum LogMode mode);
+
+/**
+ * @brief Set how the CSV logs are split and capped; call before threads start.
+ * @param[in] segment_bytes Start log_<id>.<n>.csv once a segment would pass this size; 0 never rotates.
+ * @param[in] keep_segments Delete an entity's oldest segment beyond this many; 0 keeps all.
+ * @param[in] budget_bytes Stop writing (without stopping the run) past this many bytes in total; 0 is unlimited.
+ */
+void log_set_rotation(unsigned long long segment_bytes, unsigned keep_segments, unsigned long long budget_bytes);
+
+/**
+ * @brief Whether the log budget has been used up.
+ * @return true once records stopped being written.
+ */
+bool log_budget_reached(void);
+
+/**
+ * @brief Choose how much the log_* functions echo to stdout; call before threads start.
+ * @param[in] level CONSOLE_EVENTS prints every event; SUMMARY and SILENT print none.
+ */
+void log_set_console(enum ConsoleLevel level);
+
+/**
+ * @brief Number of log records produced so far by every thread.
+ * @return Running total, including records skipped by LOG_MODE_NONE.
+ */
+unsigned long log_event_count(void);
+
 /**
  * @brief Append a MOVE entry for a hunter.
  * @param[in] id Hunter identifier.
@@ -170,4 +222,18 @@ void log_hunter_init(int id, const char* room, const char* name, enum EvidenceTy
  */
 void log_ghost_init(int id, const char* room, enum GhostType type);
 
+/**
+ * @brief Wraps a log_* call on a hunter or ghost path.
+ *
+ * Building with -DNO_EVENT_LOG (`make quiet`) leaves the call inside an
+ * unevaluated sizeof: it is still type-checked, but the call, its arguments
+ * and the console check all disappear. Such a build writes no CSV records
+ * and prints no events whatever the options say.
+ */
+#ifdef NO_EVENT_LOG
+#define LOG_EVENT(call) ((void)sizeof((call), 0))
+#else
+#define LOG_EVENT(call) (call)
+#endif
+
 #endif // HELPERS_H
@@ -1,3 +1,4 @@
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "defs.h"
@@ -23,10 +24,64 @@ void house_init(struct House* house){
   //initialize casefile
   house->caseFile.collected = 0;
   house->caseFile.solved = false;
+  house->caseFile.candidates = 0;
+  house->caseFile.pending = 0;
+  house->caseFile.ghost_gone = false;
+  house->caseFile.cancelled = false;
+  house->caseFile.sweep_clock = 0;
+  house->caseFile.claimed = 0;
+  const enum GhostType* ghost_types = NULL;
+  int ghost_count = get_all_ghost_types(&ghost_types);
+  for(int i = 0; i < ghost_count; i++){
+    house->caseFile.candidates |= 1u << i;
+  }
   sem_init(&house->caseFile.mutex, 0, 1);
     
   //ghost will be initialized separately
   house->ghost.has_exited = false;
+
+  //clock seeded unless simulation_setup picks a base seed
+  house->seed = 0;
+  house->layout[0] = '\0';
+  house->round = 0;
+
+  //defaults match the original behaviour; simulation_setup applies options
+  house->params.return_mode = RETURN_BREADCRUMBS;
+  house->params.swap_mode = SWAP_RANDOM;
+  house->params.explore_mode = EXPLORE_RANDOM;
+  house->params.device_mode = DEVICES_RANDOM;
+  house->params.early_exit = false;
+  house->params.boredom_max = ENTITY_BOREDOM_MAX;
+  house->params.fear_max = HUNTER_FEAR_MAX;
+  house->params.occupancy = MAX_ROOM_OCCUPANCY;
+  house->params.return_chance = HUNTER_RETURN_CHANCE;
+  house->params.idle_weight = GHOST_ACTION_WEIGHT;
+  house->params.haunt_weight = GHOST_ACTION_WEIGHT;
+  house->params.move_weight = GHOST_ACTION_WEIGHT;
+  house->params.tuned = false;
+  house->params.monitor = false;
+  house->params.schedule = SCHEDULE_THREADS;
+  house->params.checkpoint_path = NULL;
+  house->params.checkpoint_round = 0;
+}
+
+/* 
+   Function: house_params_update
+   Purpose:  Notes whether any behaviour limit differs from its compiled
+   default. Entities step through code specialised for the defaults unless
+   tuned is set. Call it after changing a limit.
+   Params:   
+   Input/Output: struct SimParams* params - the parameters, tuned is rewritten
+   Return: void
+*/
+void house_params_update(struct SimParams* params){
+  params->tuned = params->boredom_max != ENTITY_BOREDOM_MAX
+    || params->fear_max != HUNTER_FEAR_MAX
+    || params->occupancy != MAX_ROOM_OCCUPANCY
+    || params->return_chance != HUNTER_RETURN_CHANCE
+    || params->idle_weight != GHOST_ACTION_WEIGHT
+    || params->haunt_weight != GHOST_ACTION_WEIGHT
+    || params->move_weight != GHOST_ACTION_WEIGHT;
 }
 
 /* 
@@ -56,7 +111,12 @@ void house_add_hunter(struct House* house, const char* name, int id){
   }
     
   //initialize the new hunter
-  hunter_init(&house->hunters[house->hunter_count], name, id, house->starting_room, &house->caseFile);
+  hunter_init(&house->hunters[house->hunter_count], name, id, house->starting_room, &house->caseFile,
+              &house->params);
+  if(house->seed != 0){
+    house->hunters[house->hunter_count].rng_seed = rand_derive_seed(house->seed, id);
+  }
+  house->hunters[house->hunter_count].rng_state = house->hunters[house->hunter_count].rng_seed;
     
   house->hunter_count++;
 }
@@ -86,3 +146,148 @@ void house_cleanup(struct House* house){
   //destroy casefile semaphore
   sem_destroy(&house->caseFile.mutex);
 }
+
+/* 
+   Function: house_populate_grid
+   Purpose:  Builds a rows x cols grid of rooms with the van attached to the
+   top left corner. Used for batch runs on houses other than Willow.
+   Params:   
+   Input/Output: struct House* house - pointer to the house to populate
+   Input: int rows - number of grid rows
+   Input: int cols - number of grid columns
+   Return: void
+*/
+static void house_populate_grid(struct House* house, int rows, int cols){
+  char name[MAX_ROOM_NAME];
+
+  room_init(&house->rooms[0], "Van", true);
+  for(int r = 0; r < rows; r++){
+    for(int c = 0; c < cols; c++){
+      snprintf(name, sizeof(name), "Room %d-%d", r + 1, c + 1);
+      room_init(&house->rooms[1 + r * cols + c], name, false);
+    }
+  }
+  house->room_count = 1 + rows * cols;
+
+  //van to the corner, then right and down neighbours
+  room_connect(&house->rooms[0], &house->rooms[1]);
+  for(int r = 0; r < rows; r++){
+    for(int c = 0; c < cols; c++){
+      struct Room* room = &house->rooms[1 + r * cols + c];
+      if(c + 1 < cols){
+        room_connect(room, room + 1);
+      }
+      if(r + 1 < rows){
+        room_connect(room, room + cols);
+      }
+    }
+  }
+
+  house->starting_room = &house->rooms[0];
+}
+
+/* 
+   Function: house_populate_corridor
+   Purpose:  Builds a straight chain of rooms leading away from the van.
+   Params:   
+   Input/Output: struct House* house - pointer to the house to populate
+   Input: int length - number of rooms after the van
+   Return: void
+*/
+static void house_populate_corridor(struct House* house, int length){
+  char name[MAX_ROOM_NAME];
+
+  room_init(&house->rooms[0], "Van", true);
+  for(int i = 1; i <= length; i++){
+    snprintf(name, sizeof(name), "Corridor %d", i);
+    room_init(&house->rooms[i], name, false);
+    room_connect(&house->rooms[i - 1], &house->rooms[i]);
+  }
+  house->room_count = 1 + length;
+
+  house->starting_room = &house->rooms[0];
+}
+
+/* 
+   Function: house_build_routes
+   Purpose:  Runs a BFS from every room to fill the all-pairs hop table, and
+   points each room at its next hop on a shortest path to the van. Rooms
+   are tried in connection order, so ties go to the first connection.
+   Params:   
+   Input/Output: struct House* house - a populated house
+   Return: void
+*/
+static void house_build_routes(struct House* house){
+  int queue[MAX_ROOMS];
+
+  for(int source = 0; source < house->room_count; source++){
+    unsigned char* distance = house->route_distance[source];
+    memset(distance, ROUTE_UNREACHABLE, sizeof(house->route_distance[source]));
+
+    int head = 0, tail = 0;
+    distance[source] = 0;
+    queue[tail++] = source;
+    while(head < tail){
+      struct Room* room = &house->rooms[queue[head++]];
+      int room_index = (int)(room - house->rooms);
+      for(int i = 0; i < room->connection_count; i++){
+        int next = (int)(room->connections[i] - house->rooms);
+        if(distance[next] == ROUTE_UNREACHABLE){
+          distance[next] = (unsigned char)(distance[room_index] + 1);
+          queue[tail++] = next;
+        }
+      }
+    }
+  }
+
+  //a neighbour one hop closer to the van is always on a shortest path
+  int van = (int)(house->starting_room - house->rooms);
+  for(int r = 0; r < house->room_count; r++){
+    struct Room* room = &house->rooms[r];
+    room->van_next_hop = NULL;
+    room->van_distance = house->route_distance[van][r] == ROUTE_UNREACHABLE ? -1 : house->route_distance[van][r];
+    for(int i = 0; i < room->connection_count && r != van; i++){
+      int next = (int)(room->connections[i] - house->rooms);
+      if(house->route_distance[van][next] + 1 == house->route_distance[van][r]){
+        room->van_next_hop = room->connections[i];
+        break;
+      }
+    }
+  }
+}
+
+/* 
+   Function: house_populate_layout
+   Purpose:  Populates the house from a layout name: "willow" (the provided
+   layout), "grid:RxC" or "corridor:N". Generated layouts must fit in MAX_ROOMS.
+   Params:   
+   Input/Output: struct House* house - pointer to the house to populate
+   Input: const char* layout - layout name
+   Return: bool - true if the layout was recognized and built
+*/
+bool house_populate_layout(struct House* house, const char* layout){
+  int rows, cols, length;
+  char tail;
+
+  if(layout == NULL || layout[0] == '\0' || strcmp(layout, "willow") == 0){
+    house_populate_rooms(house);
+  }else if(sscanf(layout, "grid:%dx%d%c", &rows, &cols, &tail) == 2){
+    //bound each side first so the product cannot overflow
+    if(rows < 1 || cols < 1 || rows > MAX_ROOMS || cols > MAX_ROOMS || rows * cols + 1 > MAX_ROOMS){
+      return false;
+    }
+    house_populate_grid(house, rows, cols);
+  }else if(sscanf(layout, "corridor:%d%c", &length, &tail) == 1){
+    if(length < 1 || length > MAX_ROOMS - 1){
+      return false;
+    }
+    house_populate_corridor(house, length);
+  }else{
+    return false;
+  }
+
+  //kept so a checkpoint can rebuild the same rooms
+  snprintf(house->layout, sizeof(house->layout), "%s", layout != NULL ? layout : "");
+  house_build_routes(house);
+  return true;
+}
@@ -1,8 +1,89 @@
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 #include "defs.h"
 #include "helpers.h"
 
+/* 
+   Function: hunter_pick_device
+   Purpose: Chooses the hunter's next device. Informed swaps take the one
+   that best splits the candidate ghosts, otherwise any at random. With
+   claimed devices the choice skips what a teammate holds and what is
+   already collected, and the hunter claims what it picks. Once every
+   missing device is held it doubles up on one without claiming it.
+   Params:   
+   Input/Output: struct Hunter* hunter - the hunter, device and device_claimed are set
+    Input: bool informed - use evidence_best_device before chance
+    Input: EvidenceByte collected - evidence already in the case file
+    Input: unsigned candidates - ghosts still consistent with it
+   Return: void
+*/
+static void hunter_pick_device(struct Hunter* hunter, bool informed, EvidenceByte collected, unsigned candidates){
+  const enum EvidenceType* evidence_types = NULL;
+  int count = get_all_evidence_types(&evidence_types);
+  hunter->device_claimed = false;
+
+  if(hunter->params == NULL || hunter->params->device_mode != DEVICES_CLAIMED){
+    enum EvidenceType device = informed ? evidence_best_device(collected, candidates) : 0;
+
+    //pick a random new device when not informed or nothing is worth picking
+    if(device == 0){
+      device = evidence_types[rand_int_threadsafe(0, count)];
+    }
+    hunter->device = device;
+    return;
+  }
+
+  EvidenceByte all = 0;
+  for(int i = 0; i < count; i++){
+    all |= (EvidenceByte)evidence_types[i];
+  }
+  for(;;){
+    EvidenceByte skip = casefile_claimed_devices(hunter->casefile) | collected;
+    enum EvidenceType device = informed ? evidence_best_device(skip, candidates) : 0;
+    EvidenceByte open = all & ~skip;
+    bool claim = true;
+
+    //nothing missing is free: share a missing device, or any once all are in
+    if(device == 0 && open == 0){
+      open = (all & ~collected) != 0 ? (all & ~collected) : all;
+      claim = false;
+    }
+    if(device == 0){
+      int pick = rand_int_threadsafe(0, __builtin_popcount(open));
+      while(pick-- > 0){
+        open &= (EvidenceByte)(open - 1);
+      }
+      device = (enum EvidenceType)(open & -open);
+    }
+
+    if(!claim){
+      hunter->device = device;
+      return;
+    }
+    if(casefile_claim_device(hunter->casefile, device)){
+      hunter->device = device;
+      hunter->device_claimed = true;
+      return;
+    }
+    //a teammate claimed it first, look again
+  }
+}
+
+/* 
+   Function: hunter_release_device
+   Purpose: Hands back the hunter's claimed device, if it holds one.
+   Params:   
+   Input/Output: struct Hunter* hunter - the hunter
+   Return: void
+*/
+static void hunter_release_device(struct Hunter* hunter){
+  if(hunter->device_claimed){
+    casefile_release_device(hunter->casefile, hunter->device);
+    hunter->device_claimed = false;
+  }
+}
+
 /* 
    Function: hunter_init
    Purpose: Initializes a hunter with a name, ID, device, and starting room.
@@ -12,10 +93,12 @@
     Input: int id - the hunter's ID
     Input: struct Room* starting_room - pointer to the starting room (Van)
     Input: struct CaseFile* casefile - pointer to the shared case file
+    Input: const struct SimParams* params - the run's options, NULL for the defaults
    Return: void
 */
 void hunter_init(struct Hunter* hunter, const char* name, int id, 
-                 struct Room* starting_room, struct CaseFile* casefile){
+                 struct Room* starting_room, struct CaseFile* casefile,
+                 const struct SimParams* params){
   //copy hunter with null terminator
   strncpy(hunter->name, name, MAX_HUNTER_NAME - 1);
   hunter->name[MAX_HUNTER_NAME - 1] = '\0';
@@ -23,12 +106,10 @@ void hunter_init(struct Hunter* hunter, const char* name, int id,
   hunter->id = id;
   hunter->current_room = starting_room;
   hunter->casefile = casefile;
+  hunter->params = params;
     
-  //assigning a random device
-  const enum EvidenceType* evidence_types = NULL;
-  int count = get_all_evidence_types(&evidence_types);
-  int random_index = rand_int_threadsafe(0, count);
-  hunter->device = evidence_types[random_index];
+  //assigning a device: at random, or one nobody on the team holds yet
+  hunter_pick_device(hunter, false, casefile->collected, casefile->candidates);
     
   //initializing the hunter path
   roomstack_init(&hunter->path);
@@ -39,25 +120,36 @@ void hunter_init(struct Hunter* hunter, const char* name, int id,
   hunter->should_exit = false;
   hunter->return_to_van = false;
   hunter->exit_reason = LR_BORED;
+  hunter->rng_seed = 0;
+  hunter->rng_state = 0;
+  memset(&hunter->stats, 0, sizeof(hunter->stats));
+  hunter->solve_steps = 0;
+  hunter->solve_seen = false;
     
   //Log initialization
-  log_hunter_init(id, starting_room->name, name, hunter->device);
+  LOG_EVENT(log_hunter_init(id, starting_room->name, name, hunter->device));
 }
 
 /* 
-   Function: hunter_move
+   Function: hunter_move_limited
    Purpose:  Moves a hunter from their current room to a target room.
    Handles room capacity checks and proper add/remove operations.
    Uses semaphore locking to prevent race conditions
    Params:   
    Input/Output: struct Hunter* hunter - the hunter to move
     Input: struct Room* target_room - the room to move to
+    Input: int occupancy - hunters the target may hold
    Return: bool - true if move was successful, false if room was full
 */
-bool hunter_move(struct Hunter* hunter, struct Room* target_room){
+STEP_INLINE bool hunter_move_limited(struct Hunter* hunter, struct Room* target_room, int occupancy){
 
   //where is the hunter coming from
   struct Room* from_room = hunter->current_room;
+
+  //already there, and locking the same room twice would deadlock
+  if(from_room == target_room){
+    return true;
+  }
     
   //lock rooms in consistent order by memory address
   //stops deadlock
@@ -65,11 +157,13 @@ bool hunter_move(struct Hunter* hunter, struct Room* target_room){
   struct Room* second = (from_room < target_room) ? target_room : from_room;
     
   //lock both rooms
-  sem_wait(&first->mutex);
-  sem_wait(&second->mutex);
+  long long wait_start = trace_begin();
+  metrics_lock(&first->mutex);
+  metrics_lock(&second->mutex);
+  trace_end("room_lock_wait", wait_start);
     
   //check room count
-  if(target_room->hunter_count >= MAX_ROOM_OCCUPANCY){
+  if(target_room->hunter_count >= occupancy){
     //room became full
     sem_post(&second->mutex);
     sem_post(&first->mutex);
@@ -90,12 +184,25 @@ bool hunter_move(struct Hunter* hunter, struct Room* target_room){
   sem_post(&first->mutex);
     
   //log the move
-  log_move(hunter->id, hunter->boredom, hunter->fear, 
-	   from_room->name, target_room->name, hunter->device);
+  LOG_EVENT(log_move(hunter->id, hunter->boredom, hunter->fear, 
+		     from_room->name, target_room->name, hunter->device));
     
   return true;
 }
 
+/* 
+   Function: hunter_move
+   Purpose:  hunter_move_limited with the run's room occupancy.
+   Params:   
+   Input/Output: struct Hunter* hunter - the hunter to move
+    Input: struct Room* target_room - the room to move to
+   Return: bool - true if move was successful, false if room was full
+*/
+bool hunter_move(struct Hunter* hunter, struct Room* target_room){
+  return hunter_move_limited(hunter, target_room,
+                             hunter->params != NULL ? hunter->params->occupancy : MAX_ROOM_OCCUPANCY);
+}
+
 /* 
    Function: hunter_update_stats
    Purpose: Updates hunter's fear and boredom based on ghost presence.
@@ -104,10 +211,10 @@ bool hunter_move(struct Hunter* hunter, struct Room* target_room){
    Return: void
 */
 void hunter_update_stats(struct Hunter* hunter){
-  //lock room to check if ghost is present
-  sem_wait(&hunter->current_room->mutex);
-  bool ghost_present = (hunter->current_room->ghost != NULL);
-  sem_post(&hunter->current_room->mutex);
+  //check if ghost is present from a seqlock snapshot, no room lock needed
+  struct RoomSnapshot snapshot;
+  room_snapshot(hunter->current_room, &snapshot);
+  bool ghost_present = (snapshot.ghost != NULL);
   
   //check if ghost is in the same room
   if(ghost_present){
@@ -139,22 +246,28 @@ void hunter_check_van(struct Hunter* hunter){
   //clear the return flag since we're here now
   if(hunter->return_to_van){
     hunter->return_to_van = false;
-    log_return_to_van(hunter->id, hunter->boredom, hunter->fear,
-		      hunter->current_room->name, hunter->device, false);
+    hunter->stats.van_returns++;
+    LOG_EVENT(log_return_to_van(hunter->id, hunter->boredom, hunter->fear,
+				hunter->current_room->name, hunter->device, false));
   }
     
   //check for victory
   //lock the casefile to check safely
-  sem_wait(&hunter->casefile->mutex);
+  metrics_lock(&hunter->casefile->mutex);
     
   //check if we have enough evidence to identify the ghost
   if(evidence_has_three_unique(hunter->casefile->collected) &&
       evidence_is_valid_ghost(hunter->casefile->collected)){
         
-    hunter->casefile->solved = true;
+    __atomic_store_n(&hunter->casefile->solved, true, __ATOMIC_RELAXED);
+    if(!hunter->solve_seen){
+      hunter->solve_steps = hunter->stats.iterations;
+      hunter->solve_seen = true;
+    }
         
     //unlock before exiting
     sem_post(&hunter->casefile->mutex);
+    casefile_cancel(hunter->casefile, hunter->params);
         
     //remove from room and exit, lcok the room first
     sem_wait(&hunter->current_room->mutex);
@@ -162,78 +275,113 @@ void hunter_check_van(struct Hunter* hunter){
     sem_post(&hunter->current_room->mutex);
     
     hunter->should_exit = true;
+    hunter_release_device(hunter);
     hunter->exit_reason = LR_EVIDENCE;
         
-    log_exit(hunter->id, hunter->boredom, hunter->fear, hunter->current_room->name, hunter->device, LR_EVIDENCE);
+    LOG_EVENT(log_exit(hunter->id, hunter->boredom, hunter->fear, hunter->current_room->name, hunter->device, LR_EVIDENCE));
     return;
   }
     
+  //snapshot what is known while we hold the lock, for informed swaps
+  EvidenceByte collected = hunter->casefile->collected;
+  unsigned candidates = hunter->casefile->candidates;
   sem_post(&hunter->casefile->mutex);
     
-  //swap to a new device
+  //swap to a new device, giving up the old one's claim first
   enum EvidenceType old_device = hunter->device;
-    
-  //pick a random new device
-  const enum EvidenceType* evidence_types = NULL;
-  int count = get_all_evidence_types(&evidence_types);
-  int random_index = rand_int_threadsafe(0, count);
-  hunter->device = evidence_types[random_index];
+  hunter_release_device(hunter);
+  hunter_pick_device(hunter, hunter->params != NULL && hunter->params->swap_mode == SWAP_INFORMED,
+                     collected, candidates);
+  hunter->stats.device_swaps++;
     
   //log the swap
-  log_swap(hunter->id, hunter->boredom, hunter->fear, old_device, hunter->device);
+  LOG_EVENT(log_swap(hunter->id, hunter->boredom, hunter->fear, old_device, hunter->device));
 }
 
 /* 
-   Function: hunter_check_exit_conditions
-   Purpose: Checks if hunter should exit due to fear or boredom.
+   Function: hunter_check_exit_limited
+   Purpose: Checks if hunter should exit due to fear, boredom or a cancelled hunt.
    Params:   
    Input/Output: struct Hunter* hunter - the hunter to check
+    Input: int boredom_max - boredom the hunter tolerates
+    Input: int fear_max - fear the hunter tolerates
    Return: void
 */
-void hunter_check_exit_conditions(struct Hunter* hunter){
+STEP_INLINE void hunter_check_exit_limited(struct Hunter* hunter, int boredom_max, int fear_max){
+  //the hunt is decided: leave with the team, as solved or with nothing left to find
+  if(casefile_is_cancelled(hunter->casefile)){
+    enum LogReason reason = hunter->casefile->solved ? LR_EVIDENCE : LR_BORED;
+    sem_wait(&hunter->current_room->mutex);
+    room_remove_hunter(hunter->current_room, hunter);
+    sem_post(&hunter->current_room->mutex);
+
+    hunter->should_exit = true;
+    hunter_release_device(hunter);
+    hunter->exit_reason = reason;
+
+    LOG_EVENT(log_exit(hunter->id, hunter->boredom, hunter->fear, hunter->current_room->name, hunter->device, reason));
+    return;
+  }
+
   //check boredom
-  if(hunter->boredom > ENTITY_BOREDOM_MAX){
+  if(hunter->boredom > boredom_max){
     sem_wait(&hunter->current_room->mutex);
     room_remove_hunter(hunter->current_room, hunter);
     sem_post(&hunter->current_room->mutex);
     
     hunter->should_exit = true;
+    hunter_release_device(hunter);
     hunter->exit_reason = LR_BORED;
         
-    log_exit(hunter->id, hunter->boredom, hunter->fear,
-	     hunter->current_room->name, hunter->device, LR_BORED);
+    LOG_EVENT(log_exit(hunter->id, hunter->boredom, hunter->fear,
+		       hunter->current_room->name, hunter->device, LR_BORED));
     return;
   }
     
   //check fear
-  if(hunter->fear > HUNTER_FEAR_MAX){
+  if(hunter->fear > fear_max){
     sem_wait(&hunter->current_room->mutex);
     room_remove_hunter(hunter->current_room, hunter);
     sem_post(&hunter->current_room->mutex);
     
     hunter->should_exit = true;
+    hunter_release_device(hunter);
     hunter->exit_reason = LR_AFRAID;
         
-    log_exit(hunter->id, hunter->boredom, hunter->fear, hunter->current_room->name, hunter->device, LR_AFRAID);
+    LOG_EVENT(log_exit(hunter->id, hunter->boredom, hunter->fear, hunter->current_room->name, hunter->device, LR_AFRAID));
     return;
   }
 }
 
 /* 
-   Function: hunter_gather_evidence
+   Function: hunter_check_exit_conditions
+   Purpose: hunter_check_exit_limited with the run's boredom and fear limits.
+   Params:   
+   Input/Output: struct Hunter* hunter - the hunter to check
+   Return: void
+*/
+void hunter_check_exit_conditions(struct Hunter* hunter){
+  const struct SimParams* params = hunter->params;
+  hunter_check_exit_limited(hunter, params != NULL ? params->boredom_max : ENTITY_BOREDOM_MAX,
+                            params != NULL ? params->fear_max : HUNTER_FEAR_MAX);
+}
+
+/* 
+   Function: hunter_gather_evidence_limited
    Purpose: Attempts to gather evidence from the current room. 
    Params:   
    Input/Output: struct Hunter* hunter - the hunter gathering evidence
+    Input: int return_chance - percent chance to head back when nothing is found
    Return: void
 */
-void hunter_gather_evidence(struct Hunter* hunter){
+STEP_INLINE void hunter_gather_evidence_limited(struct Hunter* hunter, int return_chance){
   //skip if already in van or returning to van
   if(hunter->current_room->is_exit){
     return;
   }
 
   //lockroom and check if room has evidence matching device
-  sem_wait(&hunter->current_room->mutex);
+  metrics_lock(&hunter->current_room->mutex);
   bool has_matching_evidence = evidence_has(hunter->current_room->evidence, hunter->device);
     
   //check if room has evidence matching our device
@@ -241,50 +389,110 @@ void hunter_gather_evidence(struct Hunter* hunter){
     //found matching evidence!
         
     //remove from room
-    evidence_clear(&hunter->current_room->evidence, hunter->device);
+    room_write_begin(hunter->current_room);
+    __atomic_store_n(&hunter->current_room->evidence, (EvidenceByte)(hunter->current_room->evidence & ~hunter->device), __ATOMIC_RELAXED);
+    room_write_end(hunter->current_room);
 
     //unlock room before locking
     sem_post(&hunter->current_room->mutex);
         
-    //add to shared casefile
-    sem_wait(&hunter->casefile->mutex);
-    evidence_set(&hunter->casefile->collected, hunter->device);
+    //add to shared casefile, before the count that may end the hunt
+    metrics_lock(&hunter->casefile->mutex);
+    evidence_collect(hunter->casefile, hunter->device);
     sem_post(&hunter->casefile->mutex);
+    casefile_evidence_taken(hunter->casefile, hunter->params);
         
     //log the evidence collection
-    log_evidence(hunter->id, hunter->boredom, hunter->fear, hunter->current_room->name, hunter->device);
+    hunter->stats.evidence++;
+    LOG_EVENT(log_evidence(hunter->id, hunter->boredom, hunter->fear, hunter->current_room->name, hunter->device));
         
     //set flag to return to van
     if(!hunter->current_room->is_exit){
       hunter->return_to_van = true;
-      log_return_to_van(hunter->id, hunter->boredom, hunter->fear, hunter->current_room->name, hunter->device, true);
+      LOG_EVENT(log_return_to_van(hunter->id, hunter->boredom, hunter->fear, hunter->current_room->name, hunter->device, true));
     }
   }else{
     //no matching evidence
     sem_post(&hunter->current_room->mutex);
+
+    //tell the team this room came up empty for this device; rooms where
+    //evidence turned up stay attractive, the ghost is likely close by
+    if(hunter->params != NULL && hunter->params->explore_mode == EXPLORE_COORDINATED){
+      room_mark_swept(hunter->current_room, hunter->device, casefile_next_sweep(hunter->casefile));
+    }
     
     //small chance to return anyway
     int random = rand_int_threadsafe(0, 100);
-    if(random < 10){  //10% chance
+    if(random < return_chance){
       hunter->return_to_van = true;
-      log_return_to_van(hunter->id, hunter->boredom, hunter->fear, hunter->current_room->name, hunter->device, true);
+      LOG_EVENT(log_return_to_van(hunter->id, hunter->boredom, hunter->fear, hunter->current_room->name, hunter->device, true));
     }
   }
 }
 
 /* 
-   Function: hunter_choose_move
+   Function: hunter_gather_evidence
+   Purpose: hunter_gather_evidence_limited with the run's return chance.
+   Params:   
+   Input/Output: struct Hunter* hunter - the hunter gathering evidence
+   Return: void
+*/
+void hunter_gather_evidence(struct Hunter* hunter){
+  hunter_gather_evidence_limited(hunter, hunter->params != NULL ? hunter->params->return_chance : HUNTER_RETURN_CHANCE);
+}
+
+/* 
+   Function: hunter_least_swept
+   Purpose: Picks the neighbour the team searched longest ago with the
+   hunter's device, never-searched rooms first and ties at random. The van
+   holds no evidence, so it is only taken when nothing else connects.
+   Params:   
+    Input: struct Hunter* hunter - the exploring hunter
+   Return: struct Room* - the room to try, NULL if there are no connections
+*/
+static struct Room* hunter_least_swept(struct Hunter* hunter){
+  struct Room* room = hunter->current_room;
+  struct Room* best = NULL;
+  unsigned long best_stamp = 0;
+  int ties = 0;
+
+  for(int i = 0; i < room->connection_count; i++){
+    struct Room* next = room->connections[i];
+    unsigned long stamp = next->is_exit ? ULONG_MAX : room_last_swept(next, hunter->device);
+    if(best == NULL || stamp < best_stamp){
+      best = next;
+      best_stamp = stamp;
+      ties = 1;
+    }else if(stamp == best_stamp && rand_int_threadsafe(0, ++ties) == 0){
+      //each of the tied rooms ends up picked with the same odds
+      best = next;
+    }
+  }
+  return best;
+}
+
+/* 
+   Function: hunter_choose_move_limited
    Purpose: Chooses which room to move to next (exploring or returning).
    Params:   
    Input/Output: struct Hunter* hunter - the hunter choosing a move
+    Input: int occupancy - hunters a room may hold
    Return: void
 */
-void hunter_choose_move(struct Hunter* hunter){
+STEP_INLINE void hunter_choose_move_limited(struct Hunter* hunter, int occupancy){
   struct Room* target_room = NULL;
   struct Room* old_room = hunter->current_room;
+  bool shortest = hunter->params != NULL && hunter->params->return_mode == RETURN_SHORTEST;
     
   //check if returning to van
-  if(hunter->return_to_van){
+  if(hunter->return_to_van && shortest){
+    //one hop along the precomputed route, no breadcrumbs needed
+    target_room = hunter->current_room->van_next_hop;
+
+    if(target_room == NULL){
+      return;
+    }
+  } else if(hunter->return_to_van){
     //pop from breadcrumb stack
     target_room = roomstack_pop(&hunter->path);
         
@@ -292,6 +500,13 @@ void hunter_choose_move(struct Hunter* hunter){
       //stack was empty, we must be at van already
       return;
     }
+  } else if(hunter->params != NULL && hunter->params->explore_mode == EXPLORE_COORDINATED){
+    //exploring with the team: the room least recently swept for our device
+    target_room = hunter_least_swept(hunter);
+
+    if(target_room == NULL){
+      return;
+    }
   } else{
     //exploring: pick random connected room
     if(hunter->current_room->connection_count == 0){
@@ -303,12 +518,34 @@ void hunter_choose_move(struct Hunter* hunter){
   }
     
   //attempt the move
-  bool success = hunter_move(hunter, target_room);
+  bool success = hunter_move_limited(hunter, target_room, occupancy);
+  if(success){
+    hunter->stats.moves++;
+  }else{
+    hunter->stats.moves_full++;
+  }
     
   //if exploring and move succeeded, push old room to stack
-  if(success && !hunter->return_to_van){
+  if(success && !hunter->return_to_van && !shortest){
     roomstack_push(&hunter->path, old_room);
   }
+
+  //returning but the room was full: keep the crumb so the trail stays
+  //connected instead of skipping ahead to a room that isn't adjacent
+  if(!success && hunter->return_to_van && !shortest){
+    roomstack_push(&hunter->path, target_room);
+  }
+}
+
+/* 
+   Function: hunter_choose_move
+   Purpose: hunter_choose_move_limited with the run's room occupancy.
+   Params:   
+   Input/Output: struct Hunter* hunter - the hunter choosing a move
+   Return: void
+*/
+void hunter_choose_move(struct Hunter* hunter){
+  hunter_choose_move_limited(hunter, hunter->params != NULL ? hunter->params->occupancy : MAX_ROOM_OCCUPANCY);
 }
 
 /* 
@@ -323,6 +560,87 @@ void hunter_cleanup(struct Hunter* hunter){
   roomstack_cleanup(&hunter->path);
 }
 
+/* 
+   Function: hunter_step_limited
+   Purpose:  Runs one pass of the hunter's loop on whatever RNG stream the
+   calling thread has bound. Does nothing once the hunter has exited.
+   Params:   
+   Input/Output: struct Hunter* hunter - the hunter to step
+    Input: int boredom_max, fear_max, occupancy, return_chance - the limits
+   Return: void
+*/
+STEP_INLINE void hunter_step_limited(struct Hunter* hunter, int boredom_max, int fear_max,
+                                     int occupancy, int return_chance){
+  if(hunter->should_exit){
+    return;
+  }
+
+  //note how far this hunter had got when the case was solved; the flag
+  //shares a line with the cancel flag every pass reads anyway
+  if(!hunter->solve_seen && __atomic_load_n(&hunter->casefile->solved, __ATOMIC_RELAXED)){
+    hunter->solve_steps = hunter->stats.iterations;
+    hunter->solve_seen = true;
+  }
+
+  hunter->stats.iterations++;
+  if(hunter->stats.iterations % METRICS_STEP_BATCH == 0){
+    metrics_add_steps(METRICS_STEP_BATCH);
+  }
+
+  //update fear or boredom based on the ghost and check if hunter is in the va
+  long long phase = trace_begin();
+  hunter_update_stats(hunter);
+  trace_end("update_stats", phase);
+
+  phase = trace_begin();
+  hunter_check_van(hunter);
+  trace_end("check_van", phase);
+
+  //Only continue if hunter exited
+  if(!hunter->should_exit){
+    hunter_check_exit_limited(hunter, boredom_max, fear_max);
+  }
+
+  //only continue if hunter has NOT exited, hes tuff
+  if(!hunter->should_exit){
+    phase = trace_begin();
+    hunter_gather_evidence_limited(hunter, return_chance);
+    trace_end("gather_evidence", phase);
+
+    phase = trace_begin();
+    hunter_choose_move_limited(hunter, occupancy);
+    trace_end("choose_move", phase);
+  }
+}
+
+//one copy of the step with the limits as constants, one reading the run's
+//parameters; every helper above is inlined into both
+#define HUNTER_STEP_VARIANT(name, BOREDOM_MAX, FEAR_MAX, OCCUPANCY, RETURN_CHANCE) \
+  static void name(struct Hunter* hunter){                                         \
+    hunter_step_limited(hunter, BOREDOM_MAX, FEAR_MAX, OCCUPANCY, RETURN_CHANCE); \
+  }
+
+HUNTER_STEP_VARIANT(hunter_step_default, ENTITY_BOREDOM_MAX, HUNTER_FEAR_MAX,
+                    MAX_ROOM_OCCUPANCY, HUNTER_RETURN_CHANCE)
+HUNTER_STEP_VARIANT(hunter_step_tuned, hunter->params->boredom_max, hunter->params->fear_max,
+                    hunter->params->occupancy, hunter->params->return_chance)
+
+/* 
+   Function: hunter_step
+   Purpose:  Runs one pass of the hunter's loop, through the step compiled
+   for the default limits unless the run tunes them.
+   Params:   
+   Input/Output: struct Hunter* hunter - the hunter to step
+   Return: void
+*/
+void hunter_step(struct Hunter* hunter){
+  if(hunter->params != NULL && hunter->params->tuned){
+    hunter_step_tuned(hunter);
+  }else{
+    hunter_step_default(hunter);
+  }
+}
+
 /* 
    Function: hunter_thread
    Purpose:  Thread function for a hunter. Runs the hunter's behavior loop.
@@ -334,25 +652,22 @@ void* hunter_thread(void* data){
   //cast the generic pointer back to a Hunter pointer
   struct Hunter* hunter = (struct Hunter*)data;
 
-  //Keep running until hunter decides to exit
-  while(!hunter->should_exit){
-    //update fear or boredom based on the ghost and check if hunter is in the va
-    hunter_update_stats(hunter);
-    hunter_check_van(hunter);
+  //every hunter draws from its own stream, seeded or from the clock
+  rand_bind_thread(&hunter->rng_state);
 
-    //Only continue if hunter exited
-    if(!hunter->should_exit){
-      hunter_check_exit_conditions(hunter);
-    }
+  trace_thread_begin(hunter->id, "hunter", hunter->name);
 
-    //only continue if hunter has NOT exited, hes tuff
-    if(!hunter->should_exit){
-      hunter_gather_evidence(hunter);
-      hunter_choose_move(hunter);
-    }
+  //the limits cannot change during a hunt, so pick the step once
+  void (*step)(struct Hunter*) = (hunter->params != NULL && hunter->params->tuned)
+    ? hunter_step_tuned : hunter_step_default;
+
+  //Keep running until hunter decides to exit
+  while(!hunter->should_exit){
+    step(hunter);
   }
+
+  trace_instant("exit");
+  metrics_add_steps(hunter->stats.iterations % METRICS_STEP_BATCH);
     
   return NULL;
 }
-
-
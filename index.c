@@ -0,0 +1,840 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <glob.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "defs.h"
+
+/*
+  ghost_index: sidecar indexes for random access into the CSV logs.
+  "build" reads log_<id>.csv once and writes log_<id>.csv.idx next to it:
+
+    - a sparse time index, one (timestamp, byte offset) entry every
+      INDEX_STRIDE lines, for jumping to a moment of the hunt;
+    - posting lists, the byte offset of every line for each room and for
+      each action, for jumping straight to the lines a filter can match.
+
+  "query" answers "what happened in this room between t1 and t2" or "every
+  EVIDENCE event" by reading the index, mapping the log and touching only
+  the lines the index points at. Results from several files come out in
+  one timeline through a TimelineHeap. An index whose log has since grown
+  is rebuilt on the spot.
+
+  The file is fixed-width words in host byte order, framed by INDEX_MAGIC
+  like a checkpoint. Offsets are 32-bit (the log writer caps each file far
+  below 4 GiB); larger files are refused.
+*/
+
+#define INDEX_MAGIC 0x58494847u  //"GHIX" little-endian, first and last word of the file
+#define INDEX_VERSION 1
+#define INDEX_STRIDE 64          //lines per sparse time entry
+#define INDEX_MAX_KEYS MAX_ROOMS
+#define INDEX_ROOM_FIELD 3
+#define INDEX_ACTION_FIELD 7
+
+//Every line offset holding one room or action name
+struct IndexKey {
+  char name[MAX_ROOM_NAME];
+  uint32_t* offsets;
+  uint32_t count;
+  uint32_t capacity;
+};
+
+//The posting lists of one column
+struct IndexTable {
+  struct IndexKey keys[INDEX_MAX_KEYS];
+  int count;
+};
+
+//One sparse time entry: the line at offset is the first with this timestamp or later
+struct IndexMark {
+  int64_t timestamp;
+  uint32_t offset;
+  uint32_t reserved;       //keeps the written entry free of padding
+};
+
+//A whole sidecar, in memory
+struct LogIndex {
+  uint64_t source_size;
+  uint32_t lines;
+  uint32_t sorted;         //1 if timestamps never go down, so the marks can be searched
+  struct IndexMark* marks;
+  uint32_t mark_count;
+  struct IndexTable rooms;
+  struct IndexTable actions;
+};
+
+//What a query asks for; NULL or the range limits when a filter is off
+struct IndexQuery {
+  long long from;
+  long long to;
+  const char* room;
+  const char* action;
+};
+
+//One queried log: its mapping and the offsets of its matching lines, in file order
+struct IndexResult {
+  const char* data;
+  size_t size;
+  uint32_t* offsets;
+  long long* timestamps;
+  size_t count;
+  size_t capacity;
+  size_t next;
+};
+
+static long long now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+   Function: field_span
+   Purpose:  Finds one comma-separated field of a line.
+   Params:
+    Input: const char* line - the line
+    Input: const char* end - end of the mapped file
+    Input: int field - which field, from 0
+    Output: const char** stop - one past the field's last byte
+   Return: const char* - the field's first byte, NULL if the line is shorter
+*/
+static const char* field_span(const char* line, const char* end, int field, const char** stop){
+  const char* c = line;
+  for(int i = 0; i < field; i++){
+    while(c < end && *c != ',' && *c != '\n') c++;
+    if(c >= end || *c != ','){
+      return NULL;
+    }
+    c++;
+  }
+  const char* start = c;
+  while(c < end && *c != ',' && *c != '\n' && *c != '\r') c++;
+  *stop = c;
+  return start;
+}
+
+/*
+   Function: line_timestamp
+   Purpose:  Reads the leading timestamp of a line.
+   Params:
+    Input: const char* line - the line
+    Input: const char* end - end of the mapped file
+    Output: long long* timestamp - the value
+   Return: bool - false if the line does not start with one
+*/
+static bool line_timestamp(const char* line, const char* end, long long* timestamp){
+  long long value = 0;
+  const char* c = line;
+  while(c < end && *c >= '0' && *c <= '9'){
+    value = value * 10 + (*c - '0');
+    c++;
+  }
+  *timestamp = value;
+  return c > line && c < end && *c == ',';
+}
+
+/*
+   Function: table_find
+   Purpose:  Looks a name up in a column's posting lists.
+   Params:
+    Input: const struct IndexTable* table - the lists
+    Input: const char* start - first byte of the name
+    Input: size_t length - its length
+   Return: int - the key's position, -1 if absent
+*/
+static int table_find(const struct IndexTable* table, const char* start, size_t length){
+  for(int i = 0; i < table->count; i++){
+    if(strncmp(table->keys[i].name, start, length) == 0 && table->keys[i].name[length] == '\0'){
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*
+   Function: table_add
+   Purpose:  Appends a line offset to a name's list, adding the name if new.
+   Params:
+    Input/Output: struct IndexTable* table - the lists
+    Input: const char* start - first byte of the name
+    Input: const char* stop - one past its last byte
+    Input: uint32_t offset - the line
+   Return: bool - false if the table is full or out of memory
+*/
+static bool table_add(struct IndexTable* table, const char* start, const char* stop, uint32_t offset){
+  size_t length = (size_t)(stop - start);
+  if(length == 0){
+    return true;
+  }
+  if(length >= MAX_ROOM_NAME){
+    return false;
+  }
+  int index = table_find(table, start, length);
+  if(index < 0){
+    if(table->count >= INDEX_MAX_KEYS){
+      return false;
+    }
+    index = table->count++;
+    memcpy(table->keys[index].name, start, length);
+    table->keys[index].name[length] = '\0';
+  }
+
+  struct IndexKey* key = &table->keys[index];
+  if(key->count == key->capacity){
+    uint32_t capacity = key->capacity ? key->capacity * 2 : 256;
+    uint32_t* offsets = realloc(key->offsets, capacity * sizeof(uint32_t));
+    if(offsets == NULL){
+      return false;
+    }
+    key->offsets = offsets;
+    key->capacity = capacity;
+  }
+  key->offsets[key->count++] = offset;
+  return true;
+}
+
+/*
+   Function: index_free
+   Purpose:  Releases everything an index holds.
+   Params:
+    Input/Output: struct LogIndex* index - the index
+   Return: void
+*/
+static void index_free(struct LogIndex* index){
+  free(index->marks);
+  for(int i = 0; i < index->rooms.count; i++) free(index->rooms.keys[i].offsets);
+  for(int i = 0; i < index->actions.count; i++) free(index->actions.keys[i].offsets);
+  memset(index, 0, sizeof(*index));
+}
+
+/*
+   Function: map_log
+   Purpose:  Maps a log file read-only.
+   Params:
+    Input: const char* path - the file
+    Output: const char** data - the contents, NULL for an empty file
+    Output: size_t* size - their length
+   Return: bool - false if the file could not be opened or mapped
+*/
+static bool map_log(const char* path, const char** data, size_t* size){
+  *data = NULL;
+  *size = 0;
+  int fd = open(path, O_RDONLY);
+  if(fd < 0){
+    perror(path);
+    return false;
+  }
+  struct stat info;
+  if(fstat(fd, &info) != 0){
+    perror(path);
+    close(fd);
+    return false;
+  }
+  if(info.st_size == 0){
+    close(fd);
+    return true;
+  }
+  void* mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(mapped == MAP_FAILED){
+    perror(path);
+    return false;
+  }
+  *data = mapped;
+  *size = (size_t)info.st_size;
+  return true;
+}
+
+/*
+   Function: index_build
+   Purpose:  Reads a whole log and fills an index for it.
+   Params:
+    Output: struct LogIndex* index - the index
+    Input: const char* path - the log
+   Return: bool - false if the log cannot be read or does not fit the format
+*/
+static bool index_build(struct LogIndex* index, const char* path){
+  memset(index, 0, sizeof(*index));
+  index->sorted = 1;
+
+  size_t size = 0;
+  const char* data = NULL;
+  if(!map_log(path, &data, &size)){
+    return false;
+  }
+  if(data == NULL){
+    return true;
+  }
+  if(size > UINT32_MAX){
+    fprintf(stderr, "%s: too large to index\n", path);
+    munmap((void*)data, size);
+    return false;
+  }
+  index->source_size = size;
+
+  uint32_t mark_capacity = 0;
+  long long previous = 0;
+  bool ok = true;
+  const char* end = data + size;
+  for(const char* line = data; line < end && ok; ){
+    const char* newline = memchr(line, '\n', (size_t)(end - line));
+    const char* next = newline != NULL ? newline + 1 : end;
+    long long timestamp = 0;
+    if(!line_timestamp(line, end, &timestamp)){
+      line = next;
+      continue;
+    }
+    uint32_t offset = (uint32_t)(line - data);
+
+    if(index->lines > 0 && timestamp < previous){
+      index->sorted = 0;
+    }
+    previous = timestamp;
+    if(index->lines % INDEX_STRIDE == 0){
+      if(index->mark_count == mark_capacity){
+        mark_capacity = mark_capacity ? mark_capacity * 2 : 256;
+        struct IndexMark* marks = realloc(index->marks, mark_capacity * sizeof(struct IndexMark));
+        if(marks == NULL){
+          ok = false;
+          break;
+        }
+        index->marks = marks;
+      }
+      index->marks[index->mark_count].timestamp = timestamp;
+      index->marks[index->mark_count].offset = offset;
+      index->marks[index->mark_count].reserved = 0;
+      index->mark_count++;
+    }
+
+    const char* stop = NULL;
+    const char* room = field_span(line, end, INDEX_ROOM_FIELD, &stop);
+    if(room != NULL){
+      ok = table_add(&index->rooms, room, stop, offset);
+    }
+    const char* action = field_span(line, end, INDEX_ACTION_FIELD, &stop);
+    if(ok && action != NULL){
+      ok = table_add(&index->actions, action, stop, offset);
+    }
+    index->lines++;
+    line = next;
+  }
+
+  munmap((void*)data, size);
+  if(!ok){
+    fprintf(stderr, "%s: more names than an index can hold\n", path);
+  }
+  return ok;
+}
+
+/*
+   Function: write_words
+   Purpose:  Writes a block, clearing ok on a short write.
+   Params:
+    Input: FILE* file - the open file
+    Input: const void* data - the block
+    Input: size_t size - its size in bytes
+    Input/Output: bool* ok - cleared on failure; no-op once clear
+   Return: void
+*/
+static void write_words(FILE* file, const void* data, size_t size, bool* ok){
+  if(*ok && size > 0 && fwrite(data, size, 1, file) != 1){
+    *ok = false;
+  }
+}
+
+/*
+   Function: read_words
+   Purpose:  Reads a block, clearing ok on a short read.
+   Params:
+    Input: FILE* file - the open file
+    Output: void* data - the block
+    Input: size_t size - its size in bytes
+    Input/Output: bool* ok - cleared on failure; no-op once clear
+   Return: void
+*/
+static void read_words(FILE* file, void* data, size_t size, bool* ok){
+  if(*ok && size > 0 && fread(data, size, 1, file) != 1){
+    *ok = false;
+  }
+}
+
+/*
+   Function: write_table
+   Purpose:  Writes one column's names and posting lists.
+   Params:
+    Input: FILE* file - the open file
+    Input: const struct IndexTable* table - the lists
+    Input/Output: bool* ok - cleared on failure
+   Return: void
+*/
+static void write_table(FILE* file, const struct IndexTable* table, bool* ok){
+  uint32_t count = (uint32_t)table->count;
+  write_words(file, &count, sizeof(count), ok);
+  for(int i = 0; i < table->count; i++){
+    write_words(file, table->keys[i].name, MAX_ROOM_NAME, ok);
+    write_words(file, &table->keys[i].count, sizeof(uint32_t), ok);
+    write_words(file, table->keys[i].offsets, table->keys[i].count * sizeof(uint32_t), ok);
+  }
+}
+
+/*
+   Function: read_table
+   Purpose:  Reads one column's names and posting lists.
+   Params:
+    Input: FILE* file - the open file
+    Output: struct IndexTable* table - the lists
+    Input/Output: bool* ok - cleared on failure or a bad count
+   Return: void
+*/
+static void read_table(FILE* file, struct IndexTable* table, bool* ok){
+  uint32_t count = 0;
+  read_words(file, &count, sizeof(count), ok);
+  if(count > INDEX_MAX_KEYS){
+    *ok = false;
+  }
+  for(uint32_t i = 0; *ok && i < count; i++){
+    struct IndexKey* key = &table->keys[table->count++];
+    read_words(file, key->name, MAX_ROOM_NAME, ok);
+    key->name[MAX_ROOM_NAME - 1] = '\0';
+    read_words(file, &key->count, sizeof(uint32_t), ok);
+    if(*ok){
+      key->capacity = key->count;
+      key->offsets = malloc((key->count > 0 ? key->count : 1) * sizeof(uint32_t));
+      if(key->offsets == NULL){
+        *ok = false;
+      }
+    }
+    read_words(file, key->offsets, key->count * sizeof(uint32_t), ok);
+  }
+}
+
+/*
+   Function: index_save
+   Purpose:  Writes an index to its sidecar file.
+   Params:
+    Input: const struct LogIndex* index - the index
+    Input: const char* path - the sidecar
+   Return: bool - false if the file could not be written in full
+*/
+static bool index_save(const struct LogIndex* index, const char* path){
+  FILE* file = fopen(path, "wb");
+  if(file == NULL){
+    perror(path);
+    return false;
+  }
+  bool ok = true;
+  uint32_t header[] = { INDEX_MAGIC, INDEX_VERSION, INDEX_STRIDE, index->lines, index->sorted, index->mark_count };
+  write_words(file, header, sizeof(header), &ok);
+  write_words(file, &index->source_size, sizeof(uint64_t), &ok);
+  write_words(file, index->marks, index->mark_count * sizeof(struct IndexMark), &ok);
+  write_table(file, &index->rooms, &ok);
+  write_table(file, &index->actions, &ok);
+  uint32_t magic = INDEX_MAGIC;
+  write_words(file, &magic, sizeof(magic), &ok);
+  if(fclose(file) != 0 || !ok){
+    fprintf(stderr, "%s: write failed\n", path);
+    return false;
+  }
+  return true;
+}
+
+/*
+   Function: index_load
+   Purpose:  Reads a sidecar file back.
+   Params:
+    Output: struct LogIndex* index - the index
+    Input: const char* path - the sidecar
+   Return: bool - false if it is missing, truncated or from another version
+*/
+static bool index_load(struct LogIndex* index, const char* path){
+  memset(index, 0, sizeof(*index));
+  FILE* file = fopen(path, "rb");
+  if(file == NULL){
+    return false;
+  }
+  bool ok = true;
+  uint32_t header[6];
+  read_words(file, header, sizeof(header), &ok);
+  if(ok && (header[0] != INDEX_MAGIC || header[1] != INDEX_VERSION || header[2] != INDEX_STRIDE)){
+    ok = false;
+  }
+  if(ok){
+    index->lines = header[3];
+    index->sorted = header[4];
+    index->mark_count = header[5];
+    index->marks = malloc((index->mark_count > 0 ? index->mark_count : 1) * sizeof(struct IndexMark));
+    ok = index->marks != NULL;
+  }
+  read_words(file, &index->source_size, sizeof(uint64_t), &ok);
+  read_words(file, index->marks, index->mark_count * sizeof(struct IndexMark), &ok);
+  read_table(file, &index->rooms, &ok);
+  read_table(file, &index->actions, &ok);
+  uint32_t magic = 0;
+  read_words(file, &magic, sizeof(magic), &ok);
+  fclose(file);
+  if(!ok || magic != INDEX_MAGIC){
+    index_free(index);
+    return false;
+  }
+  return true;
+}
+
+/*
+   Function: index_refresh
+   Purpose:  Loads a log's sidecar, or builds and saves it when it is
+   missing or was made before the log last grew.
+   Params:
+    Output: struct LogIndex* index - the index
+    Input: const char* path - the log
+    Input: bool force - rebuild even if the sidecar is current
+   Return: bool - false if no index could be had
+*/
+static bool index_refresh(struct LogIndex* index, const char* path, bool force){
+  char sidecar[MAX_PATH_LENGTH + 8];
+  snprintf(sidecar, sizeof(sidecar), "%s.idx", path);
+
+  struct stat info;
+  if(stat(path, &info) != 0){
+    perror(path);
+    return false;
+  }
+  if(!force && index_load(index, sidecar) && index->source_size == (uint64_t)info.st_size){
+    return true;
+  }
+  index_free(index);
+  if(!index_build(index, path)){
+    index_free(index);
+    return false;
+  }
+  if(!index_save(index, sidecar)){
+    index_free(index);
+    return false;
+  }
+  fprintf(stderr, "indexed %s: %u lines, %u marks, %d rooms, %d actions%s\n", path, index->lines,
+          index->mark_count, index->rooms.count, index->actions.count,
+          index->sorted ? "" : " (out of time order: time ranges scan the whole file)");
+  return true;
+}
+
+/*
+   Function: lower_offset
+   Purpose:  Binary search in a posting list.
+   Params:
+    Input: const uint32_t* offsets - the list, ascending
+    Input: uint32_t count - its length
+    Input: uint32_t offset - the value to look for
+   Return: uint32_t - the first position holding offset or more
+*/
+static uint32_t lower_offset(const uint32_t* offsets, uint32_t count, uint32_t offset){
+  uint32_t low = 0;
+  uint32_t high = count;
+  while(low < high){
+    uint32_t middle = low + (high - low) / 2;
+    if(offsets[middle] < offset){
+      low = middle + 1;
+    }else{
+      high = middle;
+    }
+  }
+  return low;
+}
+
+/*
+   Function: query_window
+   Purpose:  Narrows a time range to a byte range with the sparse marks.
+   Params:
+    Input: const struct LogIndex* index - the index
+    Input: const struct IndexQuery* query - the range
+    Output: uint32_t* low - no match starts before this offset
+    Output: uint32_t* high - none starts at or after it
+   Return: void
+*/
+static void query_window(const struct LogIndex* index, const struct IndexQuery* query,
+                         uint32_t* low, uint32_t* high){
+  *low = 0;
+  *high = (uint32_t)index->source_size;
+  if(!index->sorted){
+    return;
+  }
+  //the last mark before "from" starts the stride that can hold it
+  for(uint32_t a = 0, b = index->mark_count; a < b; ){
+    uint32_t middle = a + (b - a) / 2;
+    if(index->marks[middle].timestamp < query->from){
+      *low = index->marks[middle].offset;
+      a = middle + 1;
+    }else{
+      b = middle;
+    }
+  }
+  //the first mark after "to" starts a stride that cannot
+  for(uint32_t a = 0, b = index->mark_count; a < b; ){
+    uint32_t middle = a + (b - a) / 2;
+    if(index->marks[middle].timestamp > query->to){
+      *high = index->marks[middle].offset;
+      b = middle;
+    }else{
+      a = middle + 1;
+    }
+  }
+}
+
+/*
+   Function: result_add
+   Purpose:  Records one matching line.
+   Params:
+    Input/Output: struct IndexResult* result - the matches so far
+    Input: uint32_t offset - the line
+    Input: long long timestamp - its timestamp
+   Return: bool - false if out of memory
+*/
+static bool result_add(struct IndexResult* result, uint32_t offset, long long timestamp){
+  if(result->count == result->capacity){
+    size_t capacity = result->capacity ? result->capacity * 2 : 256;
+    uint32_t* offsets = realloc(result->offsets, capacity * sizeof(uint32_t));
+    long long* timestamps = realloc(result->timestamps, capacity * sizeof(long long));
+    if(offsets != NULL) result->offsets = offsets;
+    if(timestamps != NULL) result->timestamps = timestamps;
+    if(offsets == NULL || timestamps == NULL){
+      return false;
+    }
+    result->capacity = capacity;
+  }
+  result->offsets[result->count] = offset;
+  result->timestamps[result->count] = timestamp;
+  result->count++;
+  return true;
+}
+
+/*
+   Function: line_matches
+   Purpose:  Checks one line against every filter of a query.
+   Params:
+    Input: const char* line - the line
+    Input: const char* end - end of the mapped file
+    Input: const struct IndexQuery* query - the filters
+    Output: long long* timestamp - the line's timestamp
+   Return: bool - true if it matches
+*/
+static bool line_matches(const char* line, const char* end, const struct IndexQuery* query, long long* timestamp){
+  if(!line_timestamp(line, end, timestamp) || *timestamp < query->from || *timestamp > query->to){
+    return false;
+  }
+  const char* filters[2] = { query->room, query->action };
+  const int fields[2] = { INDEX_ROOM_FIELD, INDEX_ACTION_FIELD };
+  for(int i = 0; i < 2; i++){
+    if(filters[i] == NULL){
+      continue;
+    }
+    const char* stop = NULL;
+    const char* start = field_span(line, end, fields[i], &stop);
+    size_t length = strlen(filters[i]);
+    if(start == NULL || (size_t)(stop - start) != length || memcmp(start, filters[i], length) != 0){
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+   Function: query_file
+   Purpose:  Finds the matching lines of one log through its index. With a
+   room or action filter only that name's posting list inside the time
+   window is visited; without one, only the lines inside the window.
+   Params:
+    Input: const struct LogIndex* index - the log's index
+    Input/Output: struct IndexResult* result - holds the mapped log, receives the matches
+    Input: const struct IndexQuery* query - the filters
+    Output: size_t* examined - lines looked at
+   Return: bool - false if the index names no such room or action, or out of memory
+*/
+static bool query_file(const struct LogIndex* index, struct IndexResult* result,
+                       const struct IndexQuery* query, size_t* examined){
+  uint32_t low = 0;
+  uint32_t high = 0;
+  query_window(index, query, &low, &high);
+  const char* end = result->data + result->size;
+
+  //the shorter posting list of the two filters drives the search
+  const struct IndexKey* list = NULL;
+  const struct IndexTable* tables[2] = { &index->rooms, &index->actions };
+  const char* names[2] = { query->room, query->action };
+  for(int i = 0; i < 2; i++){
+    if(names[i] == NULL){
+      continue;
+    }
+    int found = table_find(tables[i], names[i], strlen(names[i]));
+    if(found < 0){
+      return true;
+    }
+    if(list == NULL || tables[i]->keys[found].count < list->count){
+      list = &tables[i]->keys[found];
+    }
+  }
+
+  long long timestamp = 0;
+  if(list != NULL){
+    for(uint32_t i = lower_offset(list->offsets, list->count, low); i < list->count && list->offsets[i] < high; i++){
+      (*examined)++;
+      if(line_matches(result->data + list->offsets[i], end, query, &timestamp) &&
+         !result_add(result, list->offsets[i], timestamp)){
+        return false;
+      }
+    }
+    return true;
+  }
+
+  for(const char* line = result->data + low; line < result->data + high; ){
+    const char* newline = memchr(line, '\n', (size_t)(end - line));
+    (*examined)++;
+    if(line_matches(line, end, query, &timestamp) &&
+       !result_add(result, (uint32_t)(line - result->data), timestamp)){
+      return false;
+    }
+    line = newline != NULL ? newline + 1 : end;
+  }
+  return true;
+}
+
+/*
+   Function: parse_time
+   Purpose:  Reads a --from/--to value.
+   Params:
+    Input: const char* text - milliseconds since the epoch, as in the logs
+    Output: long long* value - the time
+   Return: bool - false if it is not a number
+*/
+static bool parse_time(const char* text, long long* value){
+  char* end = NULL;
+  *value = strtoll(text, &end, 10);
+  return end != text && *end == '\0';
+}
+
+/*
+   Function: print_usage
+   Purpose:  Prints how to call the tool.
+   Params:
+    Input: const char* program - argv[0]
+   Return: void
+*/
+static void print_usage(const char* program){
+  fprintf(stderr, "Usage: %s build [log_<id>.csv ...]\n", program);
+  fprintf(stderr, "       %s query [--from MS] [--to MS] [--room NAME] [--action NAME] [log_<id>.csv ...]\n", program);
+  fprintf(stderr, "With no files every log_*.csv in the current directory is used.\n");
+  fprintf(stderr, "query builds missing or stale indexes first; times are epoch milliseconds as in the logs.\n");
+}
+
+int main(int argc, char** argv){
+  if(argc < 2 || (strcmp(argv[1], "build") != 0 && strcmp(argv[1], "query") != 0)){
+    print_usage(argv[0]);
+    return 1;
+  }
+  bool build = strcmp(argv[1], "build") == 0;
+
+  struct IndexQuery query = { LLONG_MIN, LLONG_MAX, NULL, NULL };
+  int first_file = argc;
+  for(int i = 2; i < argc; i++){
+    bool has_value = i + 1 < argc;
+    if(!build && has_value && strcmp(argv[i], "--from") == 0 && parse_time(argv[i + 1], &query.from)){
+      i++;
+    }else if(!build && has_value && strcmp(argv[i], "--to") == 0 && parse_time(argv[i + 1], &query.to)){
+      i++;
+    }else if(!build && has_value && strcmp(argv[i], "--room") == 0){
+      query.room = argv[++i];
+    }else if(!build && has_value && strcmp(argv[i], "--action") == 0){
+      query.action = argv[++i];
+    }else if(argv[i][0] == '-'){
+      print_usage(argv[0]);
+      return 1;
+    }else{
+      first_file = i;
+      break;
+    }
+  }
+
+  glob_t found;
+  memset(&found, 0, sizeof(found));
+  char** files = argv + first_file;
+  int file_count = argc - first_file;
+  if(file_count == 0){
+    if(glob("log_*.csv", 0, NULL, &found) != 0){
+      fprintf(stderr, "No log_*.csv files here\n");
+      return 1;
+    }
+    files = found.gl_pathv;
+    file_count = (int)found.gl_pathc;
+  }
+
+  bool ok = true;
+  if(build){
+    for(int i = 0; i < file_count; i++){
+      struct LogIndex index;
+      ok = index_refresh(&index, files[i], true) && ok;
+      index_free(&index);
+    }
+    globfree(&found);
+    return ok ? 0 : 1;
+  }
+
+  struct IndexResult* results = calloc((size_t)file_count, sizeof(struct IndexResult));
+  struct TimelineHeap heap;
+  if(results == NULL || !timeline_init(&heap, file_count)){
+    fprintf(stderr, "Out of memory for %d files\n", file_count);
+    return 1;
+  }
+
+  long long start = now_ns();
+  size_t examined = 0;
+  size_t total_lines = 0;
+  for(int i = 0; i < file_count; i++){
+    struct LogIndex index;
+    if(!index_refresh(&index, files[i], false)){
+      ok = false;
+      continue;
+    }
+    total_lines += index.lines;
+    if(!map_log(files[i], &results[i].data, &results[i].size)){
+      ok = false;
+    }else if(results[i].data != NULL && !query_file(&index, &results[i], &query, &examined)){
+      fprintf(stderr, "%s: out of memory\n", files[i]);
+      ok = false;
+    }
+    index_free(&index);
+    if(results[i].count > 0){
+      timeline_push(&heap, results[i].timestamps[0], i);
+    }
+  }
+
+  //every file's matches are in its own order; merge them into one timeline
+  size_t matches = 0;
+  for(int source = timeline_next(&heap); source >= 0; source = timeline_next(&heap)){
+    struct IndexResult* result = &results[source];
+    const char* line = result->data + result->offsets[result->next++];
+    const char* newline = memchr(line, '\n', (size_t)(result->data + result->size - line));
+    size_t length = newline != NULL ? (size_t)(newline - line) : (size_t)(result->data + result->size - line);
+    fwrite(line, 1, length, stdout);
+    fputc('\n', stdout);
+    matches++;
+    bool more = result->next < result->count;
+    timeline_advance(&heap, more, more ? result->timestamps[result->next] : 0);
+  }
+  fflush(stdout);
+
+  fprintf(stderr, "%zu matches from %d files: %zu of %zu lines examined in %.1f ms\n",
+          matches, file_count, examined, total_lines, (now_ns() - start) / 1e6);
+
+  for(int i = 0; i < file_count; i++){
+    if(results[i].data != NULL) munmap((void*)results[i].data, results[i].size);
+    free(results[i].offsets);
+    free(results[i].timestamps);
+  }
+  timeline_free(&heap);
+  free(results);
+  globfree(&found);
+  return ok ? 0 : 1;
+}
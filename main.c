@@ -4,37 +4,14 @@
 #include "defs.h"
 #include "helpers.h"
 
-int main() {
-
-    /*
-    1. Initialize a House structure.
-    2. Populate the House with rooms using the provided helper function.
-    3. Initialize all of the ghost data and hunters.
-    4. Create threads for the ghost and each hunter.
-    5. Wait for all threads to complete.
-    6. Print final results to the console:
-         - Type of ghost encountered.
-         - The reason that each hunter exited
-         - The evidence collected by each hunter and which ghost is represented by that evidence.
-    7. Clean up all dynamically allocated resources and call sem_destroy() on all semaphores.
-    */
-
-  printf("=== Ghost Hunt Simulator ===\n\n");
-
-  //Initialize House structure
-  struct House house;
-  house_init(&house);
-
-  //Populate the house with rooms
-  house_populate_rooms(&house);
-  printf("House initialized with %d rooms\n", house.room_count);
-
-  //Initialize the ghost and hunters
-  ghost_init(&house.ghost, &house);
-  printf("Ghost Initialized: %s in %s\n\n",
-	 ghost_to_string(house.ghost.type),
-	 house.ghost.current_room->name);
-
+/*
+   Function: read_roster_interactive
+   Purpose:  Prompts for hunter names and IDs on stdin until "done" or EOF.
+   Params:
+   Input/Output: struct Roster* roster - the roster to append to
+   Return: void
+*/
+static void read_roster_interactive(struct Roster* roster){
   printf("Enter hunter information (type 'done' for the name when finished):\n");
 
   char name[MAX_HUNTER_NAME];
@@ -43,75 +20,57 @@ int main() {
   while(true){
     //Get hunter name
     printf("Hunter name: ");
-    if (scanf("%s", name) != 1) {
+    if (scanf("%63s", name) != 1) {
       break;
     }
-        
+
     //Check if user wants to stop
     if (strcmp(name, "done") == 0) {
       break;
     }
-        
+
     //Get hunter ID
     printf("Hunter ID: ");
     if (scanf("%d", &id) != 1) {
       break;
     }
-        
-    //Add hunter to house
-    house_add_hunter(&house, name, id);
-    printf("Added hunter: %s (ID: %d)\n\n", name, id);
-  }  
-
-  printf("\n=== Starting Simulation ===\n");
-  printf("Hunters: %d\n", house.hunter_count);
-  printf("Ghost: %s\n\n", ghost_to_string(house.ghost.type));
 
-  //Create thread array for hunters
-  pthread_t ghost_thread_id;
-  pthread_t* hunter_threads = malloc(house.hunter_count * sizeof(pthread_t));
-
-  //Create ghost thread
-  pthread_create(&ghost_thread_id, NULL, ghost_thread, &house.ghost);
-
-  //Create one thread for each hunter
-  for (int i = 0; i < house.hunter_count; i++) {
-    pthread_create(&hunter_threads[i], NULL, hunter_thread, &house.hunters[i]);
-  }
-
-  //wait for all threads to complete
-  //wait for ghost thread
-  pthread_join(ghost_thread_id, NULL);
-
-  //wait for all hunter threads
-  for (int i = 0; i < house.hunter_count; i++) {
-    pthread_join(hunter_threads[i], NULL);
+    //Add hunter to the roster
+    roster_add(roster, name, id);
+    printf("Added hunter: %s (ID: %d)\n\n", name, id);
   }
+}
 
-  //Free the thread array
-  free(hunter_threads);
-  
+/*
+   Function: print_results
+   Purpose:  Prints why each hunter left, the collected evidence and what
+   ghost that evidence points to.
+   Params:
+   Input: struct House* house - a house whose threads have all finished
+   Return: void
+*/
+static void print_results(struct House* house){
   //Display results
   printf("\n=== Simulation Complete ===\n\n");
-    
+
   // Display why each hunter left
   printf("Hunter Results:\n");
-  for (int i = 0; i < house.hunter_count; i++) {
-    struct Hunter* hunter = &house.hunters[i];
-    printf("  %s (ID: %d): %s\n", 
-	   hunter->name, 
-	   hunter->id, 
+  for (int i = 0; i < house->hunter_count; i++) {
+    struct Hunter* hunter = &house->hunters[i];
+    printf("  %s (ID: %d): %s\n",
+	   hunter->name,
+	   hunter->id,
 	   exit_reason_to_string(hunter->exit_reason));
   }
-    
+
   //Display evidence collected
   printf("\nEvidence Collected: ");
   const enum EvidenceType* all_evidence = NULL;
   int count = get_all_evidence_types(&all_evidence);
   bool found_any = false;
-    
+
   for (int i = 0; i < count; i++) {
-    if (evidence_has(house.caseFile.collected, all_evidence[i])) {
+    if (evidence_has(house->caseFile.collected, all_evidence[i])) {
       if (found_any) printf(", ");
       printf("%s", evidence_to_string(all_evidence[i]));
       found_any = true;
@@ -119,19 +78,19 @@ int main() {
   }
   if (!found_any) printf("None");
   printf("\n");
-    
+
   //Display ghost type
-  printf("\nActual Ghost: %s\n", ghost_to_string(house.ghost.type));
-    
+  printf("\nActual Ghost: %s\n", ghost_to_string(house->ghost.type));
+
   //What does the evidence suggest?
   printf("Evidence Suggests: ");
-  if (evidence_is_valid_ghost(house.caseFile.collected)) {
+  if (evidence_is_valid_ghost(house->caseFile.collected)) {
     //Find matching ghost
     const enum GhostType* ghost_types = NULL;
     int ghost_count = get_all_ghost_types(&ghost_types);
-        
+
     for (int i = 0; i < ghost_count; i++) {
-      if (house.caseFile.collected == (EvidenceByte)ghost_types[i]) {
+      if (house->caseFile.collected == (EvidenceByte)ghost_types[i]) {
 	printf("%s\n", ghost_to_string(ghost_types[i]));
 	break;
       }
@@ -139,12 +98,259 @@ int main() {
   } else {
     printf("Inconclusive (not enough or invalid evidence)\n");
   }
-    
-  //Cleanup
-  printf("\nCleaning up...\n");
+}
+
+/*
+   Function: solve_exact
+   Purpose:  Builds the configured layout and prints the exact outcome
+   probabilities of the reduced Markov model instead of simulating.
+   Params:
+   Input: const struct SimConfig* config - layout and state cap
+   Input: int hunters - team size: the roster plus any generated hunters, 1 if none
+   Return: int - exit status for main
+*/
+static int solve_exact(const struct SimConfig* config, int hunters){
+  struct House house;
+  house_init(&house);
+  if (!house_populate_layout(&house, config->layout)) {
+    fprintf(stderr, "Unknown layout '%s'\n", config->layout);
+    house_cleanup(&house);
+    return 1;
+  }
+
+  //the model never enforces the room limit, so it must not bind
+  if (config->occupancy < hunters) {
+    fprintf(stderr, "--exact only models the default --occupancy; drop it to solve\n");
+    house_cleanup(&house);
+    return 1;
+  }
+
+  //the model has no breadcrumbs; say so rather than answer for another mode
+  if (config->return_mode != RETURN_SHORTEST) {
+    fprintf(stderr, "Note: the exact model returns hunters by the shortest path, as with --return shortest\n");
+  }
+
+  struct MarkovResult result;
+  bool ok = markov_solve(&house, hunters, (size_t)config->exact_states, &result);
   house_cleanup(&house);
-    
-  printf("Game ended successfully!\n");  
- 
+
+  if (!ok) {
+    if (result.capped) {
+      fprintf(stderr, "State space exceeds %ld states; raise --exact or use a smaller layout\n",
+              config->exact_states);
+    }
+    return 1;
+  }
+
+  printf("=== Exact Solution (%s, %d hunter%s) ===\n", config->layout, hunters, hunters == 1 ? "" : "s");
+  printf("States: %zu, transitions: %zu, sweeps: %d\n", result.states, result.transitions, result.sweeps);
+  printf("P(solved):         %.9f\n", result.solved);
+  printf("Hunter exits:      %.9f evidence, %.9f bored, %.9f afraid\n",
+         result.evidence, result.bored, result.afraid);
+  printf("Expected rounds:   %.3f\n", result.rounds);
+  printf("Identical for every ghost type: the model is symmetric in the evidence types.\n");
+  return 0;
+}
+
+int main(int argc, char** argv) {
+
+    /*
+    1. Initialize a House structure.
+    2. Populate the House with rooms using the provided helper function.
+    3. Initialize all of the ghost data and hunters.
+    4. Create threads for the ghost and each hunter.
+    5. Wait for all threads to complete.
+    6. Print final results to the console:
+         - Type of ghost encountered.
+         - The reason that each hunter exited
+         - The evidence collected by each hunter and which ghost is represented by that evidence.
+    7. Clean up all dynamically allocated resources and call sem_destroy() on all semaphores.
+    */
+
+  //Read options; with no roster or hunter count we prompt like before
+  struct SimConfig config;
+  config_init(&config);
+  if (!config_parse_args(&config, argc, argv)) {
+    config_print_usage(argv[0]);
+    return 1;
+  }
+  log_set_mode(config.log_mode);
+  log_set_rotation((unsigned long long)config.log_segment_bytes, (unsigned)config.log_keep_segments,
+                   (unsigned long long)config.log_budget_bytes);
+  log_set_console(config.console);
+  if (config.trace_path[0] != '\0') {
+    trace_enable(config.trace_path);
+  }
+
+  struct Roster roster;
+  roster_init(&roster);
+  bool roster_ok = true;
+  if (config.roster_path[0] != '\0') {
+    roster_ok = roster_load_file(&roster, config.roster_path);
+  }
+  if (roster_ok && config.hunter_count > 0) {
+    roster_ok = roster_generate(&roster, config.hunter_count);
+  }
+  if (!roster_ok) {
+    roster_cleanup(&roster);
+    return 1;
+  }
+
+  //analytic mode: no threads, just the reduced model for this team on this layout
+  if (config.exact_states > 0) {
+    int status = solve_exact(&config, roster.count > 0 ? roster.count : 1);
+    roster_cleanup(&roster);
+    return status;
+  }
+  //a resumed hunt brings its own hunters
+  bool resuming = config.resume_path[0] != '\0';
+  bool interactive = (config.roster_path[0] == '\0' && config.hunter_count == 0 && !resuming);
+
+  //events shows everything; summary keeps the final numbers (and a single
+  //run's results); silent prints nothing but errors and prompts
+  bool chatter = config.console == CONSOLE_EVENTS;
+  bool per_run = chatter || (config.console == CONSOLE_SUMMARY && config.runs == 1);
+  bool totals_shown = config.console != CONSOLE_SILENT;
+
+  if (chatter) {
+    printf("=== Ghost Hunt Simulator ===\n\n");
+  }
+
+  //live counters for external readers; a missing /dev/shm is not fatal
+  bool parallel = config.jobs > 1 && !interactive && config.runs > 1;
+  if (config.metrics_name[0] != '\0' &&
+      !metrics_open(config.metrics_name, config.runs, parallel ? config.jobs : 1)) {
+    fprintf(stderr, "Live metrics disabled\n");
+  }
+
+  //group the usable CPUs before any simulation thread exists
+  int domains = affinity_setup(config.pin_mode, config.cpus);
+  if (domains == 0) {
+    metrics_close();
+    roster_cleanup(&roster);
+    return 1;
+  }
+  if (chatter && config.pin_mode != PIN_OFF) {
+    printf("Pinning threads within %d CPU domain%s\n", domains, domains == 1 ? "" : "s");
+  }
+
+  struct SimStats totals;
+  struct Aggregate summary;
+  stats_init(&totals);
+  aggregate_init(&summary);
+
+  //parallel batches only print the merged summary; their hunts would interleave
+  if (parallel) {
+    if (chatter) {
+      printf("Running %d hunts on %d workers\n", config.runs, config.jobs);
+    }
+    bool ok = simulation_run_batch(&config, &roster, &summary, &totals);
+    if (totals_shown) {
+      stats_print(&totals, config.stats_format, "all runs");
+      aggregate_print(&summary);
+    }
+    if (config.trace_path[0] != '\0' && trace_write() && totals_shown) {
+      printf("Trace written to %s\n", config.trace_path);
+    }
+    metrics_close();
+    roster_cleanup(&roster);
+    return ok ? 0 : 1;
+  }
+
+  //sequential hunts are all driven from this thread
+  affinity_bind_worker(0);
+
+  for (int run = 0; run < config.runs; run++) {
+    if (config.runs > 1 && chatter) {
+      printf("=== Run %d of %d ===\n", run + 1, config.runs);
+    }
+
+    //Initialize the house, populate the rooms, place the ghost and add hunters
+    //(the first interactive run adds its hunters after the prompts below)
+    struct Roster empty;
+    roster_init(&empty);
+    bool prompt = interactive && run == 0;
+
+    struct House house;
+    bool ready = resuming ? simulation_resume(&house, &config)
+                          : simulation_setup(&house, &config, prompt ? &empty : &roster, run);
+    if (!ready) {
+      house_cleanup(&house);
+      metrics_close();
+      roster_cleanup(&roster);
+      return 1;
+    }
+    if (chatter && resuming) {
+      printf("Resumed %s at round %lu\n", config.resume_path, house.round);
+    }
+    if (chatter) {
+      printf("House initialized with %d rooms\n", house.room_count);
+      printf("Ghost Initialized: %s in %s\n\n",
+	     ghost_to_string(house.ghost.type),
+	     house.ghost.current_room->name);
+    }
+
+    if (prompt) {
+      read_roster_interactive(&roster);
+      for (int i = 0; i < roster.count; i++) {
+        house_add_hunter(&house, roster.entries[i].name, roster.entries[i].id);
+      }
+    }
+
+    if (chatter) {
+      printf("\n=== Starting Simulation ===\n");
+      printf("Hunters: %d\n", house.hunter_count);
+      printf("Ghost: %s\n\n", ghost_to_string(house.ghost.type));
+    }
+
+    //Run the ghost and every hunter in their own threads until they all exit
+    double start = simulation_clock_us();
+    simulation_run(&house);
+    aggregate_add_run(&summary, &house, simulation_clock_us() - start);
+
+    if (config.checkpoint_path[0] != '\0' && house.round < (unsigned long)config.checkpoint_round) {
+      fprintf(stderr, "Hunt ended after %lu rounds; no checkpoint written\n", house.round);
+    }
+
+    if (per_run) {
+      print_results(&house);
+    }
+
+    //merge every thread's counters now that they have all been joined
+    struct SimStats run_stats;
+    char label[32];
+    stats_init(&run_stats);
+    stats_collect(&run_stats, &house);
+    stats_merge(&totals, &run_stats);
+    metrics_run_done(0, house.caseFile.solved, run_stats.hunter.iterations + run_stats.ghost.iterations);
+    snprintf(label, sizeof(label), "run %d", run + 1);
+    if (per_run) {
+      stats_print(&run_stats, config.stats_format, label);
+    }
+
+    //Cleanup
+    if (chatter) {
+      printf("\nCleaning up...\n");
+    }
+    house_cleanup(&house);
+  }
+
+  if (config.runs > 1 && totals_shown) {
+    stats_print(&totals, config.stats_format, "all runs");
+    aggregate_print(&summary);
+  }
+
+  //every traced thread has been joined, so the buffers can be written
+  if (config.trace_path[0] != '\0' && trace_write() && totals_shown) {
+    printf("Trace written to %s\n", config.trace_path);
+  }
+
+  metrics_close();
+  roster_cleanup(&roster);
+
+  if (chatter) {
+    printf("Game ended successfully!\n");
+  }
+
   return 0;
 }
@@ -0,0 +1,770 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+  Exact solver for a reduced model of the hunt. Instead of sampling hunts it
+  enumerates every reachable state of the model, builds the sparse transition
+  matrix and solves for the absorption probabilities with Gauss-Seidel.
+
+  The model follows the thread loops step for step, with two simplifications
+  that keep the state finite and small:
+   - Rounds are synchronous: each round the ghost takes one step, then each
+     hunter in roster order. The threaded simulator interleaves freely.
+   - A hunter returning to the van takes the shortest path (the rooms'
+     van_next_hop, as with --return shortest) instead of its breadcrumbs.
+  Room occupancy never matters because at most MARKOV_MAX_HUNTERS hunters
+  take part. Only the ghost's three evidence types can ever be in a room or
+  the case file, and every device outside them behaves the same, so states
+  store evidence as 3 bits and the device as one of 4 classes. That symmetry
+  also makes the answer identical for every ghost type.
+
+  A state packs into 64 bits: ghost room, boredom and exit flag; 3 evidence
+  bits per room; the case file bits and solved flag; per hunter room, fear,
+  boredom, device class, return flag and exit flag. A state in which every
+  hunter has left is absorbing and is not stored.
+*/
+
+#define MARKOV_DEVICE_OTHER 3        //any device the ghost cannot trigger
+#define MARKOV_MAX_BRANCHES 16384    //successors of one state before merging
+#define MARKOV_TERMINAL UINT64_MAX   //key of the absorbing "everyone left" state
+#define MARKOV_TOLERANCE 1e-13
+#define MARKOV_MAX_SWEEPS 1000000
+
+//Values accumulated along transitions; x(s) = r(s) + sum p(s,s') x(s')
+enum MarkovValue {
+  MV_SOLVED = 0,
+  MV_EVIDENCE,
+  MV_BORED,
+  MV_AFRAID,
+  MV_ROUNDS,
+  MV_COUNT
+};
+
+struct MarkovHunter {
+  int room;
+  int fear;
+  int boredom;
+  int device;      //0-2 index into the ghost's evidence, MARKOV_DEVICE_OTHER otherwise
+  bool returning;
+  bool gone;
+};
+
+//Unpacked model state
+struct MarkovState {
+  int ghost_room;
+  int ghost_boredom;
+  bool ghost_gone;
+  unsigned char evidence[MARKOV_MAX_ROOMS]; //3 bits per room
+  unsigned char collected;                  //3 bits
+  bool solved;
+  struct MarkovHunter hunters[MARKOV_MAX_HUNTERS];
+};
+
+struct MarkovBranch {
+  struct MarkovState state;
+  double p;
+  double reward[MV_COUNT];
+  uint64_t key;
+};
+
+struct MarkovBranchList {
+  struct MarkovBranch* items;
+  int count;
+};
+
+//The room graph as indices plus everything needed to expand a state
+struct MarkovModel {
+  int room_count;
+  int hunter_count;
+  int neighbours[MARKOV_MAX_ROOMS][MAX_CONNECTIONS];
+  int degree[MARKOV_MAX_ROOMS];
+  int next_hop[MARKOV_MAX_ROOMS];  //towards the van, -1 for the van itself
+  int room_bits;
+  struct MarkovBranchList lists[2];
+};
+
+/*
+   Function: markov_put
+   Purpose:  Appends a field to a packed key.
+   Params:
+    Input/Output: uint64_t* key - the key being built
+    Input/Output: int* shift - next free bit
+    Input: int value - field value
+    Input: int bits - field width
+   Return: void
+*/
+static void markov_put(uint64_t* key, int* shift, int value, int bits){
+  *key |= (uint64_t)value << *shift;
+  *shift += bits;
+}
+
+/*
+   Function: markov_take
+   Purpose:  Reads the next field of a packed key.
+   Params:
+    Input: uint64_t key - the packed key
+    Input/Output: int* shift - position of the field, advanced past it
+    Input: int bits - field width
+   Return: int - field value
+*/
+static int markov_take(uint64_t key, int* shift, int bits){
+  int value = (int)((key >> *shift) & ((1ULL << bits) - 1));
+  *shift += bits;
+  return value;
+}
+
+/*
+   Function: markov_encode
+   Purpose:  Packs a state into its 64-bit key. Fields of a gone ghost or
+   hunter are written as 0 so equivalent states share a key.
+   Params:
+    Input: const struct MarkovModel* model - the model (for field widths)
+    Input: const struct MarkovState* state - the state to pack
+   Return: uint64_t - the key
+*/
+static uint64_t markov_encode(const struct MarkovModel* model, const struct MarkovState* state){
+  uint64_t key = 0;
+  int shift = 0;
+  bool ghost = !state->ghost_gone;
+  markov_put(&key, &shift, state->ghost_gone, 1);
+  markov_put(&key, &shift, ghost ? state->ghost_room : 0, model->room_bits);
+  markov_put(&key, &shift, ghost ? state->ghost_boredom : 0, 4);
+  for(int r = 0; r < model->room_count; r++){
+    markov_put(&key, &shift, state->evidence[r], 3);
+  }
+  markov_put(&key, &shift, state->collected, 3);
+  markov_put(&key, &shift, state->solved, 1);
+  for(int h = 0; h < model->hunter_count; h++){
+    const struct MarkovHunter* hunter = &state->hunters[h];
+    bool here = !hunter->gone;
+    markov_put(&key, &shift, hunter->gone, 1);
+    markov_put(&key, &shift, here ? hunter->room : 0, model->room_bits);
+    markov_put(&key, &shift, here ? hunter->fear : 0, 4);
+    markov_put(&key, &shift, here ? hunter->boredom : 0, 4);
+    markov_put(&key, &shift, here ? hunter->device : 0, 2);
+    markov_put(&key, &shift, here ? hunter->returning : 0, 1);
+  }
+  return key;
+}
+
+/*
+   Function: markov_decode
+   Purpose:  Unpacks a key written by markov_encode.
+   Params:
+    Input: const struct MarkovModel* model - the model (for field widths)
+    Input: uint64_t key - the packed state
+    Output: struct MarkovState* state - the unpacked state
+   Return: void
+*/
+static void markov_decode(const struct MarkovModel* model, uint64_t key, struct MarkovState* state){
+  int shift = 0;
+  memset(state, 0, sizeof(*state));
+  state->ghost_gone = markov_take(key, &shift, 1);
+  state->ghost_room = markov_take(key, &shift, model->room_bits);
+  state->ghost_boredom = markov_take(key, &shift, 4);
+  for(int r = 0; r < model->room_count; r++){
+    state->evidence[r] = (unsigned char)markov_take(key, &shift, 3);
+  }
+  state->collected = (unsigned char)markov_take(key, &shift, 3);
+  state->solved = markov_take(key, &shift, 1);
+  for(int h = 0; h < model->hunter_count; h++){
+    struct MarkovHunter* hunter = &state->hunters[h];
+    hunter->gone = markov_take(key, &shift, 1);
+    hunter->room = markov_take(key, &shift, model->room_bits);
+    hunter->fear = markov_take(key, &shift, 4);
+    hunter->boredom = markov_take(key, &shift, 4);
+    hunter->device = markov_take(key, &shift, 2);
+    hunter->returning = markov_take(key, &shift, 1);
+  }
+}
+
+/*
+   Function: markov_emit
+   Purpose:  Appends a branch to a list.
+   Params:
+    Input/Output: struct MarkovBranchList* list - the list to append to
+    Input: const struct MarkovState* state - the branch state
+    Input: double p - probability of the branch
+    Input: const double* reward - values accumulated on the way
+   Return: void
+*/
+static void markov_emit(struct MarkovBranchList* list, const struct MarkovState* state,
+                        double p, const double* reward){
+  if(list->count >= MARKOV_MAX_BRANCHES){
+    return; //cannot happen with MARKOV_MAX_ROOMS and MARKOV_MAX_HUNTERS
+  }
+  struct MarkovBranch* branch = &list->items[list->count++];
+  branch->state = *state;
+  branch->p = p;
+  memcpy(branch->reward, reward, sizeof(branch->reward));
+}
+
+/*
+   Function: markov_hunter_leave
+   Purpose:  Removes a hunter from the model and credits its exit reason.
+   Params:
+    Input: const struct MarkovModel* model - the model
+    Input/Output: struct MarkovState* state - the state to update
+    Input: int h - hunter index
+    Input/Output: double* reward - values to credit
+    Input: enum MarkovValue reason - MV_EVIDENCE, MV_BORED or MV_AFRAID
+   Return: void
+*/
+static void markov_hunter_leave(const struct MarkovModel* model, struct MarkovState* state,
+                                int h, double* reward, enum MarkovValue reason){
+  memset(&state->hunters[h], 0, sizeof(state->hunters[h]));
+  state->hunters[h].gone = true;
+  reward[reason] += 1.0 / model->hunter_count;
+}
+
+/*
+   Function: markov_hunter_move
+   Purpose:  Last part of a hunter step: the move (hunter_choose_move).
+   Params:
+    Input: const struct MarkovModel* model - the model
+    Input: const struct MarkovState* state - state before the move
+    Input: int h - hunter index
+    Input: double p - probability so far
+    Input: const double* reward - values so far
+    Output: struct MarkovBranchList* out - receives the branches
+   Return: void
+*/
+static void markov_hunter_move(const struct MarkovModel* model, const struct MarkovState* state,
+                               int h, double p, const double* reward, struct MarkovBranchList* out){
+  struct MarkovState next = *state;
+  int room = state->hunters[h].room;
+
+  if(state->hunters[h].returning){
+    if(model->next_hop[room] >= 0){
+      next.hunters[h].room = model->next_hop[room];
+    }
+    markov_emit(out, &next, p, reward);
+    return;
+  }
+
+  if(model->degree[room] == 0){
+    markov_emit(out, &next, p, reward);
+    return;
+  }
+  for(int i = 0; i < model->degree[room]; i++){
+    next.hunters[h].room = model->neighbours[room][i];
+    markov_emit(out, &next, p / model->degree[room], reward);
+  }
+}
+
+/*
+   Function: markov_hunter_after_van
+   Purpose:  Middle of a hunter step: exit checks and evidence gathering
+   (hunter_check_exit_conditions, hunter_gather_evidence), then the move.
+   Params:
+    Input: const struct MarkovModel* model - the model
+    Input: const struct MarkovState* state - state after the van check
+    Input: int h - hunter index
+    Input: double p - probability so far
+    Input: const double* reward - values so far
+    Output: struct MarkovBranchList* out - receives the branches
+   Return: void
+*/
+static void markov_hunter_after_van(const struct MarkovModel* model, const struct MarkovState* state,
+                                    int h, double p, const double* reward, struct MarkovBranchList* out){
+  struct MarkovState next = *state;
+  struct MarkovHunter* hunter = &next.hunters[h];
+  double r[MV_COUNT];
+  memcpy(r, reward, sizeof(r));
+
+  if(hunter->boredom > ENTITY_BOREDOM_MAX){
+    markov_hunter_leave(model, &next, h, r, MV_BORED);
+    markov_emit(out, &next, p, r);
+    return;
+  }
+  if(hunter->fear > HUNTER_FEAR_MAX){
+    markov_hunter_leave(model, &next, h, r, MV_AFRAID);
+    markov_emit(out, &next, p, r);
+    return;
+  }
+
+  if(hunter->room == 0){
+    markov_hunter_move(model, &next, h, p, r, out);
+    return;
+  }
+
+  int bit = (hunter->device != MARKOV_DEVICE_OTHER) ? 1 << hunter->device : 0;
+  if(bit != 0 && (next.evidence[hunter->room] & bit)){
+    next.evidence[hunter->room] &= (unsigned char)~bit;
+    next.collected |= (unsigned char)bit;
+    hunter->returning = true;
+    markov_hunter_move(model, &next, h, p, r, out);
+    return;
+  }
+
+  //no matching evidence: 10% chance to head back anyway
+  if(hunter->returning){
+    markov_hunter_move(model, &next, h, p, r, out);
+    return;
+  }
+  markov_hunter_move(model, &next, h, p * 0.9, r, out);
+  hunter->returning = true;
+  markov_hunter_move(model, &next, h, p * 0.1, r, out);
+}
+
+/*
+   Function: markov_hunter_step
+   Purpose:  Expands one hunter's step (hunter_update_stats, hunter_check_van,
+   then markov_hunter_after_van).
+   Params:
+    Input: const struct MarkovModel* model - the model
+    Input: const struct MarkovBranch* in - the branch to expand
+    Input: int h - hunter index
+    Output: struct MarkovBranchList* out - receives the branches
+   Return: void
+*/
+static void markov_hunter_step(const struct MarkovModel* model, const struct MarkovBranch* in,
+                               int h, struct MarkovBranchList* out){
+  struct MarkovState next = in->state;
+  struct MarkovHunter* hunter = &next.hunters[h];
+  double r[MV_COUNT];
+  memcpy(r, in->reward, sizeof(r));
+
+  if(hunter->gone){
+    markov_emit(out, &next, in->p, r);
+    return;
+  }
+
+  if(!next.ghost_gone && next.ghost_room == hunter->room){
+    hunter->boredom = 0;
+    hunter->fear++;
+  }else{
+    hunter->boredom++;
+  }
+
+  if(hunter->room != 0){
+    markov_hunter_after_van(model, &next, h, in->p, r, out);
+    return;
+  }
+
+  hunter->returning = false;
+  if(next.collected == 0x7){
+    if(!next.solved){
+      next.solved = true;
+      r[MV_SOLVED] += 1.0;
+    }
+    markov_hunter_leave(model, &next, h, r, MV_EVIDENCE);
+    markov_emit(out, &next, in->p, r);
+    return;
+  }
+
+  //device swap: each of the ghost's three types with 1/7, anything else 4/7
+  const enum EvidenceType* evidence_types = NULL;
+  int device_count = get_all_evidence_types(&evidence_types);
+  for(int d = 0; d <= MARKOV_DEVICE_OTHER; d++){
+    hunter->device = d;
+    double share = (d == MARKOV_DEVICE_OTHER) ? (double)(device_count - 3) / device_count
+                                              : 1.0 / device_count;
+    markov_hunter_after_van(model, &next, h, in->p * share, r, out);
+  }
+}
+
+/*
+   Function: markov_ghost_step
+   Purpose:  Expands the ghost's step (ghost_update_stats, ghost_check_exit,
+   ghost_take_action).
+   Params:
+    Input: const struct MarkovModel* model - the model
+    Input: const struct MarkovState* state - the state at the start of the round
+    Input: const double* reward - values so far
+    Output: struct MarkovBranchList* out - receives the branches
+   Return: void
+*/
+static void markov_ghost_step(const struct MarkovModel* model, const struct MarkovState* state,
+                              const double* reward, struct MarkovBranchList* out){
+  struct MarkovState next = *state;
+  if(next.ghost_gone){
+    markov_emit(out, &next, 1.0, reward);
+    return;
+  }
+
+  bool hunters_here = false;
+  for(int h = 0; h < model->hunter_count; h++){
+    if(!next.hunters[h].gone && next.hunters[h].room == next.ghost_room){
+      hunters_here = true;
+    }
+  }
+  next.ghost_boredom = hunters_here ? 0 : next.ghost_boredom + 1;
+
+  if(next.ghost_boredom > ENTITY_BOREDOM_MAX){
+    next.ghost_gone = true;
+    next.ghost_room = 0;
+    next.ghost_boredom = 0;
+    markov_emit(out, &next, 1.0, reward);
+    return;
+  }
+
+  //idle
+  markov_emit(out, &next, 1.0 / 3, reward);
+
+  //haunt: one of the ghost's three evidence types
+  for(int e = 0; e < 3; e++){
+    struct MarkovState haunted = next;
+    haunted.evidence[next.ghost_room] |= (unsigned char)(1 << e);
+    markov_emit(out, &haunted, 1.0 / 9, reward);
+  }
+
+  //move, unless a hunter is in the room
+  int room = next.ghost_room;
+  if(hunters_here || model->degree[room] == 0){
+    markov_emit(out, &next, 1.0 / 3, reward);
+    return;
+  }
+  for(int i = 0; i < model->degree[room]; i++){
+    struct MarkovState moved = next;
+    moved.ghost_room = model->neighbours[room][i];
+    markov_emit(out, &moved, 1.0 / (3 * model->degree[room]), reward);
+  }
+}
+
+static int markov_branch_compare(const void* a, const void* b){
+  uint64_t ka = ((const struct MarkovBranch*)a)->key;
+  uint64_t kb = ((const struct MarkovBranch*)b)->key;
+  return (ka > kb) - (ka < kb);
+}
+
+/*
+   Function: markov_successors
+   Purpose:  Expands a full round from one state, then merges branches that
+   reach the same state. Rewards are stored probability-weighted.
+   Params:
+    Input/Output: struct MarkovModel* model - the model and its scratch lists
+    Input: uint64_t key - the state to expand
+   Return: struct MarkovBranchList* - merged successors sorted by key
+*/
+static struct MarkovBranchList* markov_successors(struct MarkovModel* model, uint64_t key){
+  struct MarkovState state;
+  double reward[MV_COUNT] = {0};
+  reward[MV_ROUNDS] = 1.0;
+  markov_decode(model, key, &state);
+
+  struct MarkovBranchList* in = &model->lists[0];
+  struct MarkovBranchList* out = &model->lists[1];
+  in->count = 0;
+  markov_ghost_step(model, &state, reward, in);
+
+  for(int h = 0; h < model->hunter_count; h++){
+    out->count = 0;
+    for(int i = 0; i < in->count; i++){
+      markov_hunter_step(model, &in->items[i], h, out);
+    }
+    struct MarkovBranchList* swap = in;
+    in = out;
+    out = swap;
+  }
+
+  for(int i = 0; i < in->count; i++){
+    struct MarkovBranch* branch = &in->items[i];
+    bool everyone_left = true;
+    for(int h = 0; h < model->hunter_count; h++){
+      everyone_left = everyone_left && branch->state.hunters[h].gone;
+    }
+    branch->key = everyone_left ? MARKOV_TERMINAL : markov_encode(model, &branch->state);
+    for(int v = 0; v < MV_COUNT; v++){
+      branch->reward[v] *= branch->p;
+    }
+  }
+
+  qsort(in->items, (size_t)in->count, sizeof(struct MarkovBranch), markov_branch_compare);
+  int merged = 0;
+  for(int i = 0; i < in->count; i++){
+    if(merged > 0 && in->items[merged - 1].key == in->items[i].key){
+      struct MarkovBranch* into = &in->items[merged - 1];
+      into->p += in->items[i].p;
+      for(int v = 0; v < MV_COUNT; v++){
+        into->reward[v] += in->items[i].reward[v];
+      }
+    }else{
+      in->items[merged++] = in->items[i];
+    }
+  }
+  in->count = merged;
+  return in;
+}
+
+//Open-addressing map from state key to state index
+struct MarkovIndex {
+  uint64_t* keys;     //key + 1, 0 marks an empty slot
+  uint32_t* values;
+  size_t mask;
+};
+
+static uint64_t markov_hash(uint64_t key){
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key;
+}
+
+/*
+   Function: markov_index_find
+   Purpose:  Looks up a key, inserting it with the given index if missing.
+   Params:
+    Input/Output: struct MarkovIndex* index - the map
+    Input: uint64_t key - the state key
+    Input: uint32_t next - index to give a new key
+    Output: bool* inserted - true if the key was new
+   Return: uint32_t - the key's index
+*/
+static uint32_t markov_index_find(struct MarkovIndex* index, uint64_t key, uint32_t next, bool* inserted){
+  size_t slot = markov_hash(key) & index->mask;
+  while(index->keys[slot] != 0){
+    if(index->keys[slot] == key + 1){
+      *inserted = false;
+      return index->values[slot];
+    }
+    slot = (slot + 1) & index->mask;
+  }
+  index->keys[slot] = key + 1;
+  index->values[slot] = next;
+  *inserted = true;
+  return next;
+}
+
+/*
+   Function: markov_model_init
+   Purpose:  Converts the house's room graph and routes to indices.
+   Params:
+    Output: struct MarkovModel* model - the model to fill
+    Input: const struct House* house - a populated house (van is room 0)
+    Input: int hunters - number of hunters
+   Return: bool - false if the house or team is too large for the model
+*/
+static bool markov_model_init(struct MarkovModel* model, const struct House* house, int hunters){
+  memset(model, 0, sizeof(*model));
+  if(house->room_count > MARKOV_MAX_ROOMS || hunters < 1 || hunters > MARKOV_MAX_HUNTERS){
+    return false;
+  }
+  model->room_count = house->room_count;
+  model->hunter_count = hunters;
+  model->room_bits = 1;
+  while((1 << model->room_bits) < model->room_count){
+    model->room_bits++;
+  }
+
+  int bits = 1 + model->room_bits + 4 + 3 * model->room_count + 4 + hunters * (model->room_bits + 12);
+  if(bits > 63){
+    return false;
+  }
+
+  for(int r = 0; r < house->room_count; r++){
+    const struct Room* room = &house->rooms[r];
+    model->degree[r] = room->connection_count;
+    for(int i = 0; i < room->connection_count; i++){
+      model->neighbours[r][i] = (int)(room->connections[i] - house->rooms);
+    }
+  }
+
+  for(int r = 0; r < house->room_count; r++){
+    const struct Room* hop = house->rooms[r].van_next_hop;
+    model->next_hop[r] = (hop != NULL) ? (int)(hop - house->rooms) : -1;
+  }
+
+  for(int i = 0; i < 2; i++){
+    model->lists[i].items = malloc(MARKOV_MAX_BRANCHES * sizeof(struct MarkovBranch));
+    if(model->lists[i].items == NULL){
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+   Function: markov_solve
+   Purpose:  Solves the reduced hunt model exactly on a small house: explores
+   every reachable state (up to max_states), stores the transitions in CSR
+   form and runs Gauss-Seidel sweeps until the values settle.
+   Params:
+    Input: const struct House* house - populated house with at most MARKOV_MAX_ROOMS rooms
+    Input: int hunters - team size, 1 to MARKOV_MAX_HUNTERS
+    Input: size_t max_states - give up beyond this many states
+    Output: struct MarkovResult* result - probabilities, expected rounds and sizes
+   Return: bool - false if the house is too large, the state cap was hit or memory ran out
+*/
+bool markov_solve(const struct House* house, int hunters, size_t max_states, struct MarkovResult* result){
+  memset(result, 0, sizeof(*result));
+
+  struct MarkovModel model;
+  if(!markov_model_init(&model, house, hunters)){
+    free(model.lists[0].items);
+    free(model.lists[1].items);
+    fprintf(stderr, "Exact solver supports up to %d rooms and %d hunters\n",
+            MARKOV_MAX_ROOMS, MARKOV_MAX_HUNTERS);
+    return false;
+  }
+
+  struct MarkovIndex index;
+  size_t slots = 1;
+  while(slots < max_states * 2){
+    slots <<= 1;
+  }
+  index.mask = slots - 1;
+  index.keys = calloc(slots, sizeof(uint64_t));
+  index.values = malloc(slots * sizeof(uint32_t));
+
+  uint64_t* states = malloc(max_states * sizeof(uint64_t));
+  size_t* row = malloc((max_states + 1) * sizeof(size_t));
+  double* reward = calloc(max_states * MV_COUNT, sizeof(double));
+  uint32_t* edge_to = NULL;
+  double* edge_p = NULL;
+  double* start = NULL;
+  double* value = NULL;
+  size_t edge_count = 0, edge_capacity = 0;
+  size_t state_count = 0;
+  bool ok = index.keys != NULL && index.values != NULL && states != NULL && row != NULL && reward != NULL;
+
+  //starting states: ghost in any room but the van, everyone in the van with a random device
+  const enum EvidenceType* evidence_types = NULL;
+  int device_count = get_all_evidence_types(&evidence_types);
+  int device_combos = 1;
+  for(int h = 0; h < hunters; h++){
+    device_combos *= 4;
+  }
+  int start_count = (house->room_count - 1) * device_combos;
+  uint32_t* start_index = malloc((size_t)start_count * sizeof(uint32_t));
+  start = malloc((size_t)start_count * sizeof(double));
+  ok = ok && start_index != NULL && start != NULL;
+
+  for(int s = 0; ok && s < start_count; s++){
+    struct MarkovState initial;
+    memset(&initial, 0, sizeof(initial));
+    initial.ghost_room = 1 + s / device_combos;
+    double p = 1.0 / (house->room_count - 1);
+    int combo = s % device_combos;
+    for(int h = 0; h < hunters; h++){
+      initial.hunters[h].device = combo % 4;
+      p *= (combo % 4 == MARKOV_DEVICE_OTHER) ? (double)(device_count - 3) / device_count
+                                              : 1.0 / device_count;
+      combo /= 4;
+    }
+    bool inserted;
+    uint64_t key = markov_encode(&model, &initial);
+    start_index[s] = markov_index_find(&index, key, (uint32_t)state_count, &inserted);
+    start[s] = p;
+    if(inserted){
+      states[state_count++] = key;
+    }
+  }
+
+  //explore breadth first; states are expanded in discovery order, so the
+  //transitions come out row by row
+  for(size_t i = 0; ok && i < state_count; i++){
+    struct MarkovBranchList* next = markov_successors(&model, states[i]);
+    row[i] = edge_count;
+    if(edge_count + (size_t)next->count > edge_capacity){
+      size_t capacity = edge_capacity ? edge_capacity * 2 : 1 << 20;
+      while(capacity < edge_count + (size_t)next->count){
+        capacity *= 2;
+      }
+      uint32_t* to = realloc(edge_to, capacity * sizeof(uint32_t));
+      if(to != NULL){
+        edge_to = to;
+      }
+      double* p = realloc(edge_p, capacity * sizeof(double));
+      if(p != NULL){
+        edge_p = p;
+      }
+      if(to == NULL || p == NULL){
+        ok = false;
+        break;
+      }
+      edge_capacity = capacity;
+    }
+
+    for(int b = 0; b < next->count; b++){
+      const struct MarkovBranch* branch = &next->items[b];
+      for(int v = 0; v < MV_COUNT; v++){
+        reward[i * MV_COUNT + v] += branch->reward[v];
+      }
+      if(branch->key == MARKOV_TERMINAL){
+        continue;
+      }
+      bool inserted;
+      uint32_t target = markov_index_find(&index, branch->key, (uint32_t)state_count, &inserted);
+      if(inserted){
+        if(state_count >= max_states){
+          ok = false;
+          result->capped = true;
+          break;
+        }
+        states[state_count++] = branch->key;
+      }
+      edge_to[edge_count] = target;
+      edge_p[edge_count] = branch->p;
+      edge_count++;
+    }
+  }
+  row[state_count] = edge_count;
+
+  //Gauss-Seidel, newest states first since values flow back from the exits
+  value = ok ? calloc(state_count * MV_COUNT, sizeof(double)) : NULL;
+  ok = ok && value != NULL;
+  int sweeps = 0;
+  while(ok && sweeps < MARKOV_MAX_SWEEPS){
+    double change = 0.0;
+    sweeps++;
+    for(size_t i = state_count; i-- > 0;){
+      double x[MV_COUNT];
+      memcpy(x, &reward[i * MV_COUNT], sizeof(x));
+      for(size_t e = row[i]; e < row[i + 1]; e++){
+        const double* target = &value[(size_t)edge_to[e] * MV_COUNT];
+        for(int v = 0; v < MV_COUNT; v++){
+          x[v] += edge_p[e] * target[v];
+        }
+      }
+      for(int v = 0; v < MV_COUNT; v++){
+        double delta = fabs(x[v] - value[i * MV_COUNT + v]);
+        if(delta > change){
+          change = delta;
+        }
+        value[i * MV_COUNT + v] = x[v];
+      }
+    }
+    if(change < MARKOV_TOLERANCE){
+      break;
+    }
+  }
+
+  if(ok){
+    double totals[MV_COUNT] = {0};
+    for(int s = 0; s < start_count; s++){
+      for(int v = 0; v < MV_COUNT; v++){
+        totals[v] += start[s] * value[(size_t)start_index[s] * MV_COUNT + v];
+      }
+    }
+    result->solved = totals[MV_SOLVED];
+    result->evidence = totals[MV_EVIDENCE];
+    result->bored = totals[MV_BORED];
+    result->afraid = totals[MV_AFRAID];
+    result->rounds = totals[MV_ROUNDS];
+    result->sweeps = sweeps;
+  }
+  result->states = state_count;
+  result->transitions = edge_count;
+
+  free(value);
+  free(start);
+  free(start_index);
+  free(edge_p);
+  free(edge_to);
+  free(reward);
+  free(row);
+  free(states);
+  free(index.values);
+  free(index.keys);
+  free(model.lists[0].items);
+  free(model.lists[1].items);
+  return ok;
+}
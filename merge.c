@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <glob.h>
+#include <sys/types.h>
+#include "defs.h"
+
+/*
+  ghost_merge: joins the per-entity log_<id>.csv files into one timeline
+  ordered by timestamp. The files are streamed, never loaded: each has a
+  fixed read buffer and one line in hand, and a TimelineHeap picks the
+  earliest line among them. Memory depends only on the number of files,
+  so gigabytes of logs merge in a few hundred kilobytes.
+
+  Lines with the same timestamp come out in the order of the files on the
+  command line (sorted names when globbing), and each file's own lines
+  keep their order, so the result is the same on every run.
+*/
+
+#define MERGE_READ_BUFFER (64 * 1024)
+#define MERGE_WRITE_BUFFER (1024 * 1024)
+
+//One input file and the line it currently offers
+struct MergeStream {
+  const char* path;
+  FILE* file;
+  char* line;
+  size_t line_capacity;
+  ssize_t length;
+  long long timestamp;
+  bool seen;               //a line has been read before
+};
+
+//Counts for the closing report
+struct MergeTotals {
+  unsigned long lines;
+  unsigned long malformed;
+  unsigned long late;      //lines earlier than their file's previous line
+  unsigned long long bytes;
+};
+
+static long long now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+   Function: stream_next
+   Purpose:  Reads a stream's next line that starts with a timestamp,
+   skipping (and counting) any that do not.
+   Params:
+    Input/Output: struct MergeStream* stream - the stream
+    Input/Output: struct MergeTotals* totals - malformed and late counts
+   Return: bool - false at the end of the file
+*/
+static bool stream_next(struct MergeStream* stream, struct MergeTotals* totals){
+  for(;;){
+    stream->length = getline(&stream->line, &stream->line_capacity, stream->file);
+    if(stream->length < 0){
+      return false;
+    }
+
+    long long timestamp = 0;
+    const char* c = stream->line;
+    while(*c >= '0' && *c <= '9'){
+      timestamp = timestamp * 10 + (*c - '0');
+      c++;
+    }
+    if(c == stream->line || *c != ','){
+      if(stream->length > 1 || stream->line[0] != '\n'){
+        totals->malformed++;
+      }
+      continue;
+    }
+
+    //still merged, but the output is only ordered if every input was
+    if(stream->seen && timestamp < stream->timestamp){
+      totals->late++;
+    }
+    stream->timestamp = timestamp;
+    stream->seen = true;
+    return true;
+  }
+}
+
+/*
+   Function: stream_open
+   Purpose:  Opens one input with its own read buffer.
+   Params:
+    Output: struct MergeStream* stream - the stream
+    Input: const char* path - the file
+   Return: bool - false if the file could not be opened
+*/
+static bool stream_open(struct MergeStream* stream, const char* path){
+  memset(stream, 0, sizeof(*stream));
+  stream->path = path;
+  stream->file = fopen(path, "r");
+  if(stream->file == NULL){
+    perror(path);
+    return false;
+  }
+  setvbuf(stream->file, NULL, _IOFBF, MERGE_READ_BUFFER);
+  stream->length = -1;
+  return true;
+}
+
+/*
+   Function: stream_close
+   Purpose:  Closes a stream and frees its line.
+   Params:
+    Input/Output: struct MergeStream* stream - the stream
+   Return: void
+*/
+static void stream_close(struct MergeStream* stream){
+  if(stream->file != NULL){
+    fclose(stream->file);
+  }
+  free(stream->line);
+  stream->file = NULL;
+  stream->line = NULL;
+}
+
+int main(int argc, char** argv){
+  const char* output_path = NULL;
+  int first_file = argc;
+
+  for(int i = 1; i < argc; i++){
+    if(strcmp(argv[i], "-o") == 0 && i + 1 < argc){
+      output_path = argv[++i];
+    }else if(argv[i][0] == '-'){
+      fprintf(stderr, "Usage: %s [-o FILE] [log_<id>.csv ...]\n", argv[0]);
+      fprintf(stderr, "With no files every log_*.csv in the current directory is merged.\n");
+      return 1;
+    }else{
+      first_file = i;
+      break;
+    }
+  }
+
+  glob_t found;
+  memset(&found, 0, sizeof(found));
+  char** files = argv + first_file;
+  int file_count = argc - first_file;
+  if(file_count == 0){
+    if(glob("log_*.csv", 0, NULL, &found) != 0){
+      fprintf(stderr, "No log_*.csv files here\n");
+      return 1;
+    }
+    files = found.gl_pathv;
+    file_count = (int)found.gl_pathc;
+  }
+
+  FILE* out = stdout;
+  if(output_path != NULL){
+    out = fopen(output_path, "w");
+    if(out == NULL){
+      perror(output_path);
+      globfree(&found);
+      return 1;
+    }
+  }
+  setvbuf(out, NULL, _IOFBF, MERGE_WRITE_BUFFER);
+
+  struct MergeStream* streams = calloc((size_t)file_count, sizeof(struct MergeStream));
+  struct TimelineHeap heap;
+  if(streams == NULL || !timeline_init(&heap, file_count)){
+    fprintf(stderr, "Out of memory for %d files\n", file_count);
+    return 1;
+  }
+
+  struct MergeTotals totals;
+  memset(&totals, 0, sizeof(totals));
+  long long start = now_ns();
+  bool ok = true;
+  for(int i = 0; i < file_count; i++){
+    if(!stream_open(&streams[i], files[i])){
+      ok = false;
+      continue;
+    }
+    if(stream_next(&streams[i], &totals)){
+      timeline_push(&heap, streams[i].timestamp, i);
+    }
+  }
+
+  //write the earliest line, then let its stream offer the next one
+  for(int source = timeline_next(&heap); source >= 0; source = timeline_next(&heap)){
+    struct MergeStream* stream = &streams[source];
+    fwrite(stream->line, 1, (size_t)stream->length, out);
+    if(stream->line[stream->length - 1] != '\n'){
+      fputc('\n', out);
+    }
+    totals.lines++;
+    totals.bytes += (unsigned long long)stream->length;
+    bool more = stream_next(stream, &totals);
+    timeline_advance(&heap, more, stream->timestamp);
+  }
+
+  if(fflush(out) != 0 || ferror(out)){
+    perror(output_path != NULL ? output_path : "stdout");
+    ok = false;
+  }
+  if(out != stdout){
+    fclose(out);
+  }
+  long long elapsed_ns = now_ns() - start;
+
+  double seconds = elapsed_ns / 1e9;
+  fprintf(stderr, "%d files, %lu lines (%lu malformed), %.1f MB merged in %.1f ms (%.0f MB/s)\n",
+          file_count, totals.lines, totals.malformed, totals.bytes / 1e6, elapsed_ns / 1e6,
+          seconds > 0 ? totals.bytes / seconds / 1e6 : 0.0);
+  if(totals.late > 0){
+    fprintf(stderr, "%lu lines were earlier than the line before them in their file; the output is not fully ordered\n",
+            totals.late);
+  }
+
+  for(int i = 0; i < file_count; i++){
+    stream_close(&streams[i]);
+  }
+  timeline_free(&heap);
+  free(streams);
+  globfree(&found);
+  return ok ? 0 : 1;
+}
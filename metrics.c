@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+  Live counters for external dashboards. The simulator maps a fixed-layout
+  MetricsRegion from /dev/shm and bumps its counters with relaxed atomic
+  adds; a reader (ghost_metrics) maps the same file read-only and computes
+  rates from successive samples. Nothing is locked and nobody waits: the
+  counters are independent, so a reader can at worst see one a moment
+  ahead of another.
+
+  Entity threads add their steps in batches of METRICS_STEP_BATCH and only
+  touch the lock counters when a lock was actually contended, so the
+  shared cache lines stay cold on the fast paths.
+*/
+
+static struct MetricsRegion* metrics = NULL;
+
+/*
+   Function: metrics_clock_ns
+   Purpose:  Reads the monotonic clock.
+   Return: long long - nanoseconds from an arbitrary origin
+*/
+static long long metrics_clock_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+   Function: metrics_open
+   Purpose:  Creates (or reuses) /dev/shm/<name>, sizes it to one
+   MetricsRegion, maps it and resets every counter. Call before any thread starts.
+   Params:
+    Input: const char* name - shared memory name, without the leading '/'
+    Input: int runs_target - runs this process will simulate
+    Input: int slots - worker slots in use (clamped to METRICS_SLOTS)
+   Return: bool - false if the region could not be created or mapped
+*/
+bool metrics_open(const char* name, int runs_target, int slots){
+  char path[MAX_PATH_LENGTH];
+  snprintf(path, sizeof(path), "/%s", name);
+
+  int fd = shm_open(path, O_CREAT | O_RDWR, 0644);
+  if(fd < 0){
+    perror(path);
+    return false;
+  }
+  if(ftruncate(fd, sizeof(struct MetricsRegion)) != 0){
+    perror(path);
+    close(fd);
+    return false;
+  }
+  void* region = mmap(NULL, sizeof(struct MetricsRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if(region == MAP_FAILED){
+    perror(path);
+    return false;
+  }
+
+  metrics = region;
+  memset(metrics, 0, sizeof(*metrics));
+  metrics->layout = METRICS_LAYOUT;
+  metrics->size = sizeof(struct MetricsRegion);
+  metrics->pid = (int)getpid();
+  metrics->slot_count = slots < METRICS_SLOTS ? slots : METRICS_SLOTS;
+  metrics->runs_target = (unsigned long)runs_target;
+  metrics->started_ns = metrics_clock_ns();
+  //the magic goes in last so a reader never trusts a half-initialized region
+  __atomic_store_n(&metrics->magic, METRICS_MAGIC, __ATOMIC_RELEASE);
+  return true;
+}
+
+/*
+   Function: metrics_close
+   Purpose:  Marks the region finished and unmaps it. The file stays in
+   /dev/shm so readers can still show the final numbers.
+   Return: void
+*/
+void metrics_close(void){
+  if(metrics == NULL){
+    return;
+  }
+  __atomic_store_n(&metrics->finished, 1, __ATOMIC_RELEASE);
+  munmap(metrics, sizeof(struct MetricsRegion));
+  metrics = NULL;
+}
+
+/*
+   Function: metrics_add_steps
+   Purpose:  Adds entity loop passes to the live step counter.
+   Params:
+    Input: unsigned long steps - passes since the last flush
+   Return: void
+*/
+void metrics_add_steps(unsigned long steps){
+  if(metrics == NULL || steps == 0){
+    return;
+  }
+  __atomic_add_fetch(&metrics->steps, steps, __ATOMIC_RELAXED);
+}
+
+/*
+   Function: metrics_run_done
+   Purpose:  Records a finished run for the whole process and for one worker slot.
+   Params:
+    Input: int slot - worker index (0 for sequential runs)
+    Input: bool solved - whether the case was solved
+    Input: unsigned long steps - entity loop passes in the run
+   Return: void
+*/
+void metrics_run_done(int slot, bool solved, unsigned long steps){
+  if(metrics == NULL){
+    return;
+  }
+  __atomic_add_fetch(&metrics->runs_completed, 1, __ATOMIC_RELAXED);
+  if(solved){
+    __atomic_add_fetch(&metrics->runs_solved, 1, __ATOMIC_RELAXED);
+  }
+  if(slot >= 0 && slot < METRICS_SLOTS){
+    __atomic_add_fetch(&metrics->slots[slot].runs_completed, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&metrics->slots[slot].steps, steps, __ATOMIC_RELAXED);
+  }
+}
+
+/*
+   Function: metrics_lock
+   Purpose:  sem_wait that counts contention: the uncontended path is one
+   sem_trywait; a failed try is counted and timed before blocking.
+   Params:
+    Input/Output: sem_t* sem - the semaphore to take
+   Return: void
+*/
+void metrics_lock(sem_t* sem){
+  if(sem_trywait(sem) == 0){
+    return;
+  }
+  if(metrics == NULL){
+    sem_wait(sem);
+    return;
+  }
+  long long start = metrics_clock_ns();
+  sem_wait(sem);
+  __atomic_add_fetch(&metrics->lock_contended, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&metrics->lock_wait_ns, (unsigned long)(metrics_clock_ns() - start), __ATOMIC_RELAXED);
+}
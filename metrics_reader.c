@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "defs.h"
+
+/*
+  ghost_metrics: attaches read-only to a simulator's /dev/shm metrics
+  region and prints rates from successive samples. It never writes to the
+  region and the simulator never knows it is there; start and stop it at
+  any time, even after the simulator has finished.
+*/
+
+struct Sample {
+  long long at_ns;
+  uint64_t runs;
+  uint64_t solved;
+  uint64_t steps;
+  uint64_t contended;
+  uint64_t wait_ns;
+};
+
+static long long now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+   Function: take_sample
+   Purpose:  Copies the global counters with relaxed atomic loads.
+   Params:
+    Input: const struct MetricsRegion* region - the mapped region
+    Output: struct Sample* sample - the copy
+   Return: void
+*/
+static void take_sample(const struct MetricsRegion* region, struct Sample* sample){
+  sample->at_ns = now_ns();
+  sample->runs = __atomic_load_n(&region->runs_completed, __ATOMIC_RELAXED);
+  sample->solved = __atomic_load_n(&region->runs_solved, __ATOMIC_RELAXED);
+  sample->steps = __atomic_load_n(&region->steps, __ATOMIC_RELAXED);
+  sample->contended = __atomic_load_n(&region->lock_contended, __ATOMIC_RELAXED);
+  sample->wait_ns = __atomic_load_n(&region->lock_wait_ns, __ATOMIC_RELAXED);
+}
+
+/*
+   Function: print_sample
+   Purpose:  Prints totals and the rates since the previous sample, then
+   one progress entry per worker slot.
+   Params:
+    Input: const struct MetricsRegion* region - the mapped region
+    Input: const struct Sample* prev - the previous sample
+    Input: const struct Sample* cur - the current sample
+   Return: void
+*/
+static void print_sample(const struct MetricsRegion* region, const struct Sample* prev, const struct Sample* cur){
+  double seconds = (cur->at_ns - prev->at_ns) / 1e9;
+  if(seconds <= 0){
+    seconds = 1e-9;
+  }
+  uint64_t target = region->runs_target;
+
+  printf("runs %llu/%llu (%.1f%%)  %.1f runs/s  %.0f steps/s  solved %.1f%%  locks %.0f contended/s %.3f ms waited/s%s\n",
+	 (unsigned long long)cur->runs, (unsigned long long)target,
+	 target ? 100.0 * (double)cur->runs / (double)target : 0.0,
+	 (double)(cur->runs - prev->runs) / seconds,
+	 (double)(cur->steps - prev->steps) / seconds,
+	 cur->runs ? 100.0 * (double)cur->solved / (double)cur->runs : 0.0,
+	 (double)(cur->contended - prev->contended) / seconds,
+	 (double)(cur->wait_ns - prev->wait_ns) / 1e6 / seconds,
+	 __atomic_load_n(&region->finished, __ATOMIC_RELAXED) ? "  [finished]" : "");
+
+  int slots = region->slot_count;
+  if(slots > 1){
+    printf("  workers:");
+    for(int i = 0; i < slots && i < METRICS_SLOTS; i++){
+      printf(" %d:%llu", i, (unsigned long long)__atomic_load_n(&region->slots[i].runs_completed, __ATOMIC_RELAXED));
+    }
+    printf("\n");
+  }
+  fflush(stdout);
+}
+
+int main(int argc, char** argv){
+  const char* name = NULL;
+  int interval_ms = 1000;
+  long count = 0;
+
+  for(int i = 1; i < argc; i++){
+    if(strcmp(argv[i], "--interval") == 0 && i + 1 < argc){
+      interval_ms = atoi(argv[++i]);
+    }else if(strcmp(argv[i], "--count") == 0 && i + 1 < argc){
+      count = atol(argv[++i]);
+    }else if(name == NULL && argv[i][0] != '-'){
+      name = argv[i];
+    }else{
+      name = NULL;
+      break;
+    }
+  }
+  if(name == NULL || interval_ms < 1){
+    fprintf(stderr, "Usage: %s NAME [--interval MS] [--count N]\n", argv[0]);
+    fprintf(stderr, "Reads /dev/shm/NAME written by ghost_sim --metrics NAME\n");
+    return 1;
+  }
+
+  char path[MAX_PATH_LENGTH];
+  snprintf(path, sizeof(path), "/%s", name);
+  int fd = shm_open(path, O_RDONLY, 0);
+  if(fd < 0){
+    perror(path);
+    return 1;
+  }
+  struct stat info;
+  if(fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(struct MetricsRegion)){
+    fprintf(stderr, "%s: not a metrics region (too small)\n", path);
+    close(fd);
+    return 1;
+  }
+  const struct MetricsRegion* region = mmap(NULL, sizeof(struct MetricsRegion), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(region == MAP_FAILED){
+    perror(path);
+    return 1;
+  }
+
+  //wait for the simulator to finish initializing the layout
+  while(__atomic_load_n(&region->magic, __ATOMIC_ACQUIRE) != METRICS_MAGIC){
+    usleep(10000);
+  }
+  if(region->layout != METRICS_LAYOUT || region->size != sizeof(struct MetricsRegion)){
+    fprintf(stderr, "%s: layout %u is not supported\n", path, region->layout);
+    return 1;
+  }
+  printf("attached to pid %d, %d worker slot(s)\n", region->pid, region->slot_count);
+
+  struct Sample prev, cur;
+  take_sample(region, &prev);
+  struct timespec pause = { interval_ms / 1000, (interval_ms % 1000) * 1000000L };
+  for(long n = 0; count == 0 || n < count; n++){
+    nanosleep(&pause, NULL);
+    take_sample(region, &cur);
+    print_sample(region, &prev, &cur);
+    prev = cur;
+    if(__atomic_load_n(&region->finished, __ATOMIC_RELAXED) && count == 0){
+      break;
+    }
+  }
+
+  munmap((void*)region, sizeof(struct MetricsRegion));
+  return 0;
+}
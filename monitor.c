@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+  Live observer for a running hunt. The monitor thread captures the world
+  without taking any lock an entity thread could wait on: rooms through
+  their seqlock snapshots, hunter counters and the case file through
+  relaxed atomic loads. Each capture fills the back half of a double
+  buffer and is then published by bumping a version number, so readers of
+  monitor_read never block the monitor either. Each half also carries its
+  own seqlock sequence, the same scheme as the rooms', so a reader the
+  monitor laps while it copies sees the sequence move and retries.
+*/
+
+/*
+   Function: monitor_clock_ns
+   Purpose:  Reads the monotonic clock.
+   Return: long long - nanoseconds from an arbitrary origin
+*/
+static long long monitor_clock_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+   Function: monitor_capture
+   Purpose:  Captures rooms, hunter counters and the case file. Every room
+   is internally consistent; different rooms and hunters are read a few
+   nanoseconds apart, which is as consistent as a free-running hunt allows.
+   Params:
+    Input: struct House* house - the running house
+    Output: struct WorldSnapshot* snapshot - the captured state
+   Return: void
+*/
+void monitor_capture(struct House* house, struct WorldSnapshot* snapshot){
+  snapshot->room_count = house->room_count;
+  snapshot->ghost_room = -1;
+  snapshot->room_evidence = 0;
+  snapshot->busiest_room = 0;
+
+  for(int i = 0; i < house->room_count; i++){
+    struct RoomSnapshot room;
+    room_snapshot(&house->rooms[i], &room);
+    snapshot->rooms[i].hunter_count = room.hunter_count;
+    snapshot->rooms[i].evidence = room.evidence;
+    snapshot->rooms[i].has_ghost = room.ghost != NULL;
+    if(room.ghost != NULL){
+      snapshot->ghost_room = i;
+    }
+    snapshot->room_evidence += evidence_count_bits(room.evidence);
+    if(room.hunter_count > snapshot->rooms[snapshot->busiest_room].hunter_count){
+      snapshot->busiest_room = i;
+    }
+  }
+
+  snapshot->hunter_count = house->hunter_count;
+  snapshot->hunters_active = 0;
+  snapshot->hunters_returning = 0;
+  snapshot->fear_total = 0;
+  snapshot->fear_max = 0;
+  snapshot->boredom_total = 0;
+  snapshot->boredom_max = 0;
+  for(int i = 0; i < house->hunter_count; i++){
+    struct Hunter* hunter = &house->hunters[i];
+    if(__atomic_load_n(&hunter->should_exit, __ATOMIC_RELAXED)){
+      continue;
+    }
+    int fear = __atomic_load_n(&hunter->fear, __ATOMIC_RELAXED);
+    int boredom = __atomic_load_n(&hunter->boredom, __ATOMIC_RELAXED);
+    snapshot->hunters_active++;
+    snapshot->hunters_returning += __atomic_load_n(&hunter->return_to_van, __ATOMIC_RELAXED);
+    snapshot->fear_total += fear;
+    snapshot->boredom_total += boredom;
+    if(fear > snapshot->fear_max) snapshot->fear_max = fear;
+    if(boredom > snapshot->boredom_max) snapshot->boredom_max = boredom;
+  }
+
+  struct CaseFile* casefile = &house->caseFile;
+  snapshot->collected = __atomic_load_n(&casefile->collected, __ATOMIC_RELAXED);
+  snapshot->solved = __atomic_load_n(&casefile->solved, __ATOMIC_RELAXED);
+  snapshot->candidates = __atomic_load_n(&casefile->candidates, __ATOMIC_RELAXED);
+  snapshot->taken_ns = monitor_clock_ns();
+}
+
+/*
+   Function: monitor_publish
+   Purpose:  Captures into the buffer readers are not using and makes it
+   current. Only one thread may publish to a monitor.
+   Params:
+    Input/Output: struct Monitor* monitor - the monitor
+   Return: void
+*/
+void monitor_publish(struct Monitor* monitor){
+  unsigned next = monitor->version + 1;
+  unsigned* seq = &monitor->seqs[next & 1];
+  __atomic_store_n(seq, *seq + 1, __ATOMIC_RELAXED);
+  //the odd sequence must be visible before the buffer changes
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  monitor_capture(monitor->house, &monitor->buffers[next & 1]);
+  __atomic_store_n(seq, *seq + 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&monitor->version, next, __ATOMIC_RELEASE);
+}
+
+/*
+   Function: monitor_read
+   Purpose:  Copies the latest published snapshot. Safe from any thread
+   while the monitor runs; never waits on it.
+   Params:
+    Input: struct Monitor* monitor - a started monitor
+    Output: struct WorldSnapshot* snapshot - the copy
+   Return: bool - false if nothing has been published yet
+*/
+bool monitor_read(struct Monitor* monitor, struct WorldSnapshot* snapshot){
+  while(true){
+    unsigned version = __atomic_load_n(&monitor->version, __ATOMIC_ACQUIRE);
+    if(version == 0){
+      return false;
+    }
+    unsigned* seq = &monitor->seqs[version & 1];
+    unsigned before = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+    if(before & 1){
+      continue;
+    }
+    memcpy(snapshot, &monitor->buffers[version & 1], sizeof(*snapshot));
+    //the copy must finish before the sequence is checked again
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if(__atomic_load_n(seq, __ATOMIC_RELAXED) == before){
+      return true;
+    }
+  }
+}
+
+/*
+   Function: monitor_render
+   Purpose:  Writes one compact status line for a snapshot to stderr.
+   Params:
+    Input: const struct Monitor* monitor - the monitor (house and start time)
+    Input: const struct WorldSnapshot* snapshot - what to show
+   Return: void
+*/
+static void monitor_render(const struct Monitor* monitor, const struct WorldSnapshot* snapshot){
+  const struct House* house = monitor->house;
+  int active = snapshot->hunters_active;
+  char evidence[64] = "";
+  const enum EvidenceType* evidence_types = NULL;
+  int count = get_all_evidence_types(&evidence_types);
+  for(int i = 0; i < count; i++){
+    if(evidence_has(snapshot->collected, evidence_types[i])){
+      if(evidence[0] != '\0') strcat(evidence, ",");
+      strcat(evidence, evidence_to_string(evidence_types[i]));
+    }
+  }
+
+  fprintf(stderr,
+	  "[monitor %6.1fs] hunters %d/%d (%d returning) fear avg %.1f max %d boredom avg %.1f max %d"
+	  " | busiest %s (%d) | ghost %s | room evidence %d | case %s%s, %d candidates\n",
+	  (snapshot->taken_ns - monitor->started_ns) / 1e9,
+	  active, snapshot->hunter_count, snapshot->hunters_returning,
+	  active ? (double)snapshot->fear_total / active : 0.0, snapshot->fear_max,
+	  active ? (double)snapshot->boredom_total / active : 0.0, snapshot->boredom_max,
+	  house->rooms[snapshot->busiest_room].name, snapshot->rooms[snapshot->busiest_room].hunter_count,
+	  snapshot->ghost_room >= 0 ? house->rooms[snapshot->ghost_room].name : "gone",
+	  snapshot->room_evidence,
+	  evidence[0] != '\0' ? evidence : "empty", snapshot->solved ? " (solved)" : "",
+	  __builtin_popcount(snapshot->candidates));
+}
+
+/*
+   Function: monitor_thread
+   Purpose:  Publishes a snapshot every MONITOR_TICK_MS and renders a status
+   line every MONITOR_INTERVAL_MS until monitor_stop.
+   Params:
+    Input/Output: void* data - the struct Monitor
+   Return: void* - NULL
+*/
+static void* monitor_thread(void* data){
+  struct Monitor* monitor = (struct Monitor*)data;
+  struct timespec tick = { 0, MONITOR_TICK_MS * 1000000L };
+  long long next_render = monitor->started_ns + MONITOR_INTERVAL_MS * 1000000LL;
+
+  while(!__atomic_load_n(&monitor->stop, __ATOMIC_ACQUIRE)){
+    nanosleep(&tick, NULL);
+    monitor_publish(monitor);
+
+    struct WorldSnapshot* latest = &monitor->buffers[monitor->version & 1];
+    if(latest->taken_ns >= next_render){
+      monitor_render(monitor, latest);
+      next_render += MONITOR_INTERVAL_MS * 1000000LL;
+    }
+  }
+  return NULL;
+}
+
+/*
+   Function: monitor_start
+   Purpose:  Starts the monitor thread for a house whose entity threads are running.
+   Params:
+    Output: struct Monitor* monitor - the monitor to start (stays owned by the caller)
+    Input: struct House* house - the house to watch
+   Return: bool - false if the thread could not be started
+*/
+bool monitor_start(struct Monitor* monitor, struct House* house){
+  memset(monitor, 0, sizeof(*monitor));
+  monitor->house = house;
+  monitor->started_ns = monitor_clock_ns();
+  monitor->running = pthread_create(&monitor->thread, NULL, monitor_thread, monitor) == 0;
+  return monitor->running;
+}
+
+/*
+   Function: monitor_stop
+   Purpose:  Stops and joins the monitor thread; returns within one tick.
+   Params:
+    Input/Output: struct Monitor* monitor - a started monitor
+   Return: void
+*/
+void monitor_stop(struct Monitor* monitor){
+  if(!monitor->running){
+    return;
+  }
+  __atomic_store_n(&monitor->stop, true, __ATOMIC_RELEASE);
+  pthread_join(monitor->thread, NULL);
+  monitor->running = false;
+}
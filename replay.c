@@ -0,0 +1,757 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <glob.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "defs.h"
+#include "helpers.h"
+
+/*
+  ghost_replay: rebuilds hunts from the log_<id>.csv files after the fact.
+  Every file is mapped read-only and scanned once. The scanner finds each
+  comma and newline 16 bytes at a time with SSE2 compares (a byte loop
+  where SSE2 is missing) and cuts each line at its first eight commas, so
+  a hunter name with commas in the last column stays whole. Room, action
+  and evidence names become small integers as they are parsed.
+
+  Each file is one entity's stream and already in time order, so the
+  streams are joined with the same k-way TimelineHeap merge as ghost_merge
+  (a file found out of order is sorted on its own first) and replayed
+  against a model of the house: room occupancy, evidence lying in rooms,
+  the ghost's position and the shared case file. A ghost INIT starts a
+  new hunt, which matches how sequential runs append to the same files.
+  Parallel batches (--jobs) interleave hunts in time and cannot be
+  separated from the logs alone.
+*/
+
+#define REPLAY_FIELDS 9
+#define REPLAY_NAME_SLOTS 256   //open-addressed room name table, power of two
+#define REPLAY_NO_ROOM 0xFF
+
+enum ReplayAction {
+  RA_INIT, RA_MOVE, RA_EVIDENCE, RA_SWAP, RA_EXIT, RA_RETURN_START, RA_RETURN_COMPLETE, RA_IDLE, RA_UNKNOWN
+};
+
+static const char* replay_action_names[] = {
+  "INIT", "MOVE", "EVIDENCE", "SWAP", "EXIT", "RETURN_START", "RETURN_COMPLETE", "IDLE", "?"
+};
+
+//One parsed log line
+struct ReplayRecord {
+  long long timestamp;   //ms since the epoch
+  unsigned order;        //position in the input, breaks timestamp ties
+  int id;
+  short boredom;
+  short fear;
+  unsigned char ghost;   //1 for ghost records
+  unsigned char action;  //enum ReplayAction
+  unsigned char room;    //room index, REPLAY_NO_ROOM when empty
+  unsigned char target;  //MOVE destination room
+  unsigned char device;  //evidence bit of the device column
+  unsigned char evidence; //evidence bit of the extra column (EVIDENCE records)
+  unsigned char reason;  //enum LogReason of a hunter EXIT
+  unsigned char ghost_type_index; //ghost INIT: index into get_all_ghost_types, 0xFF if unknown
+};
+
+//Everything parsed so far, plus the names the small integers stand for
+struct ReplayLog {
+  struct ReplayRecord* records;
+  size_t count;
+  size_t capacity;
+  size_t bytes;
+  size_t malformed;
+  char room_names[MAX_ROOMS][MAX_ROOM_NAME];
+  int room_count;
+  short name_slots[REPLAY_NAME_SLOTS];  //room index + 1, 0 when free
+};
+
+//A name the parser recognizes, with its length precomputed
+struct ReplayName {
+  const char* text;
+  size_t length;
+  unsigned char value;
+};
+
+//Every fixed vocabulary of the schema, filled once by replay_tables_init
+static struct ReplayName evidence_names[8];
+static int evidence_name_count;
+static struct ReplayName action_names[RA_UNKNOWN];
+
+//Where the scanner is inside the current line
+struct ReplayCursor {
+  const char* line;
+  int field;
+  const char* cuts[REPLAY_FIELDS - 1];
+};
+
+static long long now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+   Function: replay_tables_init
+   Purpose:  Fills the evidence and action name tables.
+   Return: void
+*/
+static void replay_tables_init(void){
+  const enum EvidenceType* types = NULL;
+  evidence_name_count = get_all_evidence_types(&types);
+  for(int i = 0; i < evidence_name_count; i++){
+    evidence_names[i].text = evidence_to_string(types[i]);
+    evidence_names[i].length = strlen(evidence_names[i].text);
+    evidence_names[i].value = (unsigned char)types[i];
+  }
+  for(int i = 0; i < RA_UNKNOWN; i++){
+    action_names[i].text = replay_action_names[i];
+    action_names[i].length = strlen(replay_action_names[i]);
+    action_names[i].value = (unsigned char)i;
+  }
+}
+
+/*
+   Function: lookup_name
+   Purpose:  Finds a field in a name table, comparing lengths first.
+   Params:
+    Input: const struct ReplayName* names - the table
+    Input: int count - its size
+    Input: const char* start - first byte of the field
+    Input: const char* end - one past the last byte
+    Input: unsigned char missing - returned when nothing matches
+   Return: unsigned char - the matching entry's value
+*/
+static inline unsigned char lookup_name(const struct ReplayName* names, int count,
+                                        const char* start, const char* end, unsigned char missing){
+  size_t length = (size_t)(end - start);
+  for(int i = 0; i < count; i++){
+    if(names[i].length == length && names[i].text[0] == start[0] &&
+       memcmp(start, names[i].text, length) == 0){
+      return names[i].value;
+    }
+  }
+  return missing;
+}
+
+/*
+   Function: parse_number
+   Purpose:  Reads a decimal field, optionally negative.
+   Params:
+    Input: const char* start - first byte of the field
+    Input: const char* end - one past the last byte
+   Return: long long - the value, 0 for an empty field
+*/
+static long long parse_number(const char* start, const char* end){
+  bool negative = start < end && *start == '-';
+  long long value = 0;
+  for(const char* c = start + negative; c < end; c++){
+    value = value * 10 + (*c - '0');
+  }
+  return negative ? -value : value;
+}
+
+/*
+   Function: field_is
+   Purpose:  Compares a field with a NUL-terminated string.
+   Params:
+    Input: const char* start - first byte of the field
+    Input: const char* end - one past the last byte
+    Input: const char* text - the string to compare with
+   Return: bool - true if they are equal
+*/
+static bool field_is(const char* start, const char* end, const char* text){
+  size_t length = strlen(text);
+  return (size_t)(end - start) == length && memcmp(start, text, length) == 0;
+}
+
+/*
+   Function: intern_room
+   Purpose:  Finds or adds a room name and returns its index.
+   Params:
+    Input/Output: struct ReplayLog* log - holds the name table
+    Input: const char* start - first byte of the name
+    Input: const char* end - one past the last byte
+   Return: unsigned char - the room index, REPLAY_NO_ROOM for an empty name or a full table
+*/
+static unsigned char intern_room(struct ReplayLog* log, const char* start, const char* end){
+  size_t length = (size_t)(end - start);
+  if(length == 0 || length >= MAX_ROOM_NAME){
+    return REPLAY_NO_ROOM;
+  }
+
+  //FNV-1a over the name, then linear probing
+  unsigned hash = 2166136261u;
+  for(const char* c = start; c < end; c++){
+    hash = (hash ^ (unsigned char)*c) * 16777619u;
+  }
+  for(unsigned probe = 0; probe < REPLAY_NAME_SLOTS; probe++){
+    unsigned slot = (hash + probe) & (REPLAY_NAME_SLOTS - 1);
+    int index = log->name_slots[slot] - 1;
+    if(index < 0){
+      if(log->room_count >= MAX_ROOMS){
+        return REPLAY_NO_ROOM;
+      }
+      index = log->room_count++;
+      memcpy(log->room_names[index], start, length);
+      log->room_names[index][length] = '\0';
+      log->name_slots[slot] = (short)(index + 1);
+      return (unsigned char)index;
+    }
+    if(field_is(start, end, log->room_names[index])){
+      return (unsigned char)index;
+    }
+  }
+  return REPLAY_NO_ROOM;
+}
+
+/*
+   Function: parse_line
+   Purpose:  Turns one cut line into a record and appends it.
+   Params:
+    Input/Output: struct ReplayLog* log - where the record goes
+    Input: const struct ReplayCursor* cursor - the line and its eight cuts
+    Input: const char* end - the newline (or end of file) closing the line
+   Return: void
+*/
+static void parse_line(struct ReplayLog* log, const struct ReplayCursor* cursor, const char* end){
+  if(log->count == log->capacity){
+    size_t capacity = log->capacity ? log->capacity * 2 : 4096;
+    struct ReplayRecord* records = realloc(log->records, capacity * sizeof(struct ReplayRecord));
+    if(records == NULL){
+      log->malformed++;
+      return;
+    }
+    log->records = records;
+    log->capacity = capacity;
+  }
+
+  //fields i run from start[i] to stop[i]; the last one takes the rest of the line
+  const char* start[REPLAY_FIELDS];
+  const char* stop[REPLAY_FIELDS];
+  start[0] = cursor->line;
+  for(int i = 0; i < REPLAY_FIELDS - 1; i++){
+    stop[i] = cursor->cuts[i];
+    start[i + 1] = cursor->cuts[i] + 1;
+  }
+  stop[REPLAY_FIELDS - 1] = (end > start[REPLAY_FIELDS - 1] && end[-1] == '\r') ? end - 1 : end;
+
+  struct ReplayRecord* record = &log->records[log->count];
+  record->timestamp = parse_number(start[0], stop[0]);
+  record->order = (unsigned)log->count;
+  record->ghost = field_is(start[1], stop[1], "ghost");
+  record->id = (int)parse_number(start[2], stop[2]);
+  record->room = intern_room(log, start[3], stop[3]);
+  record->device = lookup_name(evidence_names, evidence_name_count, start[4], stop[4], 0);
+  record->boredom = (short)parse_number(start[5], stop[5]);
+  record->fear = (short)parse_number(start[6], stop[6]);
+  record->action = lookup_name(action_names, RA_UNKNOWN, start[7], stop[7], RA_UNKNOWN);
+  record->target = REPLAY_NO_ROOM;
+  record->evidence = 0;
+  record->reason = LR_BORED;
+  record->ghost_type_index = 0xFF;
+
+  //the extra column means something different for each action
+  const char* extra = start[8];
+  const char* extra_end = stop[8];
+  if(record->action == RA_MOVE){
+    record->target = intern_room(log, extra, extra_end);
+  }else if(record->action == RA_EVIDENCE){
+    record->evidence = lookup_name(evidence_names, evidence_name_count, extra, extra_end, 0);
+  }else if(record->action == RA_EXIT && !record->ghost){
+    for(int reason = LR_EVIDENCE; reason <= LR_AFRAID; reason++){
+      if(field_is(extra, extra_end, exit_reason_to_string(reason))){
+        record->reason = (unsigned char)reason;
+      }
+    }
+  }else if(record->action == RA_INIT && record->ghost){
+    const enum GhostType* types = NULL;
+    int count = get_all_ghost_types(&types);
+    for(int i = 0; i < count; i++){
+      if(field_is(extra, extra_end, ghost_to_string(types[i]))){
+        record->ghost_type_index = (unsigned char)i;
+      }
+    }
+  }
+
+  log->count++;
+}
+
+/*
+   Function: on_delimiter
+   Purpose:  Handles one comma or newline found by the scanner.
+   Params:
+    Input/Output: struct ReplayLog* log - receives finished lines
+    Input/Output: struct ReplayCursor* cursor - the line being cut
+    Input: const char* at - the delimiter
+   Return: void
+*/
+static inline void on_delimiter(struct ReplayLog* log, struct ReplayCursor* cursor, const char* at){
+  if(*at == '\n'){
+    if(cursor->field == REPLAY_FIELDS - 1){
+      parse_line(log, cursor, at);
+    }else if(at > cursor->line){
+      log->malformed++;
+    }
+    cursor->line = at + 1;
+    cursor->field = 0;
+  }else if(cursor->field < REPLAY_FIELDS - 1){
+    cursor->cuts[cursor->field++] = at;
+  }
+}
+
+/*
+   Function: scan_line_bytes
+   Purpose:  Cuts one line byte by byte: the tail of a file, lines longer
+   than 64 bytes, and every line of a build without SSE2.
+   Params:
+    Input/Output: struct ReplayLog* log - receives the record
+    Input/Output: struct ReplayCursor* cursor - starts at the line
+    Input: const char* end - end of the file
+   Return: bool - true if the line ended in a newline, false at the end of the file
+*/
+static bool scan_line_bytes(struct ReplayLog* log, struct ReplayCursor* cursor, const char* end){
+  for(const char* c = cursor->line; c < end; c++){
+    if(*c == ',' || *c == '\n'){
+      on_delimiter(log, cursor, c);
+      if(*c == '\n'){
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+#ifdef __SSE2__
+/*
+   Function: block_mask
+   Purpose:  Marks every byte equal to a character in 64 bytes, four SSE2
+   compares folded into one word.
+   Params:
+    Input: const char* at - the first of 64 readable bytes
+    Input: __m128i match - the character in every lane
+   Return: unsigned long long - bit i set when at[i] matches
+*/
+static inline unsigned long long block_mask(const char* at, __m128i match){
+  unsigned long long mask = 0;
+  for(int i = 0; i < 4; i++){
+    __m128i block = _mm_loadu_si128((const __m128i*)(at + 16 * i));
+    mask |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, match)) << (16 * i);
+  }
+  return mask;
+}
+#endif
+
+/*
+   Function: replay_scan
+   Purpose:  Cuts every line of a mapped file and parses it. With SSE2 a
+   line is taken 64 bytes at a time: one mask of its commas, one of its
+   newlines, and the first eight comma bits peeled off with no loop over
+   the rest. Anything that does not fit that window goes byte by byte.
+   Params:
+    Input/Output: struct ReplayLog* log - receives the records
+    Input: const char* data - the file contents
+    Input: size_t size - their length
+   Return: void
+*/
+static void replay_scan(struct ReplayLog* log, const char* data, size_t size){
+  struct ReplayCursor cursor = { data, 0, { NULL } };
+  const char* end = data + size;
+  bool more = true;
+
+#ifdef __SSE2__
+  const __m128i comma = _mm_set1_epi8(',');
+  const __m128i newline = _mm_set1_epi8('\n');
+  while(more && end - cursor.line >= 64){
+    const char* line = cursor.line;
+    unsigned long long newlines = block_mask(line, newline);
+    if(newlines != 0){
+      //commas before the first newline only
+      unsigned long long commas = block_mask(line, comma) & ((newlines & -newlines) - 1);
+      if(__builtin_popcountll(commas) >= REPLAY_FIELDS - 1){
+        for(int i = 0; i < REPLAY_FIELDS - 1; i++){
+          cursor.cuts[i] = line + __builtin_ctzll(commas);
+          commas &= commas - 1;
+        }
+        const char* stop = line + __builtin_ctzll(newlines);
+        parse_line(log, &cursor, stop);
+        cursor.line = stop + 1;
+        continue;
+      }
+    }
+    more = scan_line_bytes(log, &cursor, end);
+  }
+#endif
+
+  while(more && cursor.line < end){
+    more = scan_line_bytes(log, &cursor, end);
+  }
+
+  //a last line without its newline still counts
+  if(cursor.field == REPLAY_FIELDS - 1){
+    parse_line(log, &cursor, end);
+  }else if(cursor.line < end){
+    log->malformed++;
+  }
+}
+
+/*
+   Function: replay_load_file
+   Purpose:  Maps one log file read-only and scans it.
+   Params:
+    Input/Output: struct ReplayLog* log - receives the records
+    Input: const char* path - the file
+   Return: bool - false if the file could not be opened or mapped
+*/
+static bool replay_load_file(struct ReplayLog* log, const char* path){
+  int fd = open(path, O_RDONLY);
+  if(fd < 0){
+    perror(path);
+    return false;
+  }
+  struct stat info;
+  if(fstat(fd, &info) != 0){
+    perror(path);
+    close(fd);
+    return false;
+  }
+  if(info.st_size == 0){
+    close(fd);
+    return true;
+  }
+
+  //reserve for the whole file at once; records average well over 32 bytes of text
+  size_t expected = log->count + (size_t)info.st_size / 32 + 1;
+  if(expected > log->capacity){
+    struct ReplayRecord* records = realloc(log->records, expected * sizeof(struct ReplayRecord));
+    if(records != NULL){
+      log->records = records;
+      log->capacity = expected;
+    }
+  }
+
+  //populate up front: one bulk read instead of a fault every 4 KiB
+  void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED){
+    perror(path);
+    return false;
+  }
+
+  replay_scan(log, data, (size_t)info.st_size);
+  log->bytes += (size_t)info.st_size;
+  munmap(data, (size_t)info.st_size);
+  return true;
+}
+
+/*
+   Function: compare_records
+   Purpose:  qsort order for a file that is out of order: by timestamp,
+   then by position in the input.
+   Params:
+    Input: const void* a - a struct ReplayRecord
+    Input: const void* b - another struct ReplayRecord
+   Return: int - negative, zero or positive like strcmp
+*/
+static int compare_records(const void* a, const void* b){
+  const struct ReplayRecord* left = a;
+  const struct ReplayRecord* right = b;
+  if(left->timestamp != right->timestamp){
+    return left->timestamp < right->timestamp ? -1 : 1;
+  }
+  return (left->order > right->order) - (left->order < right->order);
+}
+
+//The house as the logs describe it, for one hunt
+struct ReplayHunt {
+  int number;
+  long long started;
+  long long ended;
+  size_t records;
+  int ghost_type_index;
+  int ghost_room;              //-1 when gone
+  int hunters_in;
+  int hunters_seen;
+  int exits[AGGREGATE_EXIT_REASONS];
+  EvidenceByte collected;      //case file
+  long long solved_at;         //first time the case file named a ghost, 0 if never
+  int occupancy[MAX_ROOMS];
+  int peak[MAX_ROOMS];
+  EvidenceByte evidence[MAX_ROOMS];
+  unsigned long drops[MAX_ROOMS];
+  unsigned long pickups[MAX_ROOMS];
+};
+
+/*
+   Function: format_evidence
+   Purpose:  Writes an evidence mask as a comma-separated list.
+   Params:
+    Input: EvidenceByte mask - the evidence
+    Output: char* out - at least 64 bytes
+   Return: const char* - out, or "none"
+*/
+static const char* format_evidence(EvidenceByte mask, char* out){
+  const enum EvidenceType* types = NULL;
+  int count = get_all_evidence_types(&types);
+  out[0] = '\0';
+  for(int i = 0; i < count; i++){
+    if(mask & types[i]){
+      if(out[0] != '\0') strcat(out, ",");
+      strcat(out, evidence_to_string(types[i]));
+    }
+  }
+  return out[0] != '\0' ? out : "none";
+}
+
+/*
+   Function: hunt_print
+   Purpose:  Prints the summary of one rebuilt hunt, and its rooms if asked.
+   Params:
+    Input: const struct ReplayHunt* hunt - the hunt
+    Input: const struct ReplayLog* log - room names
+    Input: bool rooms - print the per-room table
+   Return: void
+*/
+static void hunt_print(const struct ReplayHunt* hunt, const struct ReplayLog* log, bool rooms){
+  const enum GhostType* ghost_types = NULL;
+  get_all_ghost_types(&ghost_types);
+  char evidence[64];
+
+  printf("Hunt %d: %.3f s, %zu records, ghost %s, %d hunters (%d evidence, %d bored, %d afraid)\n",
+         hunt->number, (hunt->ended - hunt->started) / 1000.0, hunt->records,
+         hunt->ghost_type_index >= 0 ? ghost_to_string(ghost_types[hunt->ghost_type_index]) : "unknown",
+         hunt->hunters_seen, hunt->exits[LR_EVIDENCE], hunt->exits[LR_BORED], hunt->exits[LR_AFRAID]);
+  printf("  case file: %s", format_evidence(hunt->collected, evidence));
+  if(hunt->solved_at != 0){
+    printf(" (solved after %.3f s)", (hunt->solved_at - hunt->started) / 1000.0);
+  }
+  printf("\n");
+
+  if(!rooms){
+    return;
+  }
+  printf("  %-20s %5s %6s %8s %8s  %s\n", "room", "peak", "still", "dropped", "taken", "left in room");
+  for(int i = 0; i < log->room_count; i++){
+    if(hunt->peak[i] == 0 && hunt->drops[i] == 0){
+      continue;
+    }
+    printf("  %-20s %5d %6d %8lu %8lu  %s\n", log->room_names[i], hunt->peak[i], hunt->occupancy[i],
+           hunt->drops[i], hunt->pickups[i], format_evidence(hunt->evidence[i], evidence));
+  }
+}
+
+/*
+   Function: hunt_apply
+   Purpose:  Applies one record to the rebuilt house.
+   Params:
+    Input/Output: struct ReplayHunt* hunt - the hunt so far
+    Input: const struct ReplayRecord* record - the event
+   Return: void
+*/
+static void hunt_apply(struct ReplayHunt* hunt, const struct ReplayRecord* record){
+  int room = record->room != REPLAY_NO_ROOM ? record->room : -1;
+  int target = record->target != REPLAY_NO_ROOM ? record->target : -1;
+  hunt->records++;
+  hunt->ended = record->timestamp;
+
+  if(record->ghost){
+    if(record->action == RA_INIT){
+      hunt->ghost_room = room;
+      hunt->ghost_type_index = record->ghost_type_index != 0xFF ? record->ghost_type_index : -1;
+    }else if(record->action == RA_MOVE){
+      hunt->ghost_room = target;
+    }else if(record->action == RA_EVIDENCE && room >= 0){
+      if(!(hunt->evidence[room] & record->evidence)){
+        hunt->drops[room]++;
+      }
+      hunt->evidence[room] |= record->evidence;
+    }else if(record->action == RA_EXIT){
+      hunt->ghost_room = -1;
+    }
+    return;
+  }
+
+  switch(record->action){
+    case RA_INIT:
+      hunt->hunters_seen++;
+      hunt->hunters_in++;
+      if(room >= 0) hunt->occupancy[room]++;
+      break;
+    case RA_MOVE:
+      if(room >= 0) hunt->occupancy[room]--;
+      if(target >= 0) hunt->occupancy[target]++;
+      room = target;
+      break;
+    case RA_EVIDENCE:
+      if(room >= 0){
+        hunt->evidence[room] &= (EvidenceByte)~record->evidence;
+        hunt->pickups[room]++;
+      }
+      hunt->collected |= record->evidence;
+      if(hunt->solved_at == 0 && evidence_has_three_unique(hunt->collected) &&
+         evidence_is_valid_ghost(hunt->collected)){
+        hunt->solved_at = record->timestamp;
+      }
+      break;
+    case RA_EXIT:
+      hunt->hunters_in--;
+      hunt->exits[record->reason]++;
+      if(room >= 0) hunt->occupancy[room]--;
+      break;
+    default:
+      break;
+  }
+  if(room >= 0 && hunt->occupancy[room] > hunt->peak[room]){
+    hunt->peak[room] = hunt->occupancy[room];
+  }
+}
+
+/*
+   Function: print_event
+   Purpose:  Prints one timeline line: the event and the state it leads to.
+   Params:
+    Input: const struct ReplayHunt* hunt - the state after the event
+    Input: const struct ReplayLog* log - room names
+    Input: const struct ReplayRecord* record - the event
+   Return: void
+*/
+static void print_event(const struct ReplayHunt* hunt, const struct ReplayLog* log, const struct ReplayRecord* record){
+  char evidence[64];
+  const char* room = record->room != REPLAY_NO_ROOM ? log->room_names[record->room] : "-";
+  printf("%9.3f %-6s %6d %-15s %-16s", (record->timestamp - hunt->started) / 1000.0,
+         record->ghost ? "ghost" : "hunter", record->id, replay_action_names[record->action], room);
+  if(record->target != REPLAY_NO_ROOM){
+    printf(" -> %-16s", log->room_names[record->target]);
+  }
+  printf(" | hunters %d ghost %s case %s\n", hunt->hunters_in,
+         hunt->ghost_room >= 0 ? log->room_names[hunt->ghost_room] : "gone",
+         format_evidence(hunt->collected, evidence));
+}
+
+int main(int argc, char** argv){
+  bool timeline = false;
+  bool rooms = false;
+  int first_file = argc;
+
+  for(int i = 1; i < argc; i++){
+    if(strcmp(argv[i], "--timeline") == 0){
+      timeline = true;
+    }else if(strcmp(argv[i], "--rooms") == 0){
+      rooms = true;
+    }else if(argv[i][0] == '-'){
+      fprintf(stderr, "Usage: %s [--timeline] [--rooms] [log_<id>.csv ...]\n", argv[0]);
+      fprintf(stderr, "With no files every log_*.csv in the current directory is read.\n");
+      return 1;
+    }else{
+      first_file = i;
+      break;
+    }
+  }
+
+  glob_t found;
+  memset(&found, 0, sizeof(found));
+  char** files = argv + first_file;
+  int file_count = argc - first_file;
+  if(file_count == 0){
+    if(glob("log_*.csv", 0, NULL, &found) != 0){
+      fprintf(stderr, "No log_*.csv files here\n");
+      return 1;
+    }
+    files = found.gl_pathv;
+    file_count = (int)found.gl_pathc;
+  }
+
+  replay_tables_init();
+  struct ReplayLog* log = calloc(1, sizeof(struct ReplayLog));
+  if(log == NULL){
+    return 1;
+  }
+
+  //file i's records are run i: records[run_start[i]] up to run_start[i + 1]
+  size_t* run_start = calloc((size_t)file_count + 1, sizeof(size_t));
+  size_t* run_next = calloc((size_t)file_count + 1, sizeof(size_t));
+  struct TimelineHeap heap;
+  if(run_start == NULL || run_next == NULL || !timeline_init(&heap, file_count)){
+    return 1;
+  }
+
+  long long scan_start = now_ns();
+  bool ok = true;
+  for(int i = 0; i < file_count; i++){
+    run_start[i] = log->count;
+    ok = replay_load_file(log, files[i]) && ok;
+  }
+  run_start[file_count] = log->count;
+  long long scan_ns = now_ns() - scan_start;
+
+  long long order_start = now_ns();
+  int resorted = 0;
+  for(int i = 0; i < file_count; i++){
+    struct ReplayRecord* run = log->records + run_start[i];
+    size_t length = run_start[i + 1] - run_start[i];
+    for(size_t j = 1; j < length; j++){
+      if(run[j].timestamp < run[j - 1].timestamp){
+        qsort(run, length, sizeof(struct ReplayRecord), compare_records);
+        resorted++;
+        break;
+      }
+    }
+    run_next[i] = run_start[i];
+    if(length > 0){
+      timeline_push(&heap, run[0].timestamp, i);
+    }
+  }
+  long long order_ns = now_ns() - order_start;
+
+  //a ghost INIT opens the next hunt
+  struct ReplayHunt hunt;
+  memset(&hunt, 0, sizeof(hunt));
+  hunt.ghost_type_index = -1;
+  hunt.ghost_room = -1;
+  int hunts = 0;
+  long long replay_start = now_ns();
+  for(int run = timeline_next(&heap); run >= 0; run = timeline_next(&heap)){
+    const struct ReplayRecord* record = &log->records[run_next[run]++];
+    bool more = run_next[run] < run_start[run + 1];
+    timeline_advance(&heap, more, more ? log->records[run_next[run]].timestamp : 0);
+    if(record->ghost && record->action == RA_INIT){
+      if(hunt.records > 0){
+        hunt_print(&hunt, log, rooms);
+      }
+      memset(&hunt, 0, sizeof(hunt));
+      hunt.number = ++hunts;
+      hunt.started = record->timestamp;
+    }
+    if(hunt.records == 0 && hunt.started == 0){
+      hunt.started = record->timestamp;
+    }
+    hunt_apply(&hunt, record);
+    if(timeline){
+      print_event(&hunt, log, record);
+    }
+  }
+  if(hunt.records > 0){
+    hunt_print(&hunt, log, rooms);
+  }
+  long long replay_ns = now_ns() - replay_start;
+
+  double seconds = scan_ns / 1e9;
+  fprintf(stderr, "%d files, %zu records (%zu malformed), %.1f MB: scanned in %.1f ms (%.2f GB/s), "
+          "%d out-of-order files sorted in %.1f ms, merged and replayed in %.1f ms\n",
+          file_count, log->count, log->malformed, log->bytes / 1e6, scan_ns / 1e6,
+          seconds > 0 ? log->bytes / seconds / 1e9 : 0.0, resorted, order_ns / 1e6, replay_ns / 1e6);
+
+  timeline_free(&heap);
+  free(run_start);
+  free(run_next);
+  globfree(&found);
+  free(log->records);
+  free(log);
+  return ok ? 0 : 1;
+}
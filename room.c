@@ -33,8 +33,14 @@ void room_init(struct Room* room, const char* name, bool is_exit){
   room->is_exit = is_exit;
   room->evidence = 0;
 
-  //Initialize sempahore
+  //filled in by house_build_routes once the layout is connected
+  room->van_next_hop = NULL;
+  room->van_distance = -1;
+
+  //Initialize sempahore and the read-side sequence
   sem_init(&room->mutex,0,1);
+  room->seq = 0;
+  memset(room->swept, 0, sizeof(room->swept));
  
 }
 
@@ -87,8 +93,10 @@ bool room_add_hunter(struct Room* room, struct Hunter* hunter){
   }
 
   //add the hunter
-  room->hunters[room->hunter_count] = hunter;
-  room->hunter_count++;
+  room_write_begin(room);
+  __atomic_store_n(&room->hunters[room->hunter_count], hunter, __ATOMIC_RELAXED);
+  __atomic_store_n(&room->hunter_count, room->hunter_count + 1, __ATOMIC_RELAXED);
+  room_write_end(room);
   return true;
 }
 
@@ -105,29 +113,87 @@ void room_remove_hunter(struct Room* room, struct Hunter* hunter){
   for(int i = 0; i < room->hunter_count; i++){
     if(room->hunters[i] == hunter){
       //shift the hunters down
+      room_write_begin(room);
       for(int j = i; j < room->hunter_count-1; j++){
-	room->hunters[j] = room->hunters[j+1];
+	__atomic_store_n(&room->hunters[j], room->hunters[j+1], __ATOMIC_RELAXED);
       }
-      room->hunters[room->hunter_count-1] = NULL;
-      room->hunter_count--;
+      __atomic_store_n(&room->hunters[room->hunter_count-1], NULL, __ATOMIC_RELAXED);
+      __atomic_store_n(&room->hunter_count, room->hunter_count - 1, __ATOMIC_RELAXED);
+      room_write_end(room);
       return;
     }
   }
 }
 
+/* 
+   Function: room_write_begin
+   Purpose:  Opens a write to the seqlocked fields (ghost, hunter_count,
+             hunters, evidence). The caller holds the room mutex, so the
+             sequence is only ever written by one thread and needs no atomic
+             add. The fields themselves are stored with relaxed atomics, as
+             room_snapshot loads them.
+   Params:   
+    Input/Output: struct Room* room - the room about to change
+   Return: void
+*/
+void room_write_begin(struct Room* room){
+  __atomic_store_n(&room->seq, room->seq + 1, __ATOMIC_RELAXED);
+  //the odd sequence must be visible before any field changes
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/* 
+   Function: room_write_end
+   Purpose:  Closes a write opened by room_write_begin; the sequence is even again.
+   Params:   
+    Input/Output: struct Room* room - the room that changed
+   Return: void
+*/
+void room_write_end(struct Room* room){
+  __atomic_store_n(&room->seq, room->seq + 1, __ATOMIC_RELEASE);
+}
+
+/* 
+   Function: room_snapshot
+   Purpose:  Reads ghost, occupancy and evidence as one consistent set
+             without taking the mutex. Retries while a writer is active or
+             if the sequence moved during the read.
+   Params:   
+    Input: struct Room* room - the room to read
+    Output: struct RoomSnapshot* snapshot - the values read
+   Return: void
+*/
+void room_snapshot(struct Room* room, struct RoomSnapshot* snapshot){
+  unsigned before, after;
+  do{
+    before = __atomic_load_n(&room->seq, __ATOMIC_ACQUIRE);
+    if(before & 1){
+      continue;
+    }
+    snapshot->ghost = __atomic_load_n(&room->ghost, __ATOMIC_RELAXED);
+    snapshot->hunter_count = __atomic_load_n(&room->hunter_count, __ATOMIC_RELAXED);
+    snapshot->evidence = __atomic_load_n(&room->evidence, __ATOMIC_RELAXED);
+    //the field loads must finish before the sequence is checked again
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    after = __atomic_load_n(&room->seq, __ATOMIC_RELAXED);
+    if(before == after){
+      return;
+    }
+  }while(true);
+}
+
 /* 
    Function: room_has_hunters
    Purpose:  Checks if there are any hunters currently in the room.
-             Locks the room mutex before reading
+             Reads a seqlock snapshot instead of locking the room.
    Params:   
     Input: struct Room* room - the room to check
    Return: bool - true if at least one hunter is in the room, false otherwise
 */
 bool room_has_hunters(struct Room* room){
-  sem_wait(&room->mutex);
-  bool result = (room->hunter_count > 0);
-  sem_post(&room->mutex);
-  return result;
+  struct RoomSnapshot snapshot;
+  room_snapshot(room, &snapshot);
+  return snapshot.hunter_count > 0;
 }
 
 /* 
@@ -141,3 +207,29 @@ void room_cleanup(struct Room* room){
   sem_destroy(&room->mutex);
 }
 
+
+/* 
+   Function: room_mark_swept
+   Purpose:  Records that a hunter searched the room with a device. Lock
+   free: concurrent marks race harmlessly, one of two close stamps wins.
+   Params:   
+    Input/Output: struct Room* room - the room searched
+    Input: enum EvidenceType device - the device used
+    Input: unsigned long stamp - from casefile_next_sweep
+   Return: void
+*/
+void room_mark_swept(struct Room* room, enum EvidenceType device, unsigned long stamp){
+  __atomic_store_n(&room->swept[__builtin_ctz((unsigned)device)], stamp, __ATOMIC_RELAXED);
+}
+
+/* 
+   Function: room_last_swept
+   Purpose:  Reads when the room was last searched with a device.
+   Params:   
+    Input: const struct Room* room - the room
+    Input: enum EvidenceType device - the device
+   Return: unsigned long - the sweep clock stamp, 0 if never
+*/
+unsigned long room_last_swept(const struct Room* room, enum EvidenceType device){
+  return __atomic_load_n(&room->swept[__builtin_ctz((unsigned)device)], __ATOMIC_RELAXED);
+}
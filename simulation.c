@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+   Function: simulation_runtime_params
+   Purpose:  Copies the options that only decide how a hunt is run, not
+   what its entities do, so set-up and resumed hunts share them.
+   Params:
+    Output: struct SimParams* params - the house's parameters
+    Input: const struct SimConfig* config - the options
+   Return: void
+*/
+static void simulation_runtime_params(struct SimParams* params, const struct SimConfig* config){
+  params->monitor = config->monitor;
+  params->schedule = config->schedule;
+  params->checkpoint_path = config->checkpoint_path[0] != '\0' ? config->checkpoint_path : NULL;
+  params->checkpoint_round = (unsigned long)config->checkpoint_round;
+}
+
+/*
+   Function: simulation_setup
+   Purpose:  Builds one run: initializes the house, populates the layout,
+   seeds the RNG streams, places the ghost and adds every roster hunter.
+   Params:
+    Output: struct House* house - the house to set up (cleaned up by house_cleanup)
+    Input: const struct SimConfig* config - layout, seed and other options
+    Input: const struct Roster* roster - the hunters to add
+    Input: int run_index - index of this run, offsets the base seed
+   Return: bool - false if the layout is unknown (house is still initialized)
+*/
+bool simulation_setup(struct House* house, const struct SimConfig* config,
+                      const struct Roster* roster, int run_index){
+  house_init(house);
+  house->params.return_mode = config->return_mode;
+  house->params.swap_mode = config->swap_mode;
+  house->params.explore_mode = config->explore_mode;
+  house->params.device_mode = config->device_mode;
+  house->params.early_exit = config->early_exit;
+  house->params.boredom_max = config->boredom_max;
+  house->params.fear_max = config->fear_max;
+  house->params.occupancy = config->occupancy;
+  house->params.return_chance = config->return_chance;
+  house->params.idle_weight = config->ghost_weights[0];
+  house->params.haunt_weight = config->ghost_weights[1];
+  house->params.move_weight = config->ghost_weights[2];
+  house_params_update(&house->params);
+  simulation_runtime_params(&house->params, config);
+
+  if(!house_populate_layout(house, config->layout)){
+    fprintf(stderr, "Unknown layout '%s'\n", config->layout);
+    return false;
+  }
+
+  //every run gets its own base seed so batch runs are not copies
+  if(config->has_seed){
+    house->seed = rand_derive_seed(config->seed, run_index);
+    rand_seed_thread(house->seed);
+  }
+
+  ghost_init(&house->ghost, house);
+
+  for(int i = 0; i < roster->count; i++){
+    house_add_hunter(house, roster->entries[i].name, roster->entries[i].id);
+  }
+
+  return true;
+}
+
+/*
+   Function: simulation_resume
+   Purpose:  Loads a hunt saved by a checkpoint in place of simulation_setup.
+   Entity behaviour comes from the file; how it is run comes from config.
+   Params:
+    Output: struct House* house - the house to restore (cleaned up by house_cleanup)
+    Input: const struct SimConfig* config - monitor and checkpoint options
+   Return: bool - false if the checkpoint could not be loaded
+*/
+bool simulation_resume(struct House* house, const struct SimConfig* config){
+  if(!checkpoint_load(house, config->resume_path)){
+    return false;
+  }
+  simulation_runtime_params(&house->params, config);
+  return true;
+}
+
+/*
+   Function: simulation_run_lockstep
+   Purpose:  Runs the hunt on the calling thread in rounds: the ghost steps,
+   then every hunter in roster order, each drawing from its own RNG stream.
+   Nothing depends on timing, so a seed (or a checkpoint) fixes the whole
+   hunt. Saves the configured checkpoint between rounds.
+   Params:
+    Input/Output: struct House* house - a set-up or resumed house
+   Return: void
+*/
+static void simulation_run_lockstep(struct House* house){
+  const struct SimParams* params = &house->params;
+  trace_thread_begin(0, "lockstep", NULL);
+
+  while(true){
+    if(params->checkpoint_path != NULL && house->round == params->checkpoint_round){
+      checkpoint_save(house, params->checkpoint_path);
+    }
+
+    bool active = !house->ghost.has_exited;
+    for(int i = 0; i < house->hunter_count && !active; i++){
+      active = !house->hunters[i].should_exit;
+    }
+    if(!active){
+      break;
+    }
+
+    rand_bind_thread(&house->ghost.rng_state);
+    ghost_step(&house->ghost);
+    for(int i = 0; i < house->hunter_count; i++){
+      rand_bind_thread(&house->hunters[i].rng_state);
+      hunter_step(&house->hunters[i]);
+    }
+    house->round++;
+  }
+
+  //the threaded loops flush their leftover steps as they exit
+  metrics_add_steps(house->ghost.stats.iterations % METRICS_STEP_BATCH);
+  for(int i = 0; i < house->hunter_count; i++){
+    metrics_add_steps(house->hunters[i].stats.iterations % METRICS_STEP_BATCH);
+  }
+  rand_bind_thread(NULL);
+}
+
+/*
+   Function: simulation_run
+   Purpose:  Starts the ghost thread and one thread per hunter, then waits
+   for all of them. Hunter threads get a small stack so large rosters fit.
+   With the lockstep schedule the calling thread runs the hunt instead.
+   Params:
+    Input/Output: struct House* house - a house prepared by simulation_setup
+   Return: void
+*/
+void simulation_run(struct House* house){
+  if(house->params.schedule == SCHEDULE_LOCKSTEP){
+    struct Monitor monitor;
+    monitor.running = false;
+    if(house->params.monitor && !monitor_start(&monitor, house)){
+      fprintf(stderr, "Could not start the monitor thread\n");
+    }
+    simulation_run_lockstep(house);
+    monitor_stop(&monitor);
+    return;
+  }
+
+  pthread_t ghost_thread_id;
+  pthread_t* hunter_threads = malloc((size_t)house->hunter_count * sizeof(pthread_t));
+  bool* started = calloc((size_t)house->hunter_count, sizeof(bool));
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, HUNTER_THREAD_STACK);
+
+  //Create ghost thread
+  int entities = house->hunter_count + 1;
+  pthread_attr_t ghost_attr;
+  pthread_attr_init(&ghost_attr);
+  affinity_apply(&ghost_attr, 0, entities);
+  bool ghost_started = pthread_create(&ghost_thread_id, &ghost_attr, ghost_thread, &house->ghost) == 0;
+  pthread_attr_destroy(&ghost_attr);
+  if(!ghost_started){
+    fprintf(stderr, "Could not start the ghost thread\n");
+  }
+
+  //Create one thread for each hunter
+  int failed = 0;
+  for(int i = 0; i < house->hunter_count; i++){
+    affinity_apply(&attr, i + 1, entities);
+    started[i] = pthread_create(&hunter_threads[i], &attr, hunter_thread, &house->hunters[i]) == 0;
+    if(!started[i]){
+      failed++;
+    }
+  }
+  pthread_attr_destroy(&attr);
+
+  //hunters past the system thread limit simply never enter the house
+  if(failed > 0){
+    fprintf(stderr, "Could not start %d of %d hunter threads\n", failed, house->hunter_count);
+  }
+
+  //watch from the side; the monitor never takes a lock the hunt waits on
+  struct Monitor monitor;
+  monitor.running = false;
+  if(house->params.monitor && !monitor_start(&monitor, house)){
+    fprintf(stderr, "Could not start the monitor thread\n");
+  }
+
+  //wait for all threads to complete
+  if(ghost_started){
+    pthread_join(ghost_thread_id, NULL);
+  }
+  for(int i = 0; i < house->hunter_count; i++){
+    if(started[i]){
+      pthread_join(hunter_threads[i], NULL);
+    }
+  }
+
+  monitor_stop(&monitor);
+
+  free(started);
+  free(hunter_threads);
+}
+
+/*
+   Function: simulation_clock_us
+   Purpose:  Reads the monotonic clock, used to time each hunt.
+   Return: double - microseconds from an arbitrary origin
+*/
+double simulation_clock_us(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1000000.0 + (double)ts.tv_nsec / 1000.0;
+}
+
+//Shared by the batch workers; each keeps its own partial totals
+struct BatchWorker {
+  const struct SimConfig* config;
+  const struct Roster* roster;
+  int* next_run;               //claimed with an atomic add
+  int slot;                    //worker index, its slot in the metrics region
+  struct Aggregate agg;
+  struct SimStats stats;
+  bool failed;
+};
+
+/*
+   Function: batch_worker
+   Purpose:  Claims run indices until all runs are taken, running each hunt
+   and folding it into the worker's own aggregate and counters.
+   Params:
+    Input/Output: void* data - the worker's struct BatchWorker
+   Return: void* - NULL
+*/
+static void* batch_worker(void* data){
+  struct BatchWorker* worker = (struct BatchWorker*)data;
+  //set up and run every hunt from the worker's own domain
+  affinity_bind_worker(worker->slot);
+
+  while(true){
+    int run = __atomic_fetch_add(worker->next_run, 1, __ATOMIC_RELAXED);
+    if(run >= worker->config->runs){
+      break;
+    }
+
+    struct House house;
+    if(!simulation_setup(&house, worker->config, worker->roster, run)){
+      house_cleanup(&house);
+      worker->failed = true;
+      break;
+    }
+
+    double start = simulation_clock_us();
+    simulation_run(&house);
+    aggregate_add_run(&worker->agg, &house, simulation_clock_us() - start);
+
+    struct SimStats run_stats;
+    stats_init(&run_stats);
+    stats_collect(&run_stats, &house);
+    stats_merge(&worker->stats, &run_stats);
+    metrics_run_done(worker->slot, house.caseFile.solved,
+                     run_stats.hunter.iterations + run_stats.ghost.iterations);
+
+    house_cleanup(&house);
+  }
+  return NULL;
+}
+
+/*
+   Function: simulation_run_batch
+   Purpose:  Runs config->runs hunts on config->jobs worker threads. Workers
+   never share their partial aggregates; they are merged once all have joined.
+   Params:
+    Input: const struct SimConfig* config - options, including runs and jobs
+    Input: const struct Roster* roster - the hunters for every run
+    Input/Output: struct Aggregate* agg - merged outcomes are added here
+    Input/Output: struct SimStats* totals - merged step counters are added here
+   Return: bool - false if any run could not be set up
+*/
+bool simulation_run_batch(const struct SimConfig* config, const struct Roster* roster,
+                          struct Aggregate* agg, struct SimStats* totals){
+  int jobs = config->jobs < config->runs ? config->jobs : config->runs;
+  struct BatchWorker* workers = calloc((size_t)jobs, sizeof(struct BatchWorker));
+  pthread_t* threads = malloc((size_t)jobs * sizeof(pthread_t));
+  bool* started = calloc((size_t)jobs, sizeof(bool));
+  int next_run = 0;
+  bool ok = true;
+
+  for(int i = 0; i < jobs; i++){
+    workers[i].config = config;
+    workers[i].roster = roster;
+    workers[i].next_run = &next_run;
+    workers[i].slot = i;
+    aggregate_init(&workers[i].agg);
+    stats_init(&workers[i].stats);
+    started[i] = pthread_create(&threads[i], NULL, batch_worker, &workers[i]) == 0;
+  }
+
+  //a worker that could not start just leaves its share to the others
+  for(int i = 0; i < jobs; i++){
+    if(!started[i]){
+      continue;
+    }
+    pthread_join(threads[i], NULL);
+    aggregate_merge(agg, &workers[i].agg);
+    stats_merge(totals, &workers[i].stats);
+    if(workers[i].failed){
+      ok = false;
+    }
+  }
+
+  if(agg->runs == 0 && ok){
+    fprintf(stderr, "Could not start any batch worker\n");
+    ok = false;
+  }
+
+  free(started);
+  free(threads);
+  free(workers);
+  return ok;
+}
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <string.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+   Function: stats_init
+   Purpose:  Zeroes a set of totals.
+   Params:
+    Output: struct SimStats* stats - the totals to clear
+   Return: void
+*/
+void stats_init(struct SimStats* stats){
+  memset(stats, 0, sizeof(*stats));
+}
+
+/*
+   Function: hunter_stats_add
+   Purpose:  Adds one hunter's counters into a running total.
+   Params:
+    Input/Output: struct HunterStats* into - the total
+    Input: const struct HunterStats* from - the counters to add
+   Return: void
+*/
+static void hunter_stats_add(struct HunterStats* into, const struct HunterStats* from){
+  into->iterations += from->iterations;
+  into->moves += from->moves;
+  into->moves_full += from->moves_full;
+  into->evidence += from->evidence;
+  into->van_returns += from->van_returns;
+  into->device_swaps += from->device_swaps;
+}
+
+/*
+   Function: ghost_stats_add
+   Purpose:  Adds the ghost's counters into a running total.
+   Params:
+    Input/Output: struct GhostStats* into - the total
+    Input: const struct GhostStats* from - the counters to add
+   Return: void
+*/
+static void ghost_stats_add(struct GhostStats* into, const struct GhostStats* from){
+  into->iterations += from->iterations;
+  into->idles += from->idles;
+  into->haunts += from->haunts;
+  into->moves += from->moves;
+  into->moves_blocked += from->moves_blocked;
+}
+
+/*
+   Function: stats_collect
+   Purpose:  Adds every entity's counters from a finished run. Must only be
+   called after all of the run's threads have been joined.
+   Params:
+    Input/Output: struct SimStats* stats - the totals to add to
+    Input: const struct House* house - the finished run
+   Return: void
+*/
+void stats_collect(struct SimStats* stats, const struct House* house){
+  stats->runs++;
+  stats->hunters += (unsigned long)house->hunter_count;
+  if(house->caseFile.solved){
+    stats->solved++;
+  }
+
+  for(int i = 0; i < house->hunter_count; i++){
+    hunter_stats_add(&stats->hunter, &house->hunters[i].stats);
+  }
+  ghost_stats_add(&stats->ghost, &house->ghost.stats);
+}
+
+/*
+   Function: stats_merge
+   Purpose:  Adds one set of totals into another.
+   Params:
+    Input/Output: struct SimStats* into - the totals to add to
+    Input: const struct SimStats* from - the totals to add
+   Return: void
+*/
+void stats_merge(struct SimStats* into, const struct SimStats* from){
+  into->runs += from->runs;
+  into->hunters += from->hunters;
+  into->solved += from->solved;
+  hunter_stats_add(&into->hunter, &from->hunter);
+  ghost_stats_add(&into->ghost, &from->ghost);
+}
+
+/*
+   Function: stats_print
+   Purpose:  Prints the totals as an indented block or as one JSON object per line.
+   Params:
+    Input: const struct SimStats* stats - the totals to print
+    Input: enum StatsFormat format - STATS_TEXT, STATS_JSON or STATS_NONE
+    Input: const char* label - what the totals cover, e.g. "run 3" or "all runs"
+   Return: void
+*/
+void stats_print(const struct SimStats* stats, enum StatsFormat format, const char* label){
+  const struct HunterStats* h = &stats->hunter;
+  const struct GhostStats* g = &stats->ghost;
+
+  if(format == STATS_JSON){
+    printf("{\"stats\": \"%s\", \"runs\": %lu, \"hunters\": %lu, \"solved\": %lu, "
+	   "\"hunter\": {\"iterations\": %lu, \"moves\": %lu, \"moves_full\": %lu, \"evidence\": %lu, "
+	   "\"van_returns\": %lu, \"device_swaps\": %lu}, "
+	   "\"ghost\": {\"iterations\": %lu, \"idles\": %lu, \"haunts\": %lu, \"moves\": %lu, "
+	   "\"moves_blocked\": %lu}}\n",
+	   label, stats->runs, stats->hunters, stats->solved,
+	   h->iterations, h->moves, h->moves_full, h->evidence, h->van_returns, h->device_swaps,
+	   g->iterations, g->idles, g->haunts, g->moves, g->moves_blocked);
+  }else if(format == STATS_TEXT){
+    printf("\nStep Counters (%s):\n", label);
+    printf("  Hunters: %lu iterations, %lu moves, %lu blocked by full rooms\n",
+	   h->iterations, h->moves, h->moves_full);
+    printf("           %lu evidence, %lu van returns, %lu device swaps\n",
+	   h->evidence, h->van_returns, h->device_swaps);
+    printf("  Ghost:   %lu iterations, %lu idle, %lu haunt, %lu move, %lu blocked\n",
+	   g->iterations, g->idles, g->haunts, g->moves, g->moves_blocked);
+    if(stats->runs > 1){
+      printf("  Solved:  %lu of %lu runs\n", stats->solved, stats->runs);
+    }
+  }
+}
@@ -0,0 +1,607 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+  Parameter sweep driver. Each axis (layout, hunter count, boredom limit,
+  fear limit, room occupancy, return chance, exploration) takes a list of values, where a numeric item
+  may be a range lo:hi or lo:hi:step. The cells are either the full grid
+  of every combination or a Latin hypercube sample of --lhs N cells: each
+  axis is cut into N equal strata and every stratum is used exactly once,
+  so N cells cover every axis evenly however many axes there are.
+
+  Every cell runs --runs hunts through simulation_run_batch on --jobs
+  worker threads (all online CPUs by default) with the same base seed, so
+  cells differ only in their parameters. A row is appended to the results
+  CSV and synced as soon as its cell finishes. Started again with the same
+  spec, the sweep reads the rows already there and skips those cells, so
+  an interrupted sweep loses at most the cell it was running.
+*/
+
+#define SWEEP_MAX_VALUES 100000
+#define SWEEP_KEY_LENGTH 192
+#define SWEEP_KEY_COLUMNS 11
+
+enum SweepAxis {
+  SA_LAYOUT, SA_HUNTERS, SA_BOREDOM, SA_FEAR, SA_OCCUPANCY, SA_RETURN, SA_EXPLORE, SA_COUNT
+};
+
+static const char* sweep_axis_names[SA_COUNT] = {
+  "layout", "hunters", "boredom_max", "fear_max", "occupancy", "return_chance", "explore"
+};
+
+static const char* sweep_header =
+  "layout,hunters,boredom_max,fear_max,occupancy,return_chance,explore,ghost_weights,runs,seed,schedule,"
+  "solved,solve_rate,exits_evidence,exits_bored,exits_afraid,"
+  "duration_mean_us,duration_p50_us,duration_p90_us,steps_to_solve_mean,steps_to_solve_p50,wall_s";
+
+//The values one axis takes; layouts and explore modes are kept as names, the rest as numbers
+struct SweepValues {
+  int* numbers;
+  char (*names)[MAX_LAYOUT_NAME];
+  int count;
+};
+
+//One point of the sweep
+struct SweepCell {
+  char layout[MAX_LAYOUT_NAME];
+  int hunters;
+  int boredom_max;
+  int fear_max;
+  int occupancy;
+  int return_chance;
+  enum ExploreMode explore;
+};
+
+struct SweepOptions {
+  struct SweepValues axes[SA_COUNT];
+  int runs;
+  unsigned seed;
+  int jobs;
+  enum Schedule schedule;
+  int ghost_weights[3];    //fixed for the whole sweep
+  int lhs;                 //sample this many cells, 0 for the full grid
+  unsigned sample_seed;
+  const char* out;
+};
+
+static double now_seconds(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/*
+   Function: sweep_random
+   Purpose:  xorshift32 step for the hypercube sample; kept apart from the
+   simulation's streams so the same spec always yields the same cells.
+   Params:
+    Input/Output: unsigned* state - the generator state, never 0
+   Return: unsigned - the next value
+*/
+static unsigned sweep_random(unsigned* state){
+  unsigned x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+/*
+   Function: values_add_number
+   Purpose:  Appends a number to an axis.
+   Params:
+    Input/Output: struct SweepValues* values - the axis
+    Input: int number - the value
+   Return: bool - false if the axis is full
+*/
+static bool values_add_number(struct SweepValues* values, int number){
+  if(values->count >= SWEEP_MAX_VALUES){
+    return false;
+  }
+  int* numbers = realloc(values->numbers, (size_t)(values->count + 1) * sizeof(int));
+  if(numbers == NULL){
+    return false;
+  }
+  values->numbers = numbers;
+  values->numbers[values->count++] = number;
+  return true;
+}
+
+/*
+   Function: parse_axis
+   Purpose:  Replaces an axis with a comma separated list. Numeric items
+   are N, lo:hi or lo:hi:step; layout and explore items are names.
+   Params:
+    Output: struct SweepValues* values - the axis
+    Input: const char* text - the list
+    Input: bool names - true for the layout and explore axes
+    Input: int minimum - smallest number allowed
+    Input: int maximum - largest number allowed
+   Return: bool - false if an item is malformed or out of bounds
+*/
+static bool parse_axis(struct SweepValues* values, const char* text, bool names, int minimum, int maximum){
+  free(values->numbers);
+  free(values->names);
+  memset(values, 0, sizeof(*values));
+
+  const char* p = text;
+  while(*p != '\0'){
+    const char* comma = strchr(p, ',');
+    size_t length = comma ? (size_t)(comma - p) : strlen(p);
+    char item[MAX_LAYOUT_NAME];
+    if(length == 0 || length >= MAX_LAYOUT_NAME){
+      return false;
+    }
+    memcpy(item, p, length);
+    item[length] = '\0';
+    p += length + (comma != NULL);
+
+    if(names){
+      char (*grown)[MAX_LAYOUT_NAME] = realloc(values->names, (size_t)(values->count + 1) * MAX_LAYOUT_NAME);
+      if(grown == NULL || values->count >= SWEEP_MAX_VALUES){
+        return false;
+      }
+      values->names = grown;
+      strcpy(values->names[values->count++], item);
+      continue;
+    }
+
+    long low = 0;
+    long high = 0;
+    long step = 1;
+    char extra = '\0';
+    int fields = sscanf(item, "%ld:%ld:%ld%c", &low, &high, &step, &extra);
+    if(fields == 1){
+      high = low;
+    }else if(fields != 2 && fields != 3){
+      return false;
+    }
+    if(step < 1 || low > high || low < minimum || high > maximum){
+      return false;
+    }
+    for(long v = low; v <= high; v += step){
+      if(!values_add_number(values, (int)v)){
+        return false;
+      }
+    }
+  }
+  return values->count > 0;
+}
+
+/*
+   Function: cell_from_indices
+   Purpose:  Builds a cell from one value index per axis.
+   Params:
+    Input: const struct SweepOptions* options - the axes
+    Input: const int* index - SA_COUNT value indices
+    Output: struct SweepCell* cell - the cell
+   Return: void
+*/
+static void cell_from_indices(const struct SweepOptions* options, const int* index, struct SweepCell* cell){
+  strcpy(cell->layout, options->axes[SA_LAYOUT].names[index[SA_LAYOUT]]);
+  cell->hunters = options->axes[SA_HUNTERS].numbers[index[SA_HUNTERS]];
+  cell->boredom_max = options->axes[SA_BOREDOM].numbers[index[SA_BOREDOM]];
+  cell->fear_max = options->axes[SA_FEAR].numbers[index[SA_FEAR]];
+  cell->occupancy = options->axes[SA_OCCUPANCY].numbers[index[SA_OCCUPANCY]];
+  cell->return_chance = options->axes[SA_RETURN].numbers[index[SA_RETURN]];
+  cell->explore = strcmp(options->axes[SA_EXPLORE].names[index[SA_EXPLORE]], "coordinated") == 0
+    ? EXPLORE_COORDINATED : EXPLORE_RANDOM;
+}
+
+/*
+   Function: build_cells
+   Purpose:  Lists every cell of the sweep: the full grid, layout varying
+   slowest, or the Latin hypercube sample.
+   Params:
+    Input: const struct SweepOptions* options - the axes and sampling
+    Output: int* count - the number of cells
+   Return: struct SweepCell* - the cells (free with free), NULL if too many or out of memory
+*/
+static struct SweepCell* build_cells(const struct SweepOptions* options, int* count){
+  long long total = 1;
+  for(int a = 0; a < SA_COUNT; a++){
+    total *= options->axes[a].count;
+    if(total > SWEEP_MAX_VALUES){
+      break;
+    }
+  }
+  if(options->lhs > 0){
+    total = options->lhs;
+  }
+  if(total > SWEEP_MAX_VALUES){
+    fprintf(stderr, "The grid has more than %d cells; narrow it or sample it with --lhs N\n", SWEEP_MAX_VALUES);
+    return NULL;
+  }
+
+  struct SweepCell* cells = calloc((size_t)total, sizeof(struct SweepCell));
+  int* strata = malloc((size_t)total * SA_COUNT * sizeof(int));
+  if(cells == NULL || strata == NULL){
+    free(cells);
+    free(strata);
+    return NULL;
+  }
+
+  if(options->lhs == 0){
+    for(long long c = 0; c < total; c++){
+      int index[SA_COUNT];
+      long long rest = c;
+      for(int a = SA_COUNT - 1; a >= 0; a--){
+        index[a] = (int)(rest % options->axes[a].count);
+        rest /= options->axes[a].count;
+      }
+      cell_from_indices(options, index, &cells[c]);
+    }
+  }else{
+    //one shuffled list of strata per axis; cell i takes stratum strata[a][i]
+    unsigned state = options->sample_seed != 0 ? options->sample_seed : 0x9E3779B9u;
+    int n = (int)total;
+    for(int a = 0; a < SA_COUNT; a++){
+      int* column = strata + (size_t)a * n;
+      for(int i = 0; i < n; i++){
+        column[i] = i;
+      }
+      for(int i = n - 1; i > 0; i--){
+        int j = (int)(sweep_random(&state) % (unsigned)(i + 1));
+        int swap = column[i];
+        column[i] = column[j];
+        column[j] = swap;
+      }
+    }
+    for(int i = 0; i < n; i++){
+      int index[SA_COUNT];
+      for(int a = 0; a < SA_COUNT; a++){
+        //a uniform point inside the stratum, mapped onto the axis values
+        double u = (sweep_random(&state) & 0xFFFFFF) / (double)0x1000000;
+        double position = (strata[(size_t)a * n + i] + u) / n;
+        index[a] = (int)(position * options->axes[a].count);
+        if(index[a] >= options->axes[a].count){
+          index[a] = options->axes[a].count - 1;
+        }
+      }
+      cell_from_indices(options, index, &cells[i]);
+    }
+  }
+
+  free(strata);
+  *count = (int)total;
+  return cells;
+}
+
+/*
+   Function: cell_key
+   Purpose:  Writes the columns that identify a finished cell: its
+   parameters plus the ghost weights, run count, seed and schedule it was
+   run with.
+   Params:
+    Input: const struct SweepOptions* options - runs, seed and schedule
+    Input: const struct SweepCell* cell - the cell
+    Output: char* key - at least SWEEP_KEY_LENGTH bytes
+   Return: void
+*/
+static void cell_key(const struct SweepOptions* options, const struct SweepCell* cell, char* key){
+  snprintf(key, SWEEP_KEY_LENGTH, "%s,%d,%d,%d,%d,%d,%s,%d:%d:%d,%d,%u,%s", cell->layout, cell->hunters,
+           cell->boredom_max, cell->fear_max, cell->occupancy, cell->return_chance,
+           cell->explore == EXPLORE_COORDINATED ? "coordinated" : "random",
+           options->ghost_weights[0], options->ghost_weights[1], options->ghost_weights[2],
+           options->runs, options->seed,
+           options->schedule == SCHEDULE_LOCKSTEP ? "lockstep" : "threads");
+}
+
+static int compare_keys(const void* a, const void* b){
+  return strcmp((const char*)a, (const char*)b);
+}
+
+/*
+   Function: load_done
+   Purpose:  Reads the keys of the rows an earlier sweep already wrote. A
+   last line cut short by an interruption is dropped from the file.
+   Params:
+    Input: const char* path - the results file
+    Output: char (**keys)[SWEEP_KEY_LENGTH] - sorted keys (free with free)
+    Output: int* count - how many
+   Return: bool - false if the file exists but is not a sweep table
+*/
+static bool load_done(const char* path, char (**keys)[SWEEP_KEY_LENGTH], int* count){
+  *keys = NULL;
+  *count = 0;
+  FILE* file = fopen(path, "r");
+  if(file == NULL){
+    return true;
+  }
+
+  char* line = NULL;
+  size_t capacity = 0;
+  ssize_t length = 0;
+  long complete = 0;       //bytes up to the end of the last whole line
+  bool header = false;
+  bool ok = true;
+  while((length = getline(&line, &capacity, file)) > 0){
+    if(line[length - 1] != '\n'){
+      break;
+    }
+    complete += length;
+    line[length - 1] = '\0';
+    if(!header){
+      header = true;
+      if(strcmp(line, sweep_header) != 0){
+        fprintf(stderr, "%s exists but is not a results table from this sweep driver\n", path);
+        ok = false;
+        break;
+      }
+      continue;
+    }
+
+    //the key is the leading columns, up to the schedule
+    char* cut = line;
+    for(int commas = 0; *cut != '\0'; cut++){
+      if(*cut == ',' && ++commas == SWEEP_KEY_COLUMNS){
+        break;
+      }
+    }
+    *cut = '\0';
+    char (*grown)[SWEEP_KEY_LENGTH] = realloc(*keys, (size_t)(*count + 1) * SWEEP_KEY_LENGTH);
+    if(grown == NULL){
+      ok = false;
+      break;
+    }
+    *keys = grown;
+    snprintf((*keys)[(*count)++], SWEEP_KEY_LENGTH, "%s", line);
+  }
+  free(line);
+  fclose(file);
+
+  if(ok){
+    struct stat info;
+    if(stat(path, &info) == 0 && info.st_size > complete && truncate(path, complete) != 0){
+      perror(path);
+      ok = false;
+    }
+    qsort(*keys, (size_t)*count, SWEEP_KEY_LENGTH, compare_keys);
+  }
+  return ok;
+}
+
+/*
+   Function: run_cell
+   Purpose:  Runs one cell's hunts and appends its row to the results.
+   Params:
+    Input: const struct SweepOptions* options - runs, seed, jobs, schedule
+    Input: const struct SweepCell* cell - the parameters
+    Input/Output: FILE* out - the results table, synced after the row
+    Output: struct Aggregate* agg - the cell's outcomes
+   Return: bool - false if a hunt could not be set up or the row not written
+*/
+static bool run_cell(const struct SweepOptions* options, const struct SweepCell* cell, FILE* out,
+                     struct Aggregate* agg){
+  struct SimConfig config;
+  config_init(&config);
+  strcpy(config.layout, cell->layout);
+  config.seed = options->seed;
+  config.has_seed = true;
+  config.runs = options->runs;
+  config.jobs = options->jobs;
+  config.schedule = options->schedule;
+  config.log_mode = LOG_MODE_NONE;
+  config.console = CONSOLE_SILENT;
+  config.boredom_max = cell->boredom_max;
+  config.fear_max = cell->fear_max;
+  config.occupancy = cell->occupancy;
+  config.return_chance = cell->return_chance;
+  config.explore_mode = cell->explore;
+  memcpy(config.ghost_weights, options->ghost_weights, sizeof(config.ghost_weights));
+
+  struct Roster roster;
+  roster_init(&roster);
+  if(!roster_generate(&roster, cell->hunters)){
+    return false;
+  }
+
+  struct SimStats stats;
+  aggregate_init(agg);
+  stats_init(&stats);
+  double start = now_seconds();
+  bool ok = simulation_run_batch(&config, &roster, agg, &stats);
+  double wall = now_seconds() - start;
+  roster_cleanup(&roster);
+  if(!ok){
+    return false;
+  }
+
+  char key[SWEEP_KEY_LENGTH];
+  cell_key(options, cell, key);
+  fprintf(out, "%s,%lu,%.4f,%lu,%lu,%lu,%.1f,%.0f,%.0f,%.1f,%.0f,%.3f\n", key, agg->solved,
+          agg->runs > 0 ? (double)agg->solved / (double)agg->runs : 0.0,
+          agg->exits[LR_EVIDENCE], agg->exits[LR_BORED], agg->exits[LR_AFRAID],
+          agg->duration_us.mean, aggregate_quantile(&agg->duration_sketch, 0.5),
+          aggregate_quantile(&agg->duration_sketch, 0.9), agg->steps_to_solve.mean,
+          aggregate_quantile(&agg->steps_sketch, 0.5), wall);
+  return fflush(out) == 0 && fsync(fileno(out)) == 0;
+}
+
+static void print_usage(const char* program){
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --layouts LIST     layouts (default willow)\n"
+          "  --hunters LIST     hunter counts (default 4)\n"
+          "  --boredom LIST     boredom limits (default %d)\n"
+          "  --fear LIST        fear limits (default %d)\n"
+          "  --occupancy LIST   hunters per room, 1-%d (default %d)\n"
+          "  --return-chance LIST  percent chance an empty search sends a hunter back (default %d)\n"
+          "  --explore LIST     random and/or coordinated exploration (default random)\n"
+          "  --ghost-weights I,H,M  ghost action odds for every cell (default 1,1,1)\n"
+          "  --lhs N            sample N cells by Latin hypercube instead of the full grid\n"
+          "  --sample-seed N    seed of the hypercube sample (default 1)\n"
+          "  --runs N           hunts per cell (default 100)\n"
+          "  --seed N           base seed shared by every cell (default 1)\n"
+          "  --jobs N           worker threads (default: every online CPU)\n"
+          "  --schedule MODE    threads (default) or lockstep\n"
+          "  --out FILE         results table, resumed if it exists (default sweep.csv)\n"
+          "Numeric lists take N, lo:hi or lo:hi:step items, e.g. --boredom 5:30:5,50\n",
+          program, ENTITY_BOREDOM_MAX, HUNTER_FEAR_MAX, MAX_ROOM_OCCUPANCY, MAX_ROOM_OCCUPANCY,
+          HUNTER_RETURN_CHANCE);
+}
+
+int main(int argc, char** argv){
+  struct SweepOptions options;
+  memset(&options, 0, sizeof(options));
+  options.runs = 100;
+  options.seed = 1;
+  options.sample_seed = 1;
+  options.schedule = SCHEDULE_THREADS;
+  options.out = "sweep.csv";
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  options.jobs = cpus > 0 ? (int)cpus : 1;
+
+  char defaults[SA_COUNT][16];
+  snprintf(defaults[SA_HUNTERS], sizeof(defaults[0]), "4");
+  snprintf(defaults[SA_BOREDOM], sizeof(defaults[0]), "%d", ENTITY_BOREDOM_MAX);
+  snprintf(defaults[SA_FEAR], sizeof(defaults[0]), "%d", HUNTER_FEAR_MAX);
+  snprintf(defaults[SA_OCCUPANCY], sizeof(defaults[0]), "%d", MAX_ROOM_OCCUPANCY);
+  snprintf(defaults[SA_RETURN], sizeof(defaults[0]), "%d", HUNTER_RETURN_CHANCE);
+  parse_axis(&options.axes[SA_LAYOUT], "willow", true, 0, 0);
+  parse_axis(&options.axes[SA_HUNTERS], defaults[SA_HUNTERS], false, 1, 100000);
+  parse_axis(&options.axes[SA_BOREDOM], defaults[SA_BOREDOM], false, 0, 1000000);
+  parse_axis(&options.axes[SA_FEAR], defaults[SA_FEAR], false, 0, 1000000);
+  parse_axis(&options.axes[SA_OCCUPANCY], defaults[SA_OCCUPANCY], false, 1, MAX_ROOM_OCCUPANCY);
+  parse_axis(&options.axes[SA_RETURN], defaults[SA_RETURN], false, 0, 100);
+  parse_axis(&options.axes[SA_EXPLORE], "random", true, 0, 0);
+  for(int i = 0; i < 3; i++){
+    options.ghost_weights[i] = GHOST_ACTION_WEIGHT;
+  }
+
+  for(int i = 1; i < argc; i++){
+    const char* arg = argv[i];
+    const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+    if(value == NULL){
+      print_usage(argv[0]);
+      return 1;
+    }
+    i++;
+
+    bool ok = true;
+    if(strcmp(arg, "--layouts") == 0){
+      ok = parse_axis(&options.axes[SA_LAYOUT], value, true, 0, 0);
+    }else if(strcmp(arg, "--hunters") == 0){
+      ok = parse_axis(&options.axes[SA_HUNTERS], value, false, 1, 100000);
+    }else if(strcmp(arg, "--boredom") == 0){
+      ok = parse_axis(&options.axes[SA_BOREDOM], value, false, 0, 1000000);
+    }else if(strcmp(arg, "--fear") == 0){
+      ok = parse_axis(&options.axes[SA_FEAR], value, false, 0, 1000000);
+    }else if(strcmp(arg, "--occupancy") == 0){
+      ok = parse_axis(&options.axes[SA_OCCUPANCY], value, false, 1, MAX_ROOM_OCCUPANCY);
+    }else if(strcmp(arg, "--return-chance") == 0){
+      ok = parse_axis(&options.axes[SA_RETURN], value, false, 0, 100);
+    }else if(strcmp(arg, "--explore") == 0){
+      ok = parse_axis(&options.axes[SA_EXPLORE], value, true, 0, 0);
+      struct SimConfig check;
+      config_init(&check);
+      for(int k = 0; ok && k < options.axes[SA_EXPLORE].count; k++){
+        ok = config_set(&check, "explore", options.axes[SA_EXPLORE].names[k]);
+      }
+    }else if(strcmp(arg, "--ghost-weights") == 0){
+      //checked the way ghost_sim checks it
+      struct SimConfig check;
+      config_init(&check);
+      ok = config_set(&check, "ghost-weights", value);
+      memcpy(options.ghost_weights, check.ghost_weights, sizeof(options.ghost_weights));
+    }else if(strcmp(arg, "--lhs") == 0){
+      options.lhs = atoi(value);
+      ok = options.lhs >= 1 && options.lhs <= SWEEP_MAX_VALUES;
+    }else if(strcmp(arg, "--sample-seed") == 0){
+      options.sample_seed = (unsigned)strtoul(value, NULL, 10);
+    }else if(strcmp(arg, "--runs") == 0){
+      options.runs = atoi(value);
+      ok = options.runs >= 1;
+    }else if(strcmp(arg, "--seed") == 0){
+      options.seed = (unsigned)strtoul(value, NULL, 10);
+    }else if(strcmp(arg, "--jobs") == 0){
+      options.jobs = atoi(value);
+      ok = options.jobs >= 1 && options.jobs <= 1024;
+    }else if(strcmp(arg, "--schedule") == 0){
+      ok = strcmp(value, "threads") == 0 || strcmp(value, "lockstep") == 0;
+      options.schedule = strcmp(value, "lockstep") == 0 ? SCHEDULE_LOCKSTEP : SCHEDULE_THREADS;
+    }else if(strcmp(arg, "--out") == 0){
+      options.out = value;
+    }else{
+      ok = false;
+    }
+    if(!ok){
+      fprintf(stderr, "Invalid value for %s: '%s'\n", arg, value);
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  int cell_count = 0;
+  struct SweepCell* cells = build_cells(&options, &cell_count);
+  if(cells == NULL){
+    return 1;
+  }
+
+  char (*done)[SWEEP_KEY_LENGTH] = NULL;
+  int done_count = 0;
+  if(!load_done(options.out, &done, &done_count)){
+    free(cells);
+    return 1;
+  }
+
+  FILE* out = fopen(options.out, "a");
+  if(out == NULL){
+    perror(options.out);
+    free(cells);
+    free(done);
+    return 1;
+  }
+  if(ftell(out) == 0){
+    fprintf(out, "%s\n", sweep_header);
+  }
+
+  //the hunts run silently; only the table and the progress lines remain
+  log_set_mode(LOG_MODE_NONE);
+  log_set_console(CONSOLE_SILENT);
+
+  int skipped = 0;
+  int failed = 0;
+  double start = now_seconds();
+  for(int i = 0; i < cell_count; i++){
+    char key[SWEEP_KEY_LENGTH];
+    cell_key(&options, &cells[i], key);
+    if(done_count > 0 && bsearch(key, done, (size_t)done_count, SWEEP_KEY_LENGTH, compare_keys) != NULL){
+      skipped++;
+      continue;
+    }
+
+    struct Aggregate agg;
+    if(!run_cell(&options, &cells[i], out, &agg)){
+      fprintf(stderr, "[%d/%d] %s failed\n", i + 1, cell_count, key);
+      failed++;
+      continue;
+    }
+    fprintf(stderr, "[%d/%d] %s=%s %s=%d %s=%d %s=%d %s=%d %s=%d %s=%s: solved %lu/%lu\n", i + 1, cell_count,
+            sweep_axis_names[SA_LAYOUT], cells[i].layout, sweep_axis_names[SA_HUNTERS], cells[i].hunters,
+            sweep_axis_names[SA_BOREDOM], cells[i].boredom_max, sweep_axis_names[SA_FEAR], cells[i].fear_max,
+            sweep_axis_names[SA_OCCUPANCY], cells[i].occupancy, sweep_axis_names[SA_RETURN],
+            cells[i].return_chance, sweep_axis_names[SA_EXPLORE],
+            cells[i].explore == EXPLORE_COORDINATED ? "coordinated" : "random",
+            agg.solved, agg.runs);
+  }
+  fclose(out);
+
+  fprintf(stderr, "%d cells: %d run, %d already in %s, %d failed, %.1f s\n", cell_count,
+          cell_count - skipped - failed, skipped, options.out, failed, now_seconds() - start);
+
+  for(int a = 0; a < SA_COUNT; a++){
+    free(options.axes[a].numbers);
+    free(options.axes[a].names);
+  }
+  free(cells);
+  free(done);
+  return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include "defs.h"
+
+/*
+  The heap behind every k-way merge of log streams. Each entity's log is
+  already in time order, so a global timeline only needs the head of each
+  stream: a binary min-heap holds one (timestamp, source) entry per stream,
+  the smallest is taken, and the stream's next timestamp replaces it.
+  That is O(log k) per record and O(k) memory however long the streams are.
+
+  Equal timestamps come out in source order, and one stream never passes
+  itself, so the merge is stable: ties keep the order the inputs were given in.
+*/
+
+/*
+   Function: timeline_before
+   Purpose:  Heap order: earlier timestamp first, then lower source.
+   Params:
+    Input: const struct TimelineEntry* a - one entry
+    Input: const struct TimelineEntry* b - another
+   Return: bool - true if a comes out before b
+*/
+static inline bool timeline_before(const struct TimelineEntry* a, const struct TimelineEntry* b){
+  return a->timestamp < b->timestamp || (a->timestamp == b->timestamp && a->source < b->source);
+}
+
+/*
+   Function: timeline_sift_down
+   Purpose:  Moves the entry at index down until both children come after it.
+   Params:
+    Input/Output: struct TimelineHeap* heap - the heap
+    Input: int index - the entry to move
+   Return: void
+*/
+static void timeline_sift_down(struct TimelineHeap* heap, int index){
+  struct TimelineEntry moving = heap->entries[index];
+  for(;;){
+    int child = 2 * index + 1;
+    if(child >= heap->count){
+      break;
+    }
+    if(child + 1 < heap->count && timeline_before(&heap->entries[child + 1], &heap->entries[child])){
+      child++;
+    }
+    if(!timeline_before(&heap->entries[child], &moving)){
+      break;
+    }
+    heap->entries[index] = heap->entries[child];
+    index = child;
+  }
+  heap->entries[index] = moving;
+}
+
+/*
+   Function: timeline_init
+   Purpose:  Allocates an empty heap for up to capacity streams.
+   Params:
+    Output: struct TimelineHeap* heap - the heap
+    Input: int capacity - the number of streams
+   Return: bool - false if the allocation failed
+*/
+bool timeline_init(struct TimelineHeap* heap, int capacity){
+  heap->count = 0;
+  heap->capacity = capacity;
+  heap->entries = malloc((size_t)(capacity > 0 ? capacity : 1) * sizeof(struct TimelineEntry));
+  return heap->entries != NULL;
+}
+
+/*
+   Function: timeline_push
+   Purpose:  Adds a stream's head to the heap.
+   Params:
+    Input/Output: struct TimelineHeap* heap - the heap, not full
+    Input: long long timestamp - the head's timestamp
+    Input: int source - the stream
+   Return: void
+*/
+void timeline_push(struct TimelineHeap* heap, long long timestamp, int source){
+  if(heap->count >= heap->capacity){
+    return;
+  }
+  struct TimelineEntry entry = { timestamp, source };
+  int index = heap->count++;
+  while(index > 0){
+    int parent = (index - 1) / 2;
+    if(!timeline_before(&entry, &heap->entries[parent])){
+      break;
+    }
+    heap->entries[index] = heap->entries[parent];
+    index = parent;
+  }
+  heap->entries[index] = entry;
+}
+
+/*
+   Function: timeline_next
+   Purpose:  Says which stream holds the earliest record.
+   Params:
+    Input: const struct TimelineHeap* heap - the heap
+   Return: int - that stream, -1 when every stream is done
+*/
+int timeline_next(const struct TimelineHeap* heap){
+  return heap->count > 0 ? heap->entries[0].source : -1;
+}
+
+/*
+   Function: timeline_advance
+   Purpose:  Replaces the earliest stream's head after its record was used:
+   with its next timestamp, or removes the stream when it is done. One sift
+   instead of a pop and a push.
+   Params:
+    Input/Output: struct TimelineHeap* heap - the heap, not empty
+    Input: bool more - false if the stream has no records left
+    Input: long long timestamp - the stream's next timestamp when more is true
+   Return: void
+*/
+void timeline_advance(struct TimelineHeap* heap, bool more, long long timestamp){
+  if(heap->count == 0){
+    return;
+  }
+  if(more){
+    heap->entries[0].timestamp = timestamp;
+  }else{
+    heap->entries[0] = heap->entries[--heap->count];
+  }
+  if(heap->count > 0){
+    timeline_sift_down(heap, 0);
+  }
+}
+
+/*
+   Function: timeline_free
+   Purpose:  Releases the heap's storage.
+   Params:
+    Input/Output: struct TimelineHeap* heap - the heap
+   Return: void
+*/
+void timeline_free(struct TimelineHeap* heap){
+  free(heap->entries);
+  heap->entries = NULL;
+  heap->count = 0;
+  heap->capacity = 0;
+}
@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "defs.h"
+#include "helpers.h"
+
+/*
+  Optional timeline tracing in the Chrome trace-event JSON format, which
+  Perfetto (ui.perfetto.dev) and chrome://tracing both load. Every entity
+  thread appends to its own buffer, so recording an event is a clock read
+  and an array store; the buffers are only shared when trace_write() runs
+  after all threads have been joined.
+*/
+
+//One recorded slice ('X') or instant ('i')
+struct TraceEvent {
+  const char* name;
+  long long start_ns;
+  long long duration_ns;
+  char phase;
+};
+
+//Events from one entity thread, kept on a list until trace_write
+struct TraceBuffer {
+  int tid;
+  char label[MAX_HUNTER_NAME + 16];
+  struct TraceEvent* events;
+  size_t count;
+  size_t capacity;
+  struct TraceBuffer* next;
+};
+
+static bool trace_enabled = false;
+
+static char trace_path[MAX_PATH_LENGTH];
+static long long trace_origin_ns;
+static struct TraceBuffer* trace_buffers = NULL;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local struct TraceBuffer* trace_current = NULL;
+
+/*
+   Function: trace_clock
+   Purpose:  Reads the monotonic clock relative to when tracing started.
+   Return: long long - nanoseconds since trace_enable
+*/
+static long long trace_clock(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec - trace_origin_ns;
+}
+
+/*
+   Function: trace_enable
+   Purpose:  Turns tracing on. Must be called before any entity thread starts.
+   Params:
+    Input: const char* path - where trace_write puts the JSON
+   Return: void
+*/
+void trace_enable(const char* path){
+  strncpy(trace_path, path, MAX_PATH_LENGTH - 1);
+  trace_path[MAX_PATH_LENGTH - 1] = '\0';
+  trace_origin_ns = 0;
+  trace_origin_ns = trace_clock();
+  trace_enabled = true;
+}
+
+/*
+   Function: trace_thread_begin
+   Purpose:  Gives the calling thread its own buffer and track. Does nothing
+   when tracing is off.
+   Params:
+    Input: int tid - track id, the entity id
+    Input: const char* kind - "hunter" or "ghost"
+    Input: const char* name - entity name shown on the track (may be NULL)
+   Return: void
+*/
+void trace_thread_begin(int tid, const char* kind, const char* name){
+  if(!trace_enabled){
+    return;
+  }
+
+  struct TraceBuffer* buffer = calloc(1, sizeof(struct TraceBuffer));
+  if(buffer == NULL){
+    return;
+  }
+  buffer->tid = tid;
+  if(name != NULL){
+    snprintf(buffer->label, sizeof(buffer->label), "%s %d (%s)", kind, tid, name);
+  }else{
+    snprintf(buffer->label, sizeof(buffer->label), "%s %d", kind, tid);
+  }
+  //the label goes straight into a JSON string
+  for(char* c = buffer->label; *c != '\0'; c++){
+    if(*c == '"' || *c == '\\' || (unsigned char)*c < 0x20){
+      *c = '_';
+    }
+  }
+
+  pthread_mutex_lock(&trace_lock);
+  buffer->next = trace_buffers;
+  trace_buffers = buffer;
+  pthread_mutex_unlock(&trace_lock);
+
+  trace_current = buffer;
+}
+
+/*
+   Function: trace_push
+   Purpose:  Appends an event to the calling thread's buffer, growing it by doubling.
+   Params:
+    Input: const char* name - static event name
+    Input: char phase - 'X' for a slice, 'i' for an instant
+    Input: long long start_ns - start time
+    Input: long long duration_ns - slice length (0 for instants)
+   Return: void
+*/
+static void trace_push(const char* name, char phase, long long start_ns, long long duration_ns){
+  struct TraceBuffer* buffer = trace_current;
+  if(buffer == NULL){
+    return;
+  }
+
+  if(buffer->count == buffer->capacity){
+    size_t capacity = buffer->capacity ? buffer->capacity * 2 : 1024;
+    struct TraceEvent* events = realloc(buffer->events, capacity * sizeof(struct TraceEvent));
+    if(events == NULL){
+      return;
+    }
+    buffer->events = events;
+    buffer->capacity = capacity;
+  }
+
+  struct TraceEvent* event = &buffer->events[buffer->count++];
+  event->name = name;
+  event->phase = phase;
+  event->start_ns = start_ns;
+  event->duration_ns = duration_ns;
+}
+
+/*
+   Function: trace_begin
+   Purpose:  Starts a slice; pass the result to trace_end.
+   Return: long long - start time, or 0 when tracing is off
+*/
+long long trace_begin(void){
+  if(!trace_enabled){
+    return 0;
+  }
+  return trace_clock();
+}
+
+/*
+   Function: trace_end
+   Purpose:  Records a slice from trace_begin until now.
+   Params:
+    Input: const char* name - static slice name
+    Input: long long start_ns - value returned by trace_begin
+   Return: void
+*/
+void trace_end(const char* name, long long start_ns){
+  if(!trace_enabled){
+    return;
+  }
+  trace_push(name, 'X', start_ns, trace_clock() - start_ns);
+}
+
+/*
+   Function: trace_instant
+   Purpose:  Records a point event on the calling thread's track.
+   Params:
+    Input: const char* name - static event name
+   Return: void
+*/
+void trace_instant(const char* name){
+  if(!trace_enabled){
+    return;
+  }
+  trace_push(name, 'i', trace_clock(), 0);
+}
+
+/*
+   Function: trace_write
+   Purpose:  Writes every buffer to the trace file and frees them. Call only
+   after all traced threads have been joined.
+   Return: bool - false if the file could not be written
+*/
+bool trace_write(void){
+  if(!trace_enabled){
+    return true;
+  }
+
+  FILE* file = fopen(trace_path, "w");
+  if(file == NULL){
+    perror(trace_path);
+  }
+
+  pthread_mutex_lock(&trace_lock);
+  struct TraceBuffer* buffer = trace_buffers;
+  trace_buffers = NULL;
+  pthread_mutex_unlock(&trace_lock);
+
+  if(file != NULL){
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(file, "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"ghost_sim\"}}");
+  }
+
+  while(buffer != NULL){
+    struct TraceBuffer* next = buffer->next;
+
+    if(file != NULL){
+      //one named track per entity thread; the ghost sorts first
+      fprintf(file, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+	      buffer->tid, buffer->label);
+      fprintf(file, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_sort_index\",\"args\":{\"sort_index\":%d}}",
+	      buffer->tid, buffer->tid == DEFAULT_GHOST_ID ? -1 : buffer->tid);
+
+      for(size_t i = 0; i < buffer->count; i++){
+	const struct TraceEvent* event = &buffer->events[i];
+	if(event->phase == 'X'){
+	  fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f}",
+		  buffer->tid, event->name, event->start_ns / 1000.0, event->duration_ns / 1000.0);
+	}else{
+	  fprintf(file, ",\n{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"name\":\"%s\",\"ts\":%.3f}",
+		  buffer->tid, event->name, event->start_ns / 1000.0);
+	}
+      }
+    }
+
+    free(buffer->events);
+    free(buffer);
+    buffer = next;
+  }
+
+  if(file == NULL){
+    return false;
+  }
+  fprintf(file, "\n]}\n");
+  fclose(file);
+  return true;
+}